@@ -0,0 +1,59 @@
+/**
+ * Replays recorded motor current traces through the stall detector of the firmware, so the
+ * stall current, the stall time and the inrush blanking can be tuned on a host. The traces are
+ * the CT lines printed with CONFIG_MOTOR_CURRENT_TRACE.
+ *
+ *   ./current_replay monitor.log <threshold raw> <stall blocks> <blanking blocks>
+ */
+#include <cstdio>
+#include <cstdlib>
+
+#include "stall_detector.h"
+#include "trace_replay.h"
+
+// Must match the firmware, see current_sense.h
+static constexpr uint32_t BLOCK_PERIOD_US = 4000;
+static constexpr uint8_t FILTER_SHIFT = 2;
+
+class CurrentReplay {
+ public:
+  explicit CurrentReplay(const StallConfig& cfg) : detector(cfg) {}
+
+  void start(uint32_t, int32_t) { detector.reset(); }
+
+  bool feed(uint32_t, int32_t blockMean) { return detector.feed(blockMean); }
+
+  void report(uint32_t movement, bool stall) {
+    uint32_t ms = detector.blockCount() * BLOCK_PERIOD_US / 1000;
+    if (stall) {
+      std::printf("Movement %u: stall after %u ms, filtered %u, peak %u\n", movement, ms,
+                  detector.filteredValue(), detector.peak());
+    } else {
+      std::printf("Movement %u: no stall, %u ms, peak %u\n", movement, ms, detector.peak());
+    }
+  }
+
+ private:
+  StallDetector detector;
+};
+
+int main(int argc, char** argv) {
+  if (argc != 5) {
+    std::fprintf(stderr, "Usage: %s <trace> <threshold raw> <stall blocks> <blanking blocks>\n",
+                 argv[0]);
+    return 1;
+  }
+  TraceReader reader(argv[1], "CT");
+  if (not reader.isOpen()) {
+    std::fprintf(stderr, "Can not open %s\n", argv[1]);
+    return 1;
+  }
+  StallConfig cfg = {};
+  cfg.thresholdRaw = std::atoi(argv[2]);
+  cfg.stallBlocks = std::atoi(argv[3]);
+  cfg.blankingBlocks = std::atoi(argv[4]);
+  cfg.filterShift = FILTER_SHIFT;
+  CurrentReplay replay(cfg);
+  replayMovements(reader, replay);
+  return 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * Replays recorded encoder traces through the encoder tracker of the firmware, so the time
+ * without pulses until a stall and the blanking after the motor start can be tuned on a host.
+ * The traces are the EN lines printed with CONFIG_MOTOR_ENCODER_TRACE, which already contain
+ * the signed pulse count.
+ *
+ *   ./encoder_replay monitor.log <stall ms> <blanking ms>
+ */
+#include <cstdio>
+#include <cstdlib>
+
+#include "encoder_tracker.h"
+#include "trace_replay.h"
+
+// Must match the firmware, see encoder.h
+static constexpr uint8_t SPEED_FILTER_SHIFT = 2;
+
+class EncoderReplay {
+ public:
+  explicit EncoderReplay(const EncoderConfig& cfg) : tracker(cfg) {}
+
+  void start(uint32_t timeMs, int32_t count) {
+    startCount = count;
+    tracker.start(count, timeMs);
+  }
+
+  bool feed(uint32_t timeMs, int32_t count) {
+    lastCount = count;
+    return tracker.feed(count, timeMs);
+  }
+
+  void report(uint32_t movement, bool stall) {
+    std::printf("Movement %u: %s %u ms, %d pulses, peak %d pulses/s\n", movement,
+                stall ? "stall after" : "no stall,", tracker.movementMs(),
+                lastCount - startCount, tracker.peak());
+  }
+
+ private:
+  EncoderTracker tracker;
+  int32_t startCount = 0;
+  int32_t lastCount = 0;
+};
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::fprintf(stderr, "Usage: %s <trace> <stall ms> <blanking ms>\n", argv[0]);
+    return 1;
+  }
+  TraceReader reader(argv[1], "EN");
+  if (not reader.isOpen()) {
+    std::fprintf(stderr, "Can not open %s\n", argv[1]);
+    return 1;
+  }
+  EncoderConfig cfg = {};
+  cfg.stallMs = std::atoi(argv[2]);
+  cfg.blankingMs = std::atoi(argv[3]);
+  cfg.speedShift = SPEED_FILTER_SHIFT;
+  EncoderReplay replay(cfg);
+  replayMovements(reader, replay);
+  return 0;
+}
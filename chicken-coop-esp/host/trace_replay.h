@@ -0,0 +1,83 @@
+#ifndef HOST_TRACE_REPLAY_H_
+#define HOST_TRACE_REPLAY_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+/**
+ * Reads the lines <tag>,<time in ms>,<value> of one trace from a console log and skips all
+ * other lines. The firmware restarts the time of a trace with every motor start, so a time of 0
+ * starts a new movement.
+ */
+class TraceReader {
+ public:
+  TraceReader(const char* path, const char* tag)
+      : file(path), format(std::string(tag) + ",%lu,%ld") {}
+
+  bool isOpen() const { return file.is_open(); }
+
+  /**
+   * Returns false at the end of the log.
+   */
+  bool next(uint32_t& timeMs, int32_t& value) {
+    std::string line;
+    while (std::getline(file, line)) {
+      unsigned long traceMs = 0;
+      long traceValue = 0;
+      if (std::sscanf(line.c_str(), format.c_str(), &traceMs, &traceValue) == 2) {
+        newMovement = traceMs == 0;
+        timeMs = traceMs;
+        value = traceValue;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool startsMovement() const { return newMovement; }
+
+ private:
+  std::ifstream file;
+  std::string format;
+  bool newMovement = false;
+};
+
+/**
+ * Feeds every movement of a trace to a replay until its first stall, where the firmware stops
+ * the motor. The replay implements:
+ *
+ *   void start(uint32_t timeMs, int32_t value)  first line of a movement, before it is fed
+ *   bool feed(uint32_t timeMs, int32_t value)   returns true on a stall
+ *   void report(uint32_t movement, bool stall)  at the stall or at the end of the movement
+ *
+ * Returns the number of movements.
+ */
+template <typename Replay>
+uint32_t replayMovements(TraceReader& reader, Replay& replay) {
+  uint32_t movement = 0;
+  bool stalled = false;
+  uint32_t timeMs = 0;
+  int32_t value = 0;
+  while (reader.next(timeMs, value)) {
+    if (reader.startsMovement()) {
+      if (movement > 0 and not stalled) {
+        replay.report(movement, false);
+      }
+      movement++;
+      stalled = false;
+      replay.start(timeMs, value);
+    }
+    if (movement > 0 and not stalled and replay.feed(timeMs, value)) {
+      stalled = true;
+      replay.report(movement, true);
+    }
+  }
+  if (movement > 0 and not stalled) {
+    replay.report(movement, false);
+  }
+  return movement;
+}
+
+#endif /* HOST_TRACE_REPLAY_H_ */
@@ -0,0 +1,126 @@
+#include "binary_frame.h"
+
+#include <cstring>
+
+uint16_t binframe::crc16(const uint8_t* data, size_t len, uint16_t crc) {
+  for (size_t idx = 0; idx < len; idx++) {
+    crc ^= static_cast<uint16_t>(data[idx]) << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+binframe::Decoder::Status binframe::Decoder::feed(uint8_t byte) {
+  switch (state) {
+    case (State::SYNC_0): {
+      if (byte == SYNC_0) {
+        state = State::SYNC_1;
+      } else {
+        stats.skippedBytes++;
+      }
+      break;
+    }
+    case (State::SYNC_1): {
+      if (byte == SYNC_1) {
+        state = State::HEADER;
+        idx = 0;
+      } else if (byte != SYNC_0) {
+        stats.skippedBytes += 2;
+        state = State::SYNC_0;
+      } else {
+        stats.skippedBytes++;
+      }
+      break;
+    }
+    case (State::HEADER): {
+      header[idx++] = byte;
+      if (idx < header.size()) {
+        break;
+      }
+      length = header[0] | (header[1] << 8);
+      idx = 0;
+      if (length > MAX_PAYLOAD_SIZE) {
+        // The frame end is unknown, so the decoder resynchronizes on the next sync marker
+        stats.lengthErrors++;
+        lastError = NakReason::LENGTH_ERROR;
+        state = State::SYNC_0;
+        return Status::ERROR;
+      }
+      state = length > 0 ? State::PAYLOAD : State::CRC;
+      break;
+    }
+    case (State::PAYLOAD): {
+      buf[idx++] = byte;
+      if (idx == length) {
+        idx = 0;
+        state = State::CRC;
+      }
+      break;
+    }
+    case (State::CRC): {
+      crcBuf[idx++] = byte;
+      if (idx < crcBuf.size()) {
+        break;
+      }
+      state = State::SYNC_0;
+      uint16_t crc = crc16(header.data(), header.size());
+      crc = crc16(buf.data(), length, crc);
+      if (crc != (crcBuf[0] | (crcBuf[1] << 8))) {
+        stats.crcErrors++;
+        lastError = NakReason::CRC_ERROR;
+        return Status::ERROR;
+      }
+      stats.frames++;
+      return Status::FRAME;
+    }
+  }
+  return Status::BUSY;
+}
+
+void binframe::Decoder::reset() {
+  state = State::SYNC_0;
+  length = 0;
+  idx = 0;
+}
+
+void binframe::Encoder::begin(FrameType type, uint8_t seq) {
+  frame[0] = SYNC_0;
+  frame[1] = SYNC_1;
+  frame[4] = seq;
+  frame[5] = static_cast<uint8_t>(type);
+  length = 0;
+}
+
+bool binframe::Encoder::append(const uint8_t* data, size_t len) {
+  if (length + len > MAX_PAYLOAD_SIZE) {
+    return false;
+  }
+  std::memcpy(frame.data() + HEADER_SIZE + length, data, len);
+  length += len;
+  return true;
+}
+
+bool binframe::Encoder::appendRecord(Result result, const uint8_t* reply, size_t len) {
+  if (len <= UINT8_MAX and length + RECORD_HEADER_SIZE + len <= MAX_PAYLOAD_SIZE) {
+    appendByte(static_cast<uint8_t>(result));
+    appendByte(len);
+    return append(reply, len);
+  }
+  // Report the command result without the reply
+  if (length + RECORD_HEADER_SIZE > MAX_PAYLOAD_SIZE) {
+    return false;
+  }
+  appendByte(static_cast<uint8_t>(Result::REPLY_OVERFLOW));
+  return appendByte(0);
+}
+
+size_t binframe::Encoder::finish() {
+  frame[2] = length & 0xff;
+  frame[3] = (length >> 8) & 0xff;
+  uint16_t crc = crc16(frame.data() + 2, HEADER_SIZE - 2 + length);
+  frame[HEADER_SIZE + length] = crc & 0xff;
+  frame[HEADER_SIZE + length + 1] = (crc >> 8) & 0xff;
+  return HEADER_SIZE + length + CRC_SIZE;
+}
@@ -0,0 +1,148 @@
+#ifndef MAIN_BINARY_FRAME_H_
+#define MAIN_BINARY_FRAME_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Optional binary framing of the UART protocol. It is enabled with the ASCII handshake command
+ * and adds a length field, a sequence number and a CRC to each frame. All multi-byte fields are
+ * little endian.
+ *
+ *  | 0xA5 | 0x5A | length (2) | seq (1) | type (1) | payload (length) | CRC-16 (2) |
+ *
+ * The CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) covers the length, sequence,
+ * type and payload fields.
+ *
+ * A REQUEST frame contains one or more commands, each as a length byte followed by the ASCII
+ * command payload without the "CC" pattern and the terminator. The RESPONSE frame echoes the
+ * sequence number and contains one record per command: result code, length byte and the ASCII
+ * reply payload, which is empty for commands without a reply. A frame which can not be decoded
+ * is answered with a NAK frame carrying the NAK reason. The host may send several REQUEST frames
+ * without waiting for the responses, they are handled in order.
+ *
+ * TELEMETRY frames are sent by the device without a request if the host subscribed to them.
+ * They are sent in the ASCII mode as well and use their own sequence numbers.
+ */
+namespace binframe {
+
+static constexpr uint8_t SYNC_0 = 0xA5;
+static constexpr uint8_t SYNC_1 = 0x5A;
+static constexpr uint8_t PROTOCOL_VERSION = 1;
+static constexpr size_t HEADER_SIZE = 6;
+static constexpr size_t CRC_SIZE = 2;
+static constexpr size_t MAX_PAYLOAD_SIZE = 320;
+static constexpr size_t MAX_FRAME_SIZE = HEADER_SIZE + MAX_PAYLOAD_SIZE + CRC_SIZE;
+// Size of a response record without the reply payload
+static constexpr size_t RECORD_HEADER_SIZE = 2;
+
+enum class FrameType : uint8_t {
+  REQUEST = 0x01,
+  RESPONSE = 0x02,
+  NAK = 0x03,
+  // Leaves the binary mode. Acknowledged with an empty RESPONSE frame.
+  EXIT = 0x04,
+  // Telemetry sample pushed by the device, see telemetry.h
+  TELEMETRY = 0x05,
+  // Deferred log record written to the console, see dlog.h
+  LOG = 0x06,
+};
+
+enum class NakReason : uint8_t {
+  CRC_ERROR = 0x01,
+  LENGTH_ERROR = 0x02,
+  INVALID_TYPE = 0x03,
+  // Malformed command records inside a REQUEST frame
+  INVALID_BATCH = 0x04,
+  // The command queue of the device is full, the frame can be sent again later
+  BUSY = 0x05,
+};
+
+// Result code of a single command
+enum class Result : uint8_t {
+  OK = 0x00,
+  INVALID_CMD = 0x01,
+  INVALID_ARG = 0x02,
+  // The command is not allowed in the current state, for example a motor command outside of the
+  // manual mode
+  INVALID_STATE = 0x03,
+  FAILED = 0x04,
+  // The reply did not fit into the response frame
+  REPLY_OVERFLOW = 0x05,
+};
+
+uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+
+/**
+ * Incremental decoder for binary frames. Like the ASCII frame parser, the bytes can be fed in
+ * arbitrary pieces and the decoder does not allocate. Bytes outside of frames are skipped until
+ * the next sync marker.
+ */
+class Decoder {
+ public:
+  enum class Status : uint8_t { BUSY, FRAME, ERROR };
+
+  struct Stats {
+    uint32_t frames = 0;
+    uint32_t crcErrors = 0;
+    uint32_t lengthErrors = 0;
+    uint32_t skippedBytes = 0;
+  };
+
+  /**
+   * Feeds one byte. After FRAME, the frame fields are available until the next call. After
+   * ERROR, error() returns the NAK reason and seq() the sequence number if it was received.
+   */
+  Status feed(uint8_t byte);
+
+  uint8_t seq() const { return header[2]; }
+  FrameType type() const { return static_cast<FrameType>(header[3]); }
+  const uint8_t* payload() const { return buf.data(); }
+  size_t payloadLen() const { return length; }
+  NakReason error() const { return lastError; }
+
+  void reset();
+
+  const Stats& getStats() const { return stats; }
+
+ private:
+  enum class State : uint8_t { SYNC_0, SYNC_1, HEADER, PAYLOAD, CRC };
+
+  State state = State::SYNC_0;
+  // Length, sequence number and type
+  std::array<uint8_t, HEADER_SIZE - 2> header = {};
+  std::array<uint8_t, MAX_PAYLOAD_SIZE> buf = {};
+  std::array<uint8_t, CRC_SIZE> crcBuf = {};
+  size_t length = 0;
+  size_t idx = 0;
+  NakReason lastError = NakReason::CRC_ERROR;
+  Stats stats;
+};
+
+/**
+ * Builds a frame in place, so the payload does not have to be copied. The frame is started
+ * with begin(), filled with the append functions and completed with finish(), which returns the
+ * full frame length.
+ */
+class Encoder {
+ public:
+  void begin(FrameType type, uint8_t seq);
+  // Returns false if the data does not fit, nothing is appended in that case.
+  bool append(const uint8_t* data, size_t len);
+  bool appendByte(uint8_t byte) { return append(&byte, 1); }
+  // Appends a response record. The reply is dropped if it does not fit.
+  bool appendRecord(Result result, const uint8_t* reply, size_t len);
+  size_t finish();
+
+  size_t payloadLen() const { return length; }
+  const uint8_t* data() const { return frame.data(); }
+
+ private:
+  std::array<uint8_t, MAX_FRAME_SIZE> frame = {};
+  size_t length = 0;
+};
+
+}  // namespace binframe
+
+#endif /* MAIN_BINARY_FRAME_H_ */
@@ -0,0 +1,110 @@
+#include "command_parser.h"
+
+bool FrameParser::feed(uint8_t byte) {
+  char c = static_cast<char>(byte);
+  switch (state) {
+    case (State::SEARCH_FIRST): {
+      if (c == PATTERN_CHAR) {
+        state = State::SEARCH_SECOND;
+      } else {
+        stats.skippedBytes++;
+      }
+      break;
+    }
+    case (State::SEARCH_SECOND): {
+      if (c == PATTERN_CHAR) {
+        state = State::PAYLOAD;
+        payloadLen = 0;
+      } else {
+        stats.skippedBytes += 2;
+        state = State::SEARCH_FIRST;
+      }
+      break;
+    }
+    case (State::PAYLOAD): {
+      if (c == TERMINATOR) {
+        state = State::SEARCH_FIRST;
+        stats.frames++;
+        return true;
+      }
+      if (payloadLen == buf.size()) {
+        stats.overflows++;
+        state = State::DISCARD;
+        break;
+      }
+      buf[payloadLen++] = c;
+      break;
+    }
+    case (State::DISCARD): {
+      // Skip the rest of an oversized frame
+      if (c == TERMINATOR) {
+        state = State::SEARCH_FIRST;
+      }
+      break;
+    }
+  }
+  return false;
+}
+
+void FrameParser::reset() {
+  state = State::SEARCH_FIRST;
+  payloadLen = 0;
+}
+
+static bool parseField(std::string_view str, size_t pos, size_t digits, int& value) {
+  value = 0;
+  for (size_t idx = pos; idx < pos + digits; idx++) {
+    if (str[idx] < '0' or str[idx] > '9') {
+      return false;
+    }
+    value = value * 10 + (str[idx] - '0');
+  }
+  return true;
+}
+
+static constexpr bool isLeapYear(int year) {
+  return (year % 4 == 0 and year % 100 != 0) or year % 400 == 0;
+}
+
+bool parseTimestamp(std::string_view str, tm& time) {
+  // YYYY-MM-DDTHH:MM:SSZ
+  static constexpr size_t TIMESTAMP_LEN = 20;
+  static constexpr uint8_t DAYS_IN_MONTH[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  static constexpr uint16_t DAYS_BEFORE_MONTH[12] = {0,   31,  59,  90,  120, 151,
+                                                     181, 212, 243, 273, 304, 334};
+  // Offsets for the weekday calculation by Tomohiko Sakamoto
+  static constexpr uint8_t WEEKDAY_OFFSETS[12] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+  if (str.size() != TIMESTAMP_LEN or str[4] != '-' or str[7] != '-' or str[10] != 'T' or
+      str[13] != ':' or str[16] != ':' or str[19] != 'Z') {
+    return false;
+  }
+  int year = 0;
+  int month = 0;
+  int day = 0;
+  int hour = 0;
+  int minute = 0;
+  int second = 0;
+  if (not parseField(str, 0, 4, year) or not parseField(str, 5, 2, month) or
+      not parseField(str, 8, 2, day) or not parseField(str, 11, 2, hour) or
+      not parseField(str, 14, 2, minute) or not parseField(str, 17, 2, second)) {
+    return false;
+  }
+  if (month < 1 or month > 12 or day < 1 or hour > 23 or minute > 59 or second > 59) {
+    return false;
+  }
+  bool leap = isLeapYear(year);
+  if (day > DAYS_IN_MONTH[month - 1] + (month == 2 and leap ? 1 : 0)) {
+    return false;
+  }
+  time = {};
+  time.tm_year = year - 1900;
+  time.tm_mon = month - 1;
+  time.tm_mday = day;
+  time.tm_hour = hour;
+  time.tm_min = minute;
+  time.tm_sec = second;
+  time.tm_yday = DAYS_BEFORE_MONTH[month - 1] + day - 1 + (month > 2 and leap ? 1 : 0);
+  int y = month < 3 ? year - 1 : year;
+  time.tm_wday = (y + y / 4 - y / 100 + y / 400 + WEEKDAY_OFFSETS[month - 1] + day) % 7;
+  return true;
+}
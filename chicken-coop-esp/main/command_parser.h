@@ -0,0 +1,60 @@
+#ifndef MAIN_COMMAND_PARSER_H_
+#define MAIN_COMMAND_PARSER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+/**
+ * Incremental parser for the ASCII command frames received over the UART. A frame starts with
+ * the pattern "CC" and ends with a newline character. The bytes can be fed in arbitrary pieces,
+ * the state is kept across partial frames. The parser does not allocate.
+ */
+class FrameParser {
+ public:
+  static constexpr char PATTERN_CHAR = 'C';
+  static constexpr char TERMINATOR = '\n';
+  static constexpr size_t MAX_PAYLOAD_SIZE = 300;
+
+  struct Stats {
+    uint32_t frames = 0;
+    // Frames which were longer than the payload buffer
+    uint32_t overflows = 0;
+    // Bytes outside of frames
+    uint32_t skippedBytes = 0;
+  };
+
+  /**
+   * Feeds one byte. Returns true if a frame is complete, its payload is available with
+   * payload() until the next call.
+   */
+  bool feed(uint8_t byte);
+
+  // Payload between the pattern and the terminator. Empty for a ping.
+  std::string_view payload() const {
+    return std::string_view(buf.data(), payloadLen);
+  }
+
+  void reset();
+
+  const Stats& getStats() const { return stats; }
+
+ private:
+  enum class State : uint8_t { SEARCH_FIRST, SEARCH_SECOND, PAYLOAD, DISCARD };
+
+  State state = State::SEARCH_FIRST;
+  std::array<char, MAX_PAYLOAD_SIZE> buf = {};
+  size_t payloadLen = 0;
+  Stats stats;
+};
+
+/**
+ * Decodes a timestamp with the fixed format YYYY-MM-DDTHH:MM:SSZ (CCSDS ASCII time code A
+ * without fractions of a second). The weekday and the day of the year are set as well. Returns
+ * false if the format or a field is invalid.
+ */
+bool parseTimestamp(std::string_view str, tm& time);
+
+#endif /* MAIN_COMMAND_PARSER_H_ */
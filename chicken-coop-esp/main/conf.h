@@ -15,8 +15,21 @@ static constexpr bool START_IN_MANUAL_MODE = true;
 static constexpr bool START_IN_MANUAL_MODE = false;
 #endif
 
+#ifdef CONFIG_LOW_POWER_MODE
+static constexpr bool LOW_POWER_MODE = true;
+static constexpr uint32_t LOW_POWER_AWAKE_WINDOW_MS = CONFIG_LOW_POWER_AWAKE_WINDOW * 1000;
+static constexpr uint32_t LOW_POWER_MIN_SLEEP_MS = CONFIG_LOW_POWER_MIN_SLEEP * 1000;
+#else
+static constexpr bool LOW_POWER_MODE = false;
+static constexpr uint32_t LOW_POWER_AWAKE_WINDOW_MS = 0;
+static constexpr uint32_t LOW_POWER_MIN_SLEEP_MS = 0;
+#endif
+
 static constexpr uint32_t START_DELAY_MS = 4000;
+// The UART falls back to the ASCII protocol if no binary frame was received for this time
+static constexpr uint32_t BINARY_MODE_TIMEOUT_MS = 60 * 1000;
 
+// Upper limits of the open duration and close timeout derived from the learned travel time
 static constexpr uint32_t OPEN_DURATION_MS = 150 * 1000;
 static constexpr uint32_t MAX_CLOSE_DURATION = OPEN_DURATION_MS + 10 * 1000;
 
@@ -1,26 +1,57 @@
 #include "control.h"
 
 #include <ds3231.h>
+#include <esp_cpu.h>
 #include <esp_log.h>
+#include <esp_sleep.h>
 #include <esp_task_wdt.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <algorithm>
+#include <charconv>
 #include <cinttypes>
+#include <cstdio>
 #include <cstring>
 #include <ctime>
-#include <string>
+#include <limits>
+#include <string_view>
 
 #include "compile_time.h"
 #include "conf.h"
+#include "current_sense.h"
+#include "dlog.h"
+#include "encoder.h"
 #include "open_close_times.h"
+#include "schedule.h"
+#include "storage.h"
+#include "sun_times.h"
 #include "switch.h"
+#include "travel_time.h"
 #include "usr_config.h"
+#include "wallclock.h"
 
 static constexpr esp_log_level_t LOG_LEVEL = ESP_LOG_INFO;
 
+#ifdef CONFIG_SCHEDULE_SOURCE_SOLAR
+static constexpr const OcTimes* OC_TIMES = suntimes::OC_TIMES_SOLAR.days;
+#else
+static constexpr const OcTimes* OC_TIMES = OC_TIMES_DAY_OF_YEAR;
+#endif
+
+static const OcTimes* activeOcTable() {
+  // Read directly from the mapped schedule partition if an uploaded table is available
+  const OcTimes* table = schedule::table();
+  if (table == nullptr) {
+    table = OC_TIMES;
+  }
+  return table;
+}
+
 QueueHandle_t Controller::UART_QUEUE = nullptr;
 uart_config_t Controller::UART_CFG = {};
+RTC_DATA_ATTR Controller::RetainedState Controller::RETAINED = {};
 
 Controller::Controller(Led& led, AppStates initState) : led(led), appState(initState) {
   motorOpCfg.brightness = 64;
@@ -53,28 +84,427 @@ void Controller::taskEntryPoint(void* args) {
   }
 }
 
+void Controller::uartRxTaskEntryPoint(void* args) {
+  ControllerArgs* ctrlArgs = reinterpret_cast<ControllerArgs*>(args);
+  if (args != nullptr) {
+    ctrlArgs->controller.uartRxTaskHandle = xTaskGetCurrentTaskHandle();
+    ctrlArgs->controller.uartRxTask();
+  }
+}
+
+void Controller::notify() {
+  if (taskHandle != nullptr) {
+    xTaskNotifyGive(taskHandle);
+  }
+}
+
 void Controller::task() {
   esp_task_wdt_add(nullptr);
   ESP_ERROR_CHECK(i2cdev_init());
   ESP_ERROR_CHECK(ds3231_init_desc(&i2c, I2C_NUM_0, I2C_SDA, I2C_SCL));
-  ds3231_get_time(&i2c, &currentTime);
+  // Needs to be done before the wall clock initialization, which might re-configure the
+  // DS3231 INT/SQW output.
+  bool restoredFromSleep = config::LOW_POWER_MODE and restoreAfterDeepSleep();
+  ESP_ERROR_CHECK_WITHOUT_ABORT(wallclock::init(&i2c));
+  wallclock::getTime(currentTime);
   strftime(timeBuf, sizeof(timeBuf) - 1, "%Y-%m-%d %H:%M:%S", &currentTime);
   ESP_LOGI(CTRL_TAG, "Detected current time: %s", timeBuf);
-  if (doorswitch::opened()) {
-    ESP_LOGI(CTRL_TAG, "Door is opened");
-  } else {
-    ESP_LOGI(CTRL_TAG, "Door is closed");
-  }
+  ESP_LOGI(CTRL_TAG, "Door is %s", doorswitch::positionName(doorswitch::position()));
+  doorswitch::setEventTask(taskHandle);
+  motortask::setEventTask(taskHandle);
   startTime = xTaskGetTickCount();
-  if (appState == AppStates::START_DELAY) {
+  lastActivityTime = startTime;
+  wakeupStats.hourStartTicks = startTime;
+  ESP_LOGI(CTRL_TAG, "State snapshot uses %u bytes of RAM and %u bytes of flash per write",
+           sizeof(Snapshot) * 2, storage::blobFlashCost(sizeof(Snapshot)));
+  if (restoredFromSleep) {
+    // Needs the wall clock. A new day is detected by the NORMAL state machine, which evaluates
+    // the rules again.
+    updateDayPlan(false);
+    ESP_LOGI(CTRL_TAG, "Restored state after deep sleep, going to NORMAL mode");
+  } else if (appState == AppStates::START_DELAY and restoreSnapshot()) {
+    ESP_LOGI(CTRL_TAG, "Restored state snapshot, skipping the start delay");
+  } else if (appState == AppStates::START_DELAY) {
     ESP_LOGI(CTRL_TAG, "Waiting for %lu seconds before going into initialization mode..",
              config::START_DELAY_MS / 1000);
   }
   while (true) {
     ESP_ERROR_CHECK_WITHOUT_ABORT(esp_task_wdt_reset());
     stateMachine();
-    vTaskDelay(pdMS_TO_TICKS(100));
+    persistState();
+    publishTelemetry();
+    TickType_t waitTicks = nextWakeupTicks();
+    if (deepSleepAllowed(waitTicks)) {
+      enterDeepSleep(waitTicks);
+    }
+    // The task might block for hours, so it is only supervised by the task watchdog while it
+    // is supposed to wake up regularly.
+    bool longWait = waitTicks > pdMS_TO_TICKS(WDT_SAFE_WAIT_MS);
+    if (longWait) {
+      esp_task_wdt_delete(nullptr);
+    }
+    // Blocks until the next deadline or until an external event like a UART reception or a
+    // door switch edge occurs.
+    ulTaskNotifyTake(pdTRUE, waitTicks);
+    if (longWait) {
+      esp_task_wdt_add(nullptr);
+    }
+    countWakeup();
+  }
+}
+
+TickType_t Controller::nextWakeupTicks() {
+  // The motor task supervises an active motor and notifies the task with the completion
+  TickType_t waitTicks = portMAX_DELAY;
+  if (appState == AppStates::START_DELAY) {
+    // The start delay check requires the delay to be exceeded
+    limitWait(waitTicks, remainingTicks(startTime, config::START_DELAY_MS) + 1);
+  } else if (appState == AppStates::NORMAL) {
+    // The RTC only has second resolution, so the deadlines are based on the start of the
+    // respective second. Waking up slightly too early only leads to another short wait.
+    uint32_t daySeconds = getDaySeconds();
+    // The schedule rules are evaluated again for a new day
+    limitWait(waitTicks, pdMS_TO_TICKS((SECONDS_PER_DAY - daySeconds) * 1000));
+    time_t nextEvent = plan.nextEpoch();
+    if (nextEvent != -1) {
+      time_t now = wallclock::now();
+      limitWait(waitTicks, nextEvent > now ? pdMS_TO_TICKS((nextEvent - now) * 1000) : 0);
+    }
+    if (recheckParams.recheckMode == RecheckState::RECHECKING) {
+      limitWait(waitTicks, remainingTicks(recheckParams.recheckStartTimeTicks, RECHECK_DELAY_MS));
+    } else if (recheckParams.recheckMode == RecheckState::IDLE) {
+      limitWait(waitTicks, remainingTicks(recheckParams.recheckStartTimeTicks,
+                                          config::MAX_CLOSE_DURATION * 2) +
+                               1);
+    }
+    if (config::LOW_POWER_MODE) {
+      // Re-evaluate whether deep sleep is possible once the awake window is over
+      TickType_t awakeTicks = remainingTicks(lastActivityTime, config::LOW_POWER_AWAKE_WINDOW_MS);
+      if (awakeTicks > 0) {
+        limitWait(waitTicks, awakeTicks);
+      }
+    }
+  }
+  if (telemetryPeriodMs > 0) {
+    limitWait(waitTicks, remainingTicks(lastTelemetryTime, telemetryPeriodMs));
+    // A state change which was held back by the rate limit
+    if (telemetry::stateChanged(buildTelemetry(), lastTelemetry)) {
+      limitWait(waitTicks, remainingTicks(lastTelemetryTime, telemetry::MIN_PERIOD_MS));
+    }
+  }
+  return waitTicks;
+}
+
+uint32_t Controller::getDaySeconds() const {
+  return getDayMinutesFromHourAndMinute(currentTime.tm_hour, currentTime.tm_min) * 60 +
+         currentTime.tm_sec;
+}
+
+bool Controller::doorOperationPending() const {
+  if (pendingAction != DoorAction::NONE or plan.due(wallclock::now())) {
+    return true;
+  }
+  return recheckParams.recheckMode == RecheckState::RETRYING;
+}
+
+void Controller::limitWait(TickType_t& waitTicks, TickType_t deadlineTicks) {
+  if (deadlineTicks < waitTicks) {
+    waitTicks = deadlineTicks;
+  }
+}
+
+TickType_t Controller::remainingTicks(TickType_t startTicks, uint32_t durationMs) {
+  TickType_t elapsed = xTaskGetTickCount() - startTicks;
+  TickType_t duration = pdMS_TO_TICKS(durationMs);
+  if (elapsed >= duration) {
+    return 0;
+  }
+  return duration - elapsed;
+}
+
+bool Controller::deepSleepAllowed(TickType_t waitTicks) {
+  if (not config::LOW_POWER_MODE or appState != AppStates::NORMAL or
+      motorState != MotorDriveState::IDLE) {
+    return false;
+  }
+  // The recheck mechanism relies on the tick count, which does not survive deep sleep
+  if (recheckParams.recheckMode != RecheckState::ARMED) {
+    return false;
+  }
+  // A subscribed host expects live telemetry
+  if (telemetryPeriodMs > 0) {
+    return false;
+  }
+  if (waitTicks < pdMS_TO_TICKS(config::LOW_POWER_MIN_SLEEP_MS)) {
+    return false;
+  }
+  if (xTaskGetTickCount() - lastActivityTime < pdMS_TO_TICKS(config::LOW_POWER_AWAKE_WINDOW_MS)) {
+    return false;
+  }
+  // A pending door operation which waits for a door switch change can only be handled if the
+  // door switch can wake up the device.
+  if (DOOR_SWITCH_PORT > MAX_DEEP_SLEEP_WAKEUP_GPIO and doorOperationPending()) {
+    return false;
+  }
+  return true;
+}
+
+void Controller::enterDeepSleep(TickType_t sleepTicks) {
+  RETAINED.handledEpoch = handledEpoch;
+  RETAINED.pendingAction = pendingAction;
+  RETAINED.recheckMode = recheckParams.recheckMode;
+  RETAINED.currentDay = currentDay;
+  RETAINED.currentMonth = currentMonth;
+  RETAINED.doorFullyOpen = doorFullyOpen;
+  RETAINED.magic = RETAINED_MAGIC;
+
+  uint64_t wakeupMask = 0;
+  uint32_t sleepSeconds = 0;
+  if (sleepTicks != portMAX_DELAY) {
+    sleepSeconds = pdTICKS_TO_MS(sleepTicks) / 1000;
+    // Only hour, minute and second are matched, which is sufficient because there is always
+    // a deadline at the start of the next day.
+    tm alarmTime = currentTime;
+    alarmTime.tm_sec += sleepSeconds;
+    mktime(&alarmTime);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_clear_alarm_flags(&i2c, DS3231_ALARM_1));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_set_alarm(&i2c, DS3231_ALARM_1, &alarmTime,
+                                                   DS3231_ALARM1_MATCH_SECMINHOUR, nullptr,
+                                                   DS3231_ALARM2_EVERY_MIN));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_enable_alarm_ints(&i2c, DS3231_ALARM_1));
+    wakeupMask |= RTC_ALARM_INT_MASK;
+    // Fallback in case the alarm is missed
+    uint64_t timerSeconds = static_cast<uint64_t>(sleepSeconds) + DEEP_SLEEP_TIMER_MARGIN_S;
+    esp_sleep_enable_timer_wakeup(timerSeconds * 1000 * 1000);
+    strftime(timeBuf, sizeof(timeBuf) - 1, "%H:%M:%S", &alarmTime);
+    ESP_LOGI(CTRL_TAG, "Entering deep sleep for %lu seconds until %s", sleepSeconds, timeBuf);
+  } else {
+    ESP_LOGI(CTRL_TAG, "Entering deep sleep until an external event occurs");
+  }
+  // The RX line idles high, so the start bit of an incoming frame wakes up the device
+  if (COM_UART_RX_PORT <= MAX_DEEP_SLEEP_WAKEUP_GPIO) {
+    wakeupMask |= 1ULL << COM_UART_RX_PORT;
+  }
+  ESP_ERROR_CHECK_WITHOUT_ABORT(
+      esp_deep_sleep_enable_gpio_wakeup(wakeupMask, ESP_GPIO_WAKEUP_GPIO_LOW));
+  // Any change of the door switch wakes up the device
+  if (DOOR_SWITCH_PORT <= MAX_DEEP_SLEEP_WAKEUP_GPIO) {
+    esp_deepsleep_gpio_wake_up_mode_t switchWakeupMode = ESP_GPIO_WAKEUP_GPIO_HIGH;
+    if (gpio_get_level(DOOR_SWITCH_PORT) == 1) {
+      switchWakeupMode = ESP_GPIO_WAKEUP_GPIO_LOW;
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(
+        esp_deep_sleep_enable_gpio_wakeup(1ULL << DOOR_SWITCH_PORT, switchWakeupMode));
+  }
+  MotorBackend::holdStoppedInDeepSleep();
+  uart_wait_tx_done(UART_NUM, pdMS_TO_TICKS(100));
+  esp_deep_sleep_start();
+}
+
+bool Controller::restoreAfterDeepSleep() {
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED or
+      RETAINED.magic != RETAINED_MAGIC) {
+    return false;
+  }
+  // Only restore once
+  RETAINED.magic = 0;
+  ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_disable_alarm_ints(&i2c, DS3231_ALARM_1));
+  ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_clear_alarm_flags(&i2c, DS3231_ALARM_1));
+  handledEpoch = RETAINED.handledEpoch;
+  pendingAction = RETAINED.pendingAction;
+  recheckParams.recheckMode = RETAINED.recheckMode;
+  currentDay = RETAINED.currentDay;
+  currentMonth = RETAINED.currentMonth;
+  doorFullyOpen = RETAINED.doorFullyOpen;
+  initPrintSwitch = false;
+  led.setCurrentCfg(normalCfg);
+  appState = AppStates::NORMAL;
+  return true;
+}
+
+Controller::Snapshot Controller::buildSnapshot() const {
+  Snapshot snapshot = {};
+  if (motorState != MotorDriveState::IDLE) {
+    snapshot.motorStartEpoch = motorStartEpoch;
+  }
+  snapshot.year = currentTime.tm_year + 1900;
+  snapshot.month = currentMonth;
+  snapshot.day = currentDay;
+  snapshot.appState = static_cast<uint8_t>(appState);
+  snapshot.motorState = static_cast<uint8_t>(motorState);
+  snapshot.recheckMode = static_cast<uint8_t>(recheckParams.recheckMode);
+  snapshot.handledEpoch = handledEpoch;
+  snapshot.pendingAction = static_cast<uint8_t>(pendingAction);
+  if (forcedOp) {
+    snapshot.flags |= SNAPSHOT_FLAG_FORCED_OP;
+  }
+  if (doorFullyOpen) {
+    snapshot.flags |= SNAPSHOT_FLAG_DOOR_FULLY_OPEN;
+  }
+  return snapshot;
+}
+
+void Controller::persistState() {
+  // Only the automatic modes can be resumed
+  if (appState != AppStates::INIT and appState != AppStates::NORMAL) {
+    return;
+  }
+  Snapshot snapshot = buildSnapshot();
+  if (snapshot == lastSnapshot) {
+    return;
+  }
+  esp_err_t result =
+      storage::storeBlob(SNAPSHOT_KEY, SNAPSHOT_VERSION, &snapshot, sizeof(snapshot));
+  if (result != ESP_OK) {
+    // Retried on the next state machine run
+    ESP_LOGW(CTRL_TAG, "Writing state snapshot failed with %s", esp_err_to_name(result));
+    return;
+  }
+  lastSnapshot = snapshot;
+  snapshotWrites++;
+  ESP_LOGD(CTRL_TAG, "Wrote state snapshot %lu", snapshotWrites);
+}
+
+telemetry::Sample Controller::buildTelemetry() const {
+  TickType_t now = xTaskGetTickCount();
+  telemetry::Sample sample = {};
+  sample.uptimeMs = pdTICKS_TO_MS(now);
+  sample.appState = static_cast<uint8_t>(appState);
+  sample.motorState = static_cast<uint8_t>(motorState);
+  sample.doorSwitch = doorswitch::opened();
+  sample.recheckMode = static_cast<uint8_t>(recheckParams.recheckMode);
+  if (motorState != MotorDriveState::IDLE) {
+    sample.motorRuntimeMs = pdTICKS_TO_MS(now - motorStartTime);
+  }
+  sample.nextOpenMinute = telemetry::NO_MINUTE;
+  sample.nextCloseMinute = telemetry::NO_MINUTE;
+  for (size_t idx = 0; idx < plan.pendingEvents(); idx++) {
+    const DayPlan::Event& event = plan.pendingEvent(idx);
+    int16_t minute = (event.epoch % SECONDS_PER_DAY) / 60;
+    if (event.action == DoorAction::OPEN and sample.nextOpenMinute == telemetry::NO_MINUTE) {
+      sample.nextOpenMinute = minute;
+    } else if (event.action == DoorAction::CLOSE and
+               sample.nextCloseMinute == telemetry::NO_MINUTE) {
+      sample.nextCloseMinute = minute;
+    }
+  }
+  if (forcedOp) {
+    sample.flags |= telemetry::FLAG_FORCED_OP;
+  }
+  if (binaryMode) {
+    sample.flags |= telemetry::FLAG_BINARY_MODE;
   }
+  return sample;
+}
+
+void Controller::publishTelemetry() {
+  if (telemetryPeriodMs == 0) {
+    return;
+  }
+  TickType_t elapsed = xTaskGetTickCount() - lastTelemetryTime;
+  if (elapsed < pdMS_TO_TICKS(telemetry::MIN_PERIOD_MS)) {
+    return;
+  }
+  telemetry::Sample sample = buildTelemetry();
+  if (elapsed < pdMS_TO_TICKS(telemetryPeriodMs) and
+      not telemetry::stateChanged(sample, lastTelemetry)) {
+    return;
+  }
+  lastTelemetryTime = xTaskGetTickCount();
+  lastTelemetry = sample;
+  // The sequence number is incremented for dropped samples as well, so the host can detect them
+  binEncoder.begin(binframe::FrameType::TELEMETRY, telemetrySeq++);
+  binEncoder.append(reinterpret_cast<const uint8_t*>(&sample), sizeof(sample));
+  size_t frameLen = binEncoder.finish();
+  size_t freeSize = 0;
+  uart_get_tx_buffer_free_size(UART_NUM, &freeSize);
+  if (freeSize < frameLen) {
+    telemetryDropped++;
+    ESP_LOGD(CTRL_TAG, "UART TX buffer full, dropped telemetry sample %lu", telemetryDropped);
+    return;
+  }
+  writeBinaryFrame(frameLen);
+}
+
+bool Controller::restoreSnapshot() {
+  Snapshot snapshot = {};
+  esp_err_t result =
+      storage::loadBlob(SNAPSHOT_KEY, SNAPSHOT_VERSION, &snapshot, sizeof(snapshot));
+  if (result != ESP_OK) {
+    if (result != ESP_ERR_NVS_NOT_FOUND) {
+      ESP_LOGW(CTRL_TAG, "Loading state snapshot failed with %s", esp_err_to_name(result));
+    }
+    return false;
+  }
+  lastSnapshot = snapshot;
+  if (snapshot.year != currentTime.tm_year + 1900 or snapshot.month != currentTime.tm_mon or
+      snapshot.day != currentTime.tm_mday - 1) {
+    ESP_LOGI(CTRL_TAG, "State snapshot is not from the current day, ignoring it");
+    return false;
+  }
+  AppStates snapshotAppState = static_cast<AppStates>(snapshot.appState);
+  if ((snapshotAppState != AppStates::INIT and snapshotAppState != AppStates::NORMAL) or
+      snapshot.motorState > static_cast<uint8_t>(MotorDriveState::CLOSING) or
+      snapshot.recheckMode > static_cast<uint8_t>(RecheckState::RECHECKING) or
+      snapshot.pendingAction > static_cast<uint8_t>(DoorAction::CLOSE)) {
+    ESP_LOGW(CTRL_TAG, "Invalid state snapshot");
+    return false;
+  }
+  handledEpoch = snapshot.handledEpoch;
+  pendingAction = static_cast<DoorAction>(snapshot.pendingAction);
+  forcedOp = snapshot.flags & SNAPSHOT_FLAG_FORCED_OP;
+  doorFullyOpen = snapshot.flags & SNAPSHOT_FLAG_DOOR_FULLY_OPEN;
+  // The tick based recheck timers start again
+  recheckParams.recheckMode = static_cast<RecheckState>(snapshot.recheckMode);
+  recheckParams.recheckStartTimeTicks = xTaskGetTickCount();
+  appState = snapshotAppState;
+  if (appState == AppStates::NORMAL) {
+    currentDay = snapshot.day;
+    currentMonth = snapshot.month;
+    updateDayPlan(true);
+    initPrintSwitch = false;
+    led.setCurrentCfg(normalCfg);
+  } else {
+    led.setCurrentCfg(initCfg);
+  }
+
+  motorState = static_cast<MotorDriveState>(snapshot.motorState);
+  if (motorState != MotorDriveState::IDLE) {
+    uint32_t durationMs = traveltime::openDurationMs();
+    if (motorState == MotorDriveState::CLOSING) {
+      durationMs = traveltime::closeTimeoutMs();
+    }
+    int64_t elapsedMs = (wallclock::now() - snapshot.motorStartEpoch) * 1000;
+    if (elapsedMs < 0) {
+      elapsedMs = 0;
+    } else if (elapsedMs > durationMs) {
+      elapsedMs = durationMs;
+    }
+    // The motor task completes the operation right away if the remaining time is over.
+    motorStartTime = xTaskGetTickCount() - pdMS_TO_TICKS(elapsedMs);
+    motorStartEpoch = snapshot.motorStartEpoch;
+    ESP_LOGI(CTRL_TAG, "Resuming interrupted motor operation for %lu ms",
+             static_cast<uint32_t>(durationMs - elapsedMs));
+    led.setCurrentCfg(motorOpCfg);
+    driveDoorMotor(motorState == MotorDriveState::CLOSING);
+  }
+  return true;
+}
+
+void Controller::countWakeup() {
+  TickType_t now = xTaskGetTickCount();
+  if (now - wakeupStats.hourStartTicks >= pdMS_TO_TICKS(MS_PER_HOUR)) {
+    // Only the last full hour is kept. Hours without any wakeup are reported as zero.
+    if (now - wakeupStats.hourStartTicks >= 2 * pdMS_TO_TICKS(MS_PER_HOUR)) {
+      wakeupStats.lastHour = 0;
+    } else {
+      wakeupStats.lastHour = wakeupStats.currentHour;
+    }
+    wakeupStats.currentHour = 0;
+    wakeupStats.hourStartTicks = now;
+  }
+  wakeupStats.currentHour++;
+  wakeupStats.total++;
 }
 
 void Controller::stateMachine() {
@@ -82,19 +512,22 @@ void Controller::stateMachine() {
   // Set compile time
   time_t seconds = __TIME_UNIX__;
   tm* time = localtime(&seconds);
-  ds3231_set_time(&i2c, time);
+  wallclock::setTime(*time);
 #endif
 
-  ds3231_get_time(&i2c, &currentTime);
+  ESP_ERROR_CHECK_WITHOUT_ABORT(wallclock::resyncIfDue());
+  wallclock::getTime(currentTime);
 
-  // Handle all events
-  handleUartReception();
+  // Handle all commands which were queued by the UART RX task
+  handleUartCommands();
+
+  handleMotorEvents();
 
   // INIT mode: System just came up and we need to check whether any operations are necessary
   // for the current time
   if (appState == AppStates::START_DELAY) {
     if (pdTICKS_TO_MS(xTaskGetTickCount() - startTime) > config::START_DELAY_MS) {
-      ESP_LOGI(CTRL_TAG, "Going into INIT mode");
+      dlog::log(dlog::Msg::GOING_INIT);
       appState = AppStates::INIT;
     } else {
       return;
@@ -103,12 +536,11 @@ void Controller::stateMachine() {
   if (appState == AppStates::INIT) {
     if (initPrintSwitch) {
       updateCurrentDayAndMonth();
-      updateCurrentOpenCloseTimes(true);
       initPrintSwitch = false;
     }
     int result = stateMachineInit();
     if (result == 0) {
-      ESP_LOGI(CTRL_TAG, "Going to NORMAL mode");
+      dlog::log(dlog::Msg::GOING_NORMAL);
       led.setCurrentCfg(normalCfg);
       // Ensure consistent state, no matter what the FSM did.
       motorCtrlDone();
@@ -119,153 +551,145 @@ void Controller::stateMachine() {
   if (appState == AppStates::NORMAL) {
     stateMachineNormal();
   }
-  // In manual mode, monitor the manual motor control operations
+  // In manual mode, the motor runs until it is stopped, stalls or the jog is over
   if (appState == AppStates::MANUAL) {
     if (initPrintSwitch) {
       initPrintSwitch = false;
     }
     ESP_LOGV(CTRL_TAG, "Command state Manual Mode: %d", static_cast<uint8_t>(motorState));
-    switch (motorState) {
-      case (MotorDriveState::OPENING): {
-        openDoor();
-        break;
-      }
-      case (MotorDriveState::CLOSING): {
-        closeDoor();
-        break;
-      }
-      case (MotorDriveState::IDLE): {
-        motor::stop();
-      }
-      default: {
-        break;
-      }
+    if (motorState != MotorDriveState::IDLE and motorCompletion) {
+      motorOpId = 0;
+      motorCompletion.reset();
+      motorState = MotorDriveState::IDLE;
+    }
+  }
+}
+
+void Controller::handleMotorEvents() {
+  motortask::Completion completion = {};
+  while (motortask::takeCompletion(completion)) {
+    // Completions of replaced operations are ignored
+    if (motorOpId == 0 or completion.id != motorOpId) {
+      continue;
     }
+    if (completion.result == motortask::Result::STALLED) {
+      const currentsense::Stats& stats = currentsense::stats();
+      dlog::log(dlog::Msg::MOTOR_STALL, stats.lastStallMs, stats.lastStallMa);
+    }
+    motorCompletion = completion;
   }
 }
 
 int Controller::stateMachineInit() {
+  // The door is driven to the state which the schedule expects for the current time, no matter
+  // what the door switch reports. The expected state is only determined once, so an operation
+  // which was started shortly before the next event is finished first.
+  if (initAction == DoorAction::NONE) {
+    time_t now = wallclock::now();
+    // Past events are required to determine the expected state
+    handledEpoch = std::numeric_limits<time_t>::min();
+    updateDayPlan(false);
+    initAction = plan.actionAt(now);
+    time_t eventEpoch = 0;
+    plan.popDue(now, eventEpoch);
+    handledEpoch = now;
+    pendingAction = DoorAction::NONE;
+    printDayPlan();
+  }
+  // A restored operation can run in the other direction, for example when an event passed
+  // while the controller was reset. It is stopped so the expected direction is driven instead.
+  MotorDriveState expectedState =
+      initAction == DoorAction::OPEN ? MotorDriveState::OPENING : MotorDriveState::CLOSING;
+  if (motorState != MotorDriveState::IDLE and motorState != expectedState) {
+    dlog::log(dlog::Msg::INIT_DIRECTION_CHANGE);
+    stopMotor();
+    motorState = MotorDriveState::IDLE;
+  }
   int result = 0;
-
-  // There are three cases to consider here:
-  //  1. Controller started before opening time
-  //  2. Controller started during open time
-  //  3. Controller started during close time
-  // In the first case, both open and close need to be executed for that day but the door has
-  // to be closed.
-  // In the second case, if the door is closed, it needs to be opened. Otherwise, only close
-  // needs to be executed for that day
-  // In the third case, the door is closed if it is open, otherwise nothing needs to be done
-  int hour = currentTime.tm_hour;
-  int minute = currentTime.tm_min;
-  int dayMinutes = getDayMinutesFromHourAndMinute(hour, minute);
-
-  // TODO: This should be updated to be more reliable in the case that an operation starts
-  // shortly before going from one case to another case. The easiest way would be to model and
-  // cache the case type and keep executing the case until it is finished.
-  if (dayMinutes < currentOpenDayMinutes) {
-    // Case 1. Close the door if not already done
-    result = initClose();
-    if (result == 0) {
-      appParams.openExecutedForTheDay = false;
-      appParams.closeExecutedForTheDay = false;
-      // Both operations needs to be performed in the IDLE mode, INIT mode done
-      ESP_LOGI(CTRL_TAG, "Door needs to be both opened and closed for this day");
-    }
-    return result;
-  } else if (dayMinutes >= currentOpenDayMinutes and dayMinutes < currentCloseDayMinutes) {
-    // Case 2
+  if (initAction == DoorAction::OPEN) {
     result = initOpen();
-    if (result == 0) {
-      appParams.openExecutedForTheDay = true;
-      appParams.closeExecutedForTheDay = false;
-    }
-    return result;
-  } else if (dayMinutes >= currentCloseDayMinutes) {
-    // Case 3
+  } else {
     result = initClose();
-    if (result == 0) {
-      appParams.openExecutedForTheDay = true;
-      appParams.closeExecutedForTheDay = true;
-    }
-    return result;
   }
-  // For boundary cases, we are not done for now
-  return 0;
+  if (result == 0) {
+    initAction = DoorAction::NONE;
+  }
+  return result;
 }
 
 void Controller::stateMachineNormal() {
-  int monthIdx = currentTime.tm_mon;
-  if (monthIdx != currentMonth) {
-    currentMonth = monthIdx;
-  }
-
   int day = currentTime.tm_mday - 1;
-  // new day has started. Each day, open and close need to be executed once for now
-  if (day != currentDay) {
+  if (day != currentDay or currentTime.tm_mon != currentMonth) {
     currentDay = day;
-    appParams.openExecutedForTheDay = false;
-    appParams.closeExecutedForTheDay = false;
-    ESP_LOGI(CTRL_TAG, "New day has started. Assigning new opening and closing times");
-    updateCurrentOpenCloseTimes(true);
+    currentMonth = currentTime.tm_mon;
+    dlog::log(dlog::Msg::NEW_DAY);
+    updateDayPlan(true);
   }
 
-  int hour = currentTime.tm_hour;
-  int minute = currentTime.tm_min;
-  int dayMinutes = getDayMinutesFromHourAndMinute(hour, minute);
-  if (not appParams.openExecutedForTheDay and dayMinutes >= currentOpenDayMinutes) {
-    if (doorswitch::closed()) {
+  time_t now = wallclock::now();
+  if (plan.due(now)) {
+    // Only the last of several due events matters, for example after a time change
+    time_t eventEpoch = 0;
+    pendingAction = plan.popDue(now, eventEpoch);
+    handledEpoch = eventEpoch;
+    dlog::log(pendingAction == DoorAction::OPEN ? dlog::Msg::OPENING_DUE
+                                                : dlog::Msg::CLOSING_DUE);
+  }
+
+  if (pendingAction == DoorAction::OPEN) {
+    if (not doorswitch::fullyOpen()) {
       // Motor control might already be pending
       if (motorState != MotorDriveState::OPENING) {
-        ESP_LOGI(CTRL_TAG, "Opening door in IDLE mode");
+        dlog::log(dlog::Msg::NORMAL_OPENING);
         led.setCurrentCfg(motorOpCfg);
         openDoor();
         motorState = MotorDriveState::OPENING;
       }
     }
     if (motorState == MotorDriveState::OPENING) {
-      if (checkMotorOperationDone()) {
-        ESP_LOGI(CTRL_TAG, "Door opening operation in NORMAL mode done");
-        if (doorswitch::closed()) {
-          ESP_LOGW(CTRL_TAG, "Door should be opened but is closed according to switch");
-          motor::stop();
+      if (motorOperationDone()) {
+        dlog::log(dlog::Msg::NORMAL_OPEN_DONE);
+        if (not doorswitch::fullyOpen()) {
+          dlog::log(dlog::Msg::OPEN_SWITCH_MISMATCH);
         }
         motorCtrlDone();
-        appParams.openExecutedForTheDay = true;
+        pendingAction = DoorAction::NONE;
       }
     }
   }
 
-  if ((not appParams.closeExecutedForTheDay and dayMinutes >= currentCloseDayMinutes) or
-      recheckParams.recheckMode == RecheckState::RETRYING) {
+  if (pendingAction == DoorAction::CLOSE or recheckParams.recheckMode == RecheckState::RETRYING) {
     if (doorswitch::opened()) {
       // Motor control might already be pending
       if (motorState != MotorDriveState::CLOSING) {
-        ESP_LOGI(CTRL_TAG, "Closing door in NORMAL mode");
+        dlog::log(dlog::Msg::NORMAL_CLOSING);
         initCloseDoor();
       }
     }
     if (motorState == MotorDriveState::CLOSING) {
-      if (checkMotorOperationDone()) {
-        ESP_LOGI(CTRL_TAG, "Door closing operation in NORMAL mode done");
+      if (motorOperationDone()) {
+        dlog::log(dlog::Msg::NORMAL_CLOSE_DONE);
         if (doorswitch::opened()) {
-          ESP_LOGW(CTRL_TAG, "Door should be closed but is open according to switch");
+          dlog::log(dlog::Msg::CLOSE_SWITCH_MISMATCH);
         }
         checkRecheckMechanism();
         motorCtrlDone();
-        appParams.closeExecutedForTheDay = true;
+        if (pendingAction == DoorAction::CLOSE) {
+          pendingAction = DoorAction::NONE;
+        }
       }
     }
   }
 
   if (recheckParams.recheckMode == RecheckState::RECHECKING) {
-    if (pdTICKS_TO_MS(xTaskGetTickCount() - recheckParams.recheckStartTimeTicks) >= 2000) {
+    if (pdTICKS_TO_MS(xTaskGetTickCount() - recheckParams.recheckStartTimeTicks) >=
+        RECHECK_DELAY_MS) {
       if (!doorswitch::closed()) {
-        ESP_LOGI(CTRL_TAG, "Closing Recheck: Door not closed, re-trying");
+        dlog::log(dlog::Msg::RECHECK_RETRY);
         recheckParams.recheckMode = RecheckState::RETRYING;
         initCloseDoor();
       } else {
-        ESP_LOGI(CTRL_TAG, "Closing Recheck: Door is closed, OK");
+        dlog::log(dlog::Msg::RECHECK_OK);
         recheckParams.recheckMode = RecheckState::IDLE;
       }
     }
@@ -274,7 +698,7 @@ void Controller::stateMachineNormal() {
   if (recheckParams.recheckMode == RecheckState::IDLE &&
       pdTICKS_TO_MS(xTaskGetTickCount() - recheckParams.recheckStartTimeTicks) >
           config::MAX_CLOSE_DURATION * 2) {
-    ESP_LOGI(CTRL_TAG, "Closing Recheck: Rearming");
+    dlog::log(dlog::Msg::RECHECK_REARM);
     recheckParams.recheckMode = RecheckState::ARMED;
   }
 }
@@ -288,14 +712,14 @@ void Controller::initCloseDoor() {
 int Controller::initOpen() {
   // This needs to be executed in any case
   if (motorState == MotorDriveState::IDLE) {
-    ESP_LOGI(CTRL_TAG, "Door needs to be opened in INIT mode. Opening door");
+    dlog::log(dlog::Msg::INIT_OPENING);
     led.setCurrentCfg(motorOpCfg);
     openDoor();
     motorState = MotorDriveState::OPENING;
   }
   if (motorState == MotorDriveState::OPENING) {
-    if (checkMotorOperationDone()) {
-      ESP_LOGI(CTRL_TAG, "Door was opened in INIT mode");
+    if (motorOperationDone()) {
+      dlog::log(dlog::Msg::INIT_OPEN_DONE);
       led.blinkDefault();
       motorCtrlDone();
       return 0;
@@ -306,16 +730,16 @@ int Controller::initOpen() {
 
 int Controller::initClose() {
   if (motorState == MotorDriveState::IDLE) {
-    ESP_LOGI(CTRL_TAG, "Door needs to be closed in INIT mode. Closing door");
+    dlog::log(dlog::Msg::INIT_CLOSING);
     led.setCurrentCfg(motorOpCfg);
     closeDoor();
     motorState = MotorDriveState::CLOSING;
   }
   if (motorState == MotorDriveState::CLOSING) {
-    if (checkMotorOperationDone()) {
-      ESP_LOGI(CTRL_TAG, "Door was closed in INIT mode");
+    if (motorOperationDone()) {
+      dlog::log(dlog::Msg::INIT_CLOSE_DONE);
       if (doorswitch::opened()) {
-        ESP_LOGW(CTRL_TAG, "Door should be closed but is opened according to switch");
+        dlog::log(dlog::Msg::CLOSE_SWITCH_MISMATCH);
       }
       led.blinkDefault();
       checkRecheckMechanism();
@@ -326,62 +750,59 @@ int Controller::initClose() {
   return 1;
 }
 
-void Controller::handleUartCommand(std::string cmd) {
-  const char* rawCmd = cmd.data();
-  if (cmd.length() == 3) {
+binframe::Result Controller::handleUartCommand(std::string_view cmd) {
+  lastActivityTime = xTaskGetTickCount();
+  if (cmd.empty()) {
     size_t currentIdx = 0;
-    ESP_LOGI(CTRL_TAG, "Ping detected");
+    dlog::log(dlog::Msg::PING);
     UART_REPLY_BUF[currentIdx] = PATTERN_CHAR;
     currentIdx++;
     UART_REPLY_BUF[currentIdx] = PATTERN_CHAR;
     currentIdx++;
     UART_REPLY_BUF[currentIdx] = '\n';
     currentIdx++;
-    int result = uart_write_bytes(UART_NUM, UART_REPLY_BUF.data(), currentIdx);
-    if (result < 0) {
-      ESP_LOGI(CTRL_TAG, "UART write failed with code: %d", result);
-    }
-    return;
+    sendReply(currentIdx);
+    return binframe::Result::OK;
   }
-  char cmdByte = rawCmd[2];
+  char cmdByte = cmd[0];
   if (not validCmd(cmdByte)) {
-    ESP_LOGW(CTRL_TAG, "Invalid command byte %c detected", cmdByte);
-    return;
+    dlog::log(dlog::Msg::INVALID_CMD, cmdByte);
+    return binframe::Result::INVALID_CMD;
   }
   Cmds typedCmd = static_cast<Cmds>(cmdByte);
   switch (typedCmd) {
     case (Cmds::MODE): {
-      if (cmd.length() < 4) {
-        ESP_LOGW(CTRL_TAG, "Invalid mode command detected");
-        return;
+      if (cmd.length() < 2) {
+        dlog::log(dlog::Msg::INVALID_MODE_CMD);
+        return binframe::Result::INVALID_ARG;
       }
-      char modeByte = rawCmd[3];
+      char modeByte = cmd[1];
       if (modeByte == CMD_MODE_MANUAL) {
         // Switch to manual control
-        ESP_LOGI(CTRL_TAG, "Switching to manual mode");
+        dlog::log(dlog::Msg::MANUAL_MODE);
         led.setCurrentCfg(manualCfg);
         if (motorState != MotorDriveState::IDLE) {
-          ESP_LOGW(CTRL_TAG, "Can not switch to manual mode while door operation is pending");
-          return;
+          dlog::log(dlog::Msg::MANUAL_MODE_BUSY);
+          return binframe::Result::INVALID_STATE;
         } else {
           appState = AppStates::MANUAL;
         }
       } else if (modeByte == CMD_MODE_NORMAL) {
-        ESP_LOGI(CTRL_TAG, "Switching to normal mode");
+        dlog::log(dlog::Msg::NORMAL_MODE);
         led.setCurrentCfg(initCfg);
         resetToInitState();
       } else {
-        ESP_LOGW(CTRL_TAG, "Invalid mode specifier %c detected, M (manual) and N (normal) allowed",
-                 modeByte);
+        dlog::log(dlog::Msg::INVALID_MODE, modeByte);
+        return binframe::Result::INVALID_ARG;
       }
       break;
     }
     case (Cmds::REQUEST): {
-      if (cmd.length() < 4) {
-        ESP_LOGW(CTRL_TAG, "Invalid print command detected");
-        return;
+      if (cmd.length() < 2) {
+        dlog::log(dlog::Msg::INVALID_REQUEST_CMD);
+        return binframe::Result::INVALID_ARG;
       }
-      char printChar = rawCmd[3];
+      char printChar = cmd[1];
       if (printChar == static_cast<char>(RequestCmds::TIME)) {
         size_t strLen = strftime(timeBuf, sizeof(timeBuf) - 1, "%Y-%m-%d %H:%M:%S", &currentTime);
         ESP_LOGI(CTRL_TAG, "Current time %s was requested", timeBuf);
@@ -396,119 +817,237 @@ void Controller::handleUartCommand(std::string cmd) {
         currentIdx++;
         if (strLen + 3 > UART_REPLY_BUF.size()) {
           // This should never happen..
-          return;
+          return binframe::Result::FAILED;
         }
         std::memcpy(UART_REPLY_BUF.data() + currentIdx, timeBuf, strLen);
         currentIdx += strLen;
         UART_REPLY_BUF[currentIdx] = '\n';
         currentIdx += 1;
-        int result = uart_write_bytes(UART_NUM, UART_REPLY_BUF.data(), currentIdx);
-        if (result < 0) {
-          ESP_LOGI(CTRL_TAG, "UART write failed with code: %d", result);
+        sendReply(currentIdx);
+      } else if (printChar == static_cast<char>(RequestCmds::CLOCK)) {
+        wallclock::Stats stats = wallclock::getStats();
+        ESP_LOGI(CTRL_TAG,
+                 "Clock statistics were requested: %lu I2C reads avoided, %lu resyncs, last drift "
+                 "%ld s, max drift %ld s",
+                 stats.i2cReadsAvoided, stats.resyncs, stats.lastDriftSeconds,
+                 stats.maxAbsDriftSeconds);
+        int strLen = snprintf(reinterpret_cast<char*>(UART_REPLY_BUF.data()),
+                              UART_REPLY_BUF.size(), "%c%c%c%c%lu,%lu,%ld,%ld\n", PATTERN_CHAR,
+                              PATTERN_CHAR, static_cast<char>(typedCmd), printChar,
+                              stats.i2cReadsAvoided, stats.resyncs, stats.lastDriftSeconds,
+                              stats.maxAbsDriftSeconds);
+        sendReply(strLen);
+      } else if (printChar == static_cast<char>(RequestCmds::WAKEUPS)) {
+        ESP_LOGI(CTRL_TAG,
+                 "Wakeup statistics were requested: %lu last hour, %lu current hour, %lu total",
+                 wakeupStats.lastHour, wakeupStats.currentHour, wakeupStats.total);
+        int strLen = snprintf(reinterpret_cast<char*>(UART_REPLY_BUF.data()),
+                              UART_REPLY_BUF.size(), "%c%c%c%c%lu,%lu,%lu\n", PATTERN_CHAR,
+                              PATTERN_CHAR, static_cast<char>(typedCmd), printChar,
+                              wakeupStats.lastHour, wakeupStats.currentHour, wakeupStats.total);
+        sendReply(strLen);
+      } else if (printChar == static_cast<char>(RequestCmds::COMMANDS)) {
+        const FrameParser::Stats& parserStats = parser.getStats();
+        uint32_t avgCycles = cmdStats.commands > 0 ? cmdStats.totalCycles / cmdStats.commands : 0;
+        ESP_LOGI(CTRL_TAG,
+                 "Command statistics were requested: %lu frames, %lu overflows, %lu skipped "
+                 "bytes, cycles per command %lu last, %lu avg, %lu max, latency %lu us last, "
+                 "%lu us max, queue high water %lu, %lu dropped",
+                 parserStats.frames, parserStats.overflows, parserStats.skippedBytes,
+                 cmdStats.lastCycles, avgCycles, cmdStats.maxCycles, cmdStats.lastLatencyUs,
+                 cmdStats.maxLatencyUs, cmdRing.highWaterMark(), cmdStats.queueDrops);
+        int strLen = snprintf(
+            reinterpret_cast<char*>(UART_REPLY_BUF.data()), UART_REPLY_BUF.size(),
+            "%c%c%c%c%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", PATTERN_CHAR, PATTERN_CHAR,
+            static_cast<char>(typedCmd), printChar, parserStats.frames, parserStats.overflows,
+            parserStats.skippedBytes, cmdStats.lastCycles, avgCycles, cmdStats.maxCycles,
+            cmdStats.lastLatencyUs, cmdStats.maxLatencyUs, cmdRing.highWaterMark(),
+            cmdStats.queueDrops);
+        sendReply(strLen);
+      } else if (printChar == static_cast<char>(RequestCmds::TRAVEL)) {
+        const traveltime::Calibration& calibration = traveltime::calibration();
+        ESP_LOGI(CTRL_TAG,
+                 "Travel time was requested: %lu ms from %u samples, open duration %lu ms, "
+                 "close timeout %lu ms, %u timeouts",
+                 traveltime::travelMs(), calibration.count, traveltime::openDurationMs(),
+                 traveltime::closeTimeoutMs(), calibration.timeouts);
+        int strLen = snprintf(reinterpret_cast<char*>(UART_REPLY_BUF.data()),
+                              UART_REPLY_BUF.size(), "%c%c%c%c%lu,%lu,%lu,%u,%u\n", PATTERN_CHAR,
+                              PATTERN_CHAR, static_cast<char>(typedCmd), printChar,
+                              traveltime::travelMs(), traveltime::openDurationMs(),
+                              traveltime::closeTimeoutMs(), calibration.count,
+                              calibration.timeouts);
+        sendReply(strLen);
+      } else if (printChar == static_cast<char>(RequestCmds::SWITCH)) {
+        doorswitch::Stats stats = doorswitch::stats();
+        ESP_LOGI(CTRL_TAG,
+                 "Switch statistics were requested: %lu changes, %lu bounces, %lu glitches, "
+                 "max %lu edges per burst",
+                 stats.changes, stats.bounces, stats.glitches, stats.maxBurstEdges);
+        std::array<doorswitch::Edge, doorswitch::HISTORY_SIZE> edges = {};
+        size_t numEdges = doorswitch::history(edges.data(), edges.size());
+        int64_t nowUs = esp_timer_get_time();
+        for (size_t idx = 0; idx < numEdges; idx++) {
+          ESP_LOGI(CTRL_TAG, "%s switch %s %lld ms ago", doorswitch::inputName(edges[idx].input),
+                   edges[idx].active ? "active" : "inactive",
+                   (nowUs - edges[idx].timeUs) / 1000);
         }
+        int strLen = snprintf(reinterpret_cast<char*>(UART_REPLY_BUF.data()),
+                              UART_REPLY_BUF.size(), "%c%c%c%c%lu,%lu,%lu,%lu,%d\n",
+                              PATTERN_CHAR, PATTERN_CHAR, static_cast<char>(typedCmd), printChar,
+                              stats.changes, stats.bounces, stats.glitches, stats.maxBurstEdges,
+                              static_cast<int>(doorswitch::position()));
+        sendReply(strLen);
+      } else if (printChar == static_cast<char>(RequestCmds::SCHEDULE)) {
+        bool fromFlash = schedule::table() != nullptr;
+        ESP_LOGI(CTRL_TAG, "Schedule info was requested: %s table, sequence %lu",
+                 fromFlash ? "uploaded" : "compiled-in", schedule::sequence());
+        int strLen = snprintf(reinterpret_cast<char*>(UART_REPLY_BUF.data()),
+                              UART_REPLY_BUF.size(), "%c%c%c%c%d,%lu\n", PATTERN_CHAR,
+                              PATTERN_CHAR, static_cast<char>(typedCmd), printChar, fromFlash,
+                              schedule::sequence());
+        sendReply(strLen);
+      } else {
+        dlog::log(dlog::Msg::INVALID_REQUEST, printChar);
+        return binframe::Result::INVALID_ARG;
       }
       break;
     }
+    case (Cmds::SCHEDULE): {
+      return handleScheduleCommand(cmd);
+    }
     case (Cmds::TIME): {
-      std::string timeString = cmd.substr(3, cmd.size() - 3 - 1);
-      ESP_LOGI(CTRL_TAG, "Received time string %s", timeString.c_str());
+      std::string_view timeString = cmd.substr(1);
+      ESP_LOGI(CTRL_TAG, "Received time string %.*s", timeString.size(), timeString.data());
       struct tm timeParsed = {};
-      char* parseResult = strptime(timeString.c_str(), "%Y-%m-%dT%H:%M:%SZ", &timeParsed);
-      if (parseResult != nullptr) {
+      if (parseTimestamp(timeString, timeParsed)) {
         ESP_LOGI(CTRL_TAG, "Setting received time in DS3231 clock");
-        ds3231_set_time(&i2c, &timeParsed);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(wallclock::setTime(timeParsed));
+        wallclock::getTime(currentTime);
         ESP_LOGI(CTRL_TAG, "Setting INIT mode");
         resetToInitState();
       } else {
-        // Invalid date format. Send NAK reply
-        ESP_LOGW(CTRL_TAG, "Invalid date format. Pointer where parsing failed: %s", parseResult);
+        // Invalid date format. Only binary mode clients receive a NAK result.
+        ESP_LOGW(CTRL_TAG, "Invalid date format");
+        return binframe::Result::INVALID_ARG;
       }
       break;
     }
     case (Cmds::MOTOR_CTRL): {
-      if (cmd.length() < 5) {
-        ESP_LOGW(CTRL_TAG, "Invalid motor control command detected");
-        return;
+      if (cmd.length() < 3) {
+        dlog::log(dlog::Msg::INVALID_MOTOR_CMD);
+        return binframe::Result::INVALID_ARG;
       }
-      char protChar = rawCmd[3];
+      char protChar = cmd[1];
       bool protOn = true;
       if (protChar == CMD_MOTOR_FORCE_MODE) {
         protOn = false;
       }
-      char dirChar = rawCmd[4];
+      char dirChar = cmd[2];
 
       if (appState != AppStates::MANUAL and dirChar != CMD_MOTOR_CTRL_STOP) {
-        ESP_LOGW(CTRL_TAG,
-                 "Received motor control command but not in manual mode. "
-                 "Activate manual mode first");
-        return;
+        dlog::log(dlog::Msg::MOTOR_NOT_MANUAL);
+        return binframe::Result::INVALID_STATE;
       }
       if (dirChar == CMD_MOTOR_CTRL_OPEN) {
-        if (protOn and doorswitch::opened()) {
-          ESP_LOGW(CTRL_TAG, "Door opening was requested but the door is already open");
-          return;
+        if (protOn and doorswitch::fullyOpen()) {
+          dlog::log(dlog::Msg::ALREADY_OPEN);
+          return binframe::Result::INVALID_STATE;
         }
         if (not protOn) {
           forcedOp = true;
         }
-        ESP_LOGI(CTRL_TAG, "Opening door in manual mode");
+        dlog::log(dlog::Msg::MANUAL_OPEN);
         openDoor();
         motorState = MotorDriveState::OPENING;
       } else if (dirChar == CMD_MOTOR_CTRL_CLOSE) {
         if (protOn and doorswitch::closed()) {
-          ESP_LOGW(CTRL_TAG, "Door closing was requested but the door is already open");
-          return;
+          dlog::log(dlog::Msg::ALREADY_CLOSED);
+          return binframe::Result::INVALID_STATE;
         }
         if (not protOn) {
           forcedOp = true;
         }
         closeDoor();
-        ESP_LOGI(CTRL_TAG, "Closing door in manual mode");
+        dlog::log(dlog::Msg::MANUAL_CLOSE);
         motorState = MotorDriveState::CLOSING;
       } else if (dirChar == CMD_MOTOR_CTRL_STOP) {
-        ESP_LOGI(CTRL_TAG, "Stopping motor in manual mode");
-        motor::stop();
+        dlog::log(dlog::Msg::MANUAL_STOP);
+        stopMotor();
         motorState = MotorDriveState::IDLE;
+      } else if (dirChar == CMD_MOTOR_CTRL_JOG) {
+        return handleJogCommand(cmd, protOn);
+      } else if (dirChar == CMD_MOTOR_CTRL_POSITION) {
+        return handlePositionCommand(cmd, protOn);
+      } else if (dirChar == CMD_MOTOR_CTRL_VENTILATION) {
+        return handleVentilationCommand(protOn);
+      } else {
+        dlog::log(dlog::Msg::INVALID_MOTOR_DIR, dirChar);
+        return binframe::Result::INVALID_ARG;
       }
+      break;
+    }
+    case (Cmds::PROTOCOL): {
+      return handleProtocolCommand(cmd);
+    }
+    case (Cmds::TELEMETRY): {
+      return handleTelemetryCommand(cmd);
     }
   }
+  return binframe::Result::OK;
 }
 
-void Controller::updateCurrentOpenCloseTimes(bool printTimes) {
-  if (currentMonth == -1 or currentDay == -1) {
-    ESP_LOGE(CTRL_TAG, "Invalid current month or current day");
+void Controller::updateDayPlan(bool printEvents) {
+  plan.build(activeOcTable(), wallclock::now(), handledEpoch);
+  if (printEvents) {
+    printDayPlan();
   }
-  uint32_t openHour = OPEN_CLOSE_MONTHS[currentMonth]->month[currentDay][0];
-  uint32_t openMinute = OPEN_CLOSE_MONTHS[currentMonth]->month[currentDay][1];
-  uint32_t closeHour = OPEN_CLOSE_MONTHS[currentMonth]->month[currentDay][2];
-  uint32_t closeMinute = OPEN_CLOSE_MONTHS[currentMonth]->month[currentDay][3];
-  if (printTimes) {
-    ESP_LOGI(CTRL_TAG,
-             "Date: %02d.%02d | Opening time : %02lu:%02lu | "
-             "Closing time for today: %02lu:%02lu",
-             currentDay + 1, currentMonth + 1, openHour, openMinute, closeHour, closeMinute);
+}
+
+void Controller::printDayPlan() {
+  for (size_t idx = 0; idx < plan.pendingEvents(); idx++) {
+    const DayPlan::Event& event = plan.pendingEvent(idx);
+    tm eventTime = {};
+    gmtime_r(&event.epoch, &eventTime);
+    strftime(timeBuf, sizeof(timeBuf) - 1, "%d.%m. %H:%M:%S", &eventTime);
+    ESP_LOGI(CTRL_TAG, "Scheduled %s: %s",
+             event.action == DoorAction::OPEN ? "opening" : "closing", timeBuf);
   }
-  currentOpenDayMinutes = getDayMinutesFromHourAndMinute(openHour, openMinute);
-  currentCloseDayMinutes = getDayMinutesFromHourAndMinute(closeHour, closeMinute);
 }
 
-bool Controller::checkMotorOperationDone() {
+bool Controller::motorOperationDone() {
   if (motorState == MotorDriveState::IDLE) {
     return true;
   }
-  if (motorState == MotorDriveState::CLOSING) {
-    if (pdTICKS_TO_MS(xTaskGetTickCount() - motorStartTime) >= config::MAX_CLOSE_DURATION) {
-      return true;
-    } else if (not forcedOp) {
-      return doorswitch::closed();
-    }
+  if (not motorCompletion) {
+    return false;
   }
-  if (motorState == MotorDriveState::OPENING) {
-    if (pdTICKS_TO_MS(xTaskGetTickCount() - motorStartTime) >= config::OPEN_DURATION_MS) {
-      return true;
+  motortask::Result result = motorCompletion->result;
+  uint32_t elapsedMs = motorCompletion->elapsedMs;
+  motorOpId = 0;
+  motorCompletion.reset();
+  if (motorState == MotorDriveState::CLOSING) {
+    // Only a close from a fully opened door measures the full travel time, but no close should
+    // time out. A forced close ignores the door switch and always ends with the timeout. A stall
+    // with an open door switch means the door is jammed, which is handled like a switch mismatch.
+    if (closeFromOpen and result == motortask::Result::REACHED_SWITCH) {
+      traveltime::addSample(elapsedMs);
+    } else if (not forcedOp and result == motortask::Result::TIMED_OUT) {
+      traveltime::closeTimedOut(elapsedMs);
     }
+    closeFromOpen = false;
+  } else {
+    // Only an open which ended at a physical end leaves the door fully open: the top limit
+    // switch, a stall at the top end stop or the full fixed open duration. An open for the
+    // learned duration might stop short of the top, and a close measured from there would
+    // shrink the learned travel time.
+    bool physicalEnd = result == motortask::Result::REACHED_SWITCH or
+                       result == motortask::Result::STALLED or
+                       (result == motortask::Result::TRAVEL_DONE and
+                        elapsedMs >= config::OPEN_DURATION_MS);
+    doorFullyOpen = physicalEnd and doorswitch::fullyOpen();
   }
-  return false;
+  return true;
 }
 
 void Controller::setAppState(AppStates appState) { this->appState = appState; }
@@ -521,7 +1060,7 @@ void Controller::motorCtrlDone() {
   } else {
     led.blinkDefault();
   }
-  motor::stop();
+  stopMotor();
   motorState = MotorDriveState::IDLE;
   forcedOp = false;
 }
@@ -529,7 +1068,7 @@ void Controller::motorCtrlDone() {
 void Controller::checkRecheckMechanism() {
   if (motorState == MotorDriveState::CLOSING) {
     if (recheckParams.recheckMode == RecheckState::ARMED) {
-      ESP_LOGI(CTRL_TAG, "Door Recheck: Door closed, rechecking soon");
+      dlog::log(dlog::Msg::RECHECK_ARMED);
       recheckParams.recheckMode = RecheckState::RECHECKING;
       recheckParams.recheckStartTimeTicks = xTaskGetTickCount();
     }
@@ -539,8 +1078,98 @@ void Controller::checkRecheckMechanism() {
   }
 }
 
+static binframe::Result toCommandResult(esp_err_t result) {
+  switch (result) {
+    case (ESP_OK): {
+      return binframe::Result::OK;
+    }
+    case (ESP_ERR_INVALID_ARG):
+    case (ESP_ERR_INVALID_SIZE): {
+      return binframe::Result::INVALID_ARG;
+    }
+    case (ESP_ERR_INVALID_STATE): {
+      return binframe::Result::INVALID_STATE;
+    }
+    default: {
+      return binframe::Result::FAILED;
+    }
+  }
+}
+
+static bool parseHex(const char* str, size_t digits, uint32_t& value) {
+  value = 0;
+  for (size_t idx = 0; idx < digits; idx++) {
+    char c = str[idx];
+    uint32_t nibble = 0;
+    if (c >= '0' and c <= '9') {
+      nibble = c - '0';
+    } else if (c >= 'a' and c <= 'f') {
+      nibble = c - 'a' + 10;
+    } else {
+      return false;
+    }
+    value = (value << 4) | nibble;
+  }
+  return true;
+}
+
+binframe::Result Controller::handleScheduleCommand(std::string_view cmd) {
+  size_t len = cmd.length();
+  if (len < 2) {
+    ESP_LOGW(CTRL_TAG, "Invalid schedule command detected");
+    return binframe::Result::INVALID_ARG;
+  }
+  const char* rawCmd = cmd.data();
+  char subCmd = rawCmd[1];
+  esp_err_t result = ESP_ERR_INVALID_ARG;
+  if (subCmd == CMD_SCHEDULE_BEGIN) {
+    uint32_t length = 0;
+    uint32_t crc32 = 0;
+    if (len == 2 + 16 and parseHex(rawCmd + 2, 8, length) and parseHex(rawCmd + 10, 8, crc32)) {
+      result = schedule::beginUpload(length, crc32);
+    }
+  } else if (subCmd == CMD_SCHEDULE_DATA) {
+    uint32_t offset = 0;
+    size_t dataLen = (len - 10) / 2;
+    std::array<uint8_t, schedule::MAX_CHUNK_SIZE> chunk;
+    bool valid = len > 10 and (len - 10) % 2 == 0 and dataLen <= chunk.size() and
+                 parseHex(rawCmd + 2, 8, offset);
+    for (size_t idx = 0; valid and idx < dataLen; idx++) {
+      uint32_t byte = 0;
+      valid = parseHex(rawCmd + 10 + idx * 2, 2, byte);
+      chunk[idx] = byte;
+    }
+    if (valid) {
+      result = schedule::writeChunk(offset, chunk.data(), dataLen);
+    }
+  } else if (subCmd == CMD_SCHEDULE_END) {
+    result = schedule::finishUpload();
+    if (result == ESP_OK and appState == AppStates::NORMAL) {
+      updateDayPlan(true);
+    }
+  } else {
+    ESP_LOGW(CTRL_TAG, "Invalid schedule command %c detected", subCmd);
+    return binframe::Result::INVALID_ARG;
+  }
+  if (result != ESP_OK) {
+    ESP_LOGW(CTRL_TAG, "Schedule command %c failed: %s", subCmd, esp_err_to_name(result));
+  }
+  sendScheduleReply(subCmd, result);
+  return toCommandResult(result);
+}
+
+void Controller::sendScheduleReply(char subCmd, esp_err_t result) {
+  // The next expected offset allows the host to resume the upload after a lost chunk
+  int strLen = snprintf(reinterpret_cast<char*>(UART_REPLY_BUF.data()), UART_REPLY_BUF.size(),
+                        "%c%c%c%c%d,%lu\n", PATTERN_CHAR, PATTERN_CHAR,
+                        static_cast<char>(Cmds::SCHEDULE), subCmd, result,
+                        schedule::nextUploadOffset());
+  sendReply(strLen);
+}
+
 bool Controller::validCmd(char rawCmd) {
-  if (rawCmd == 'C' or rawCmd == 'T' or rawCmd == 'R' or rawCmd == 'M') {
+  if (rawCmd == 'C' or rawCmd == 'T' or rawCmd == 'R' or rawCmd == 'M' or rawCmd == 'S' or
+      rawCmd == 'B' or rawCmd == 'L') {
     return true;
   }
   return false;
@@ -564,77 +1193,398 @@ void Controller::uartInit() {
   ESP_ERROR_CHECK(uart_param_config(UART_NUM, &UART_CFG));
   ESP_ERROR_CHECK(uart_set_pin(UART_NUM, CONFIG_COM_UART_TX, CONFIG_COM_UART_RX, UART_PIN_NO_CHANGE,
                                UART_PIN_NO_CHANGE));
-  ESP_ERROR_CHECK(uart_enable_pattern_det_baud_intr(UART_NUM, PATTERN_CHAR, UART_PATTERN_NUM,
-                                                    UART_PATTERN_TIMEOUT, 0, 0));
-  // Don't know what this is good for.. It works without it I think.
-  // ESP_ERROR_CHECK(uart_pattern_queue_reset(UART_NUM, UART_QUEUE_DEPTH));
 }
 
-void Controller::handleUartReception() {
+void Controller::handleUartCommands() {
+  const UartCommand* entry = nullptr;
+  while ((entry = cmdRing.front()) != nullptr) {
+    uint32_t latencyUs = esp_timer_get_time() - entry->receivedUs;
+    cmdStats.lastLatencyUs = latencyUs;
+    cmdStats.maxLatencyUs = std::max(cmdStats.maxLatencyUs, latencyUs);
+    if (entry->kind == UartCommand::Kind::ASCII) {
+      std::string_view payload(entry->data.data(), entry->len);
+      dlog::log(dlog::Msg::CMD_RECEIVED, payload.size() > 0 ? payload[0] : ' ',
+                payload.size() > 1 ? payload[1] : ' ', payload.size());
+      esp_cpu_cycle_count_t startCycles = esp_cpu_get_cycle_count();
+      handleUartCommand(payload);
+      countCommandCycles(esp_cpu_get_cycle_count() - startCycles);
+    } else {
+      handleBinaryFrame(*entry);
+    }
+    cmdRing.pop();
+  }
+}
+
+void Controller::uartRxTask() {
   uart_event_t event;
-  while (xQueueReceive(UART_QUEUE, reinterpret_cast<void*>(&event), 0)) {
-    switch (event.type) {
-      case (UART_DATA): {
-        break;
-      }
-      case (UART_PATTERN_DET): {
-        size_t len = 0;
-        uart_get_buffered_data_len(UART_NUM, &len);
-        int pos = uart_pattern_pop_pos(UART_NUM);
-        int nextPos = uart_pattern_get_pos(UART_NUM);
-        ESP_LOGD(CTRL_TAG, "Detected UART pattern");
-        ESP_LOGD(CTRL_TAG, "Total buffered length %d, position: %d, next position: %d", len, pos,
-                 nextPos);
-        if (pos > 0) {
-          // Delete preceding data first
-          uart_read_bytes(UART_NUM, UART_RECV_BUF.data(), pos, 0);
-        }
+  while (true) {
+    if (xQueueReceive(UART_QUEUE, reinterpret_cast<void*>(&event), portMAX_DELAY) != pdPASS) {
+      continue;
+    }
+    if (event.type == UART_FIFO_OVF or event.type == UART_BUFFER_FULL) {
+      ESP_LOGW(CTRL_TAG, "UART RX overflow, discarding received data");
+      uart_flush_input(UART_NUM);
+      xQueueReset(UART_QUEUE);
+      parser.reset();
+      binDecoder.reset();
+      continue;
+    }
+    if (event.type == UART_DATA) {
+      receiveUartData();
+    }
+  }
+}
 
-        size_t cmdLen = 0;
-        if (nextPos != -1 and nextPos > pos) {
-          // Next block of data detected. Only read the relevant block
-          cmdLen = nextPos - pos;
-        } else {
-          cmdLen = len - pos;
-        }
-        uart_read_bytes(UART_NUM, UART_RECV_BUF.data(), cmdLen, 0);
-        // Last character
-        if (UART_RECV_BUF[cmdLen - 1] != '\n') {
-          ESP_LOGW(CTRL_TAG, "Invalid UART command, did not end with newline character");
-          break;
-        }
-        UART_RECV_BUF[cmdLen - 1] = '\0';
-        ESP_LOGI(CTRL_TAG, "Received command %s", UART_RECV_BUF.data());
-        handleUartCommand(std::string(reinterpret_cast<const char*>(UART_RECV_BUF.data()), cmdLen));
-        break;
-      }
-      default: {
-        ESP_LOGW(CTRL_TAG, "Unknown event type");
+void Controller::receiveUartData() {
+  // The binary mode is left if the host was silent for too long, so a restarted host or an old
+  // client can use the ASCII protocol again.
+  if (binaryMode and xTaskGetTickCount() - lastBinaryFrameTime >
+                         pdMS_TO_TICKS(config::BINARY_MODE_TIMEOUT_MS)) {
+    ESP_LOGI(CTRL_TAG, "Binary mode timed out, switching to ASCII mode");
+    binaryMode = false;
+  }
+  // All buffered bytes are parsed, no matter how they are split into events
+  bool queued = false;
+  size_t len = 0;
+  uart_get_buffered_data_len(UART_NUM, &len);
+  while (len > 0) {
+    int readLen = uart_read_bytes(UART_NUM, UART_RECV_BUF.data(),
+                                  std::min(len, UART_RECV_BUF.size()), 0);
+    if (readLen <= 0) {
+      break;
+    }
+    len -= readLen;
+    for (int idx = 0; idx < readLen; idx++) {
+      // The mode might change with any frame, so it is checked for each byte
+      if (binaryMode) {
+        queued |= feedBinaryDecoder(UART_RECV_BUF[idx]);
+      } else if (parser.feed(UART_RECV_BUF[idx])) {
+        queued |= queueAsciiCommand(parser.payload());
       }
     }
   }
+  if (queued) {
+    notify();
+  }
+}
+
+bool Controller::queueAsciiCommand(std::string_view payload) {
+  UartCommand* entry = cmdRing.writeSlot();
+  if (entry == nullptr) {
+    cmdStats.queueDrops++;
+    return false;
+  }
+  entry->kind = UartCommand::Kind::ASCII;
+  entry->receivedUs = esp_timer_get_time();
+  entry->len = payload.size();
+  std::memcpy(entry->data.data(), payload.data(), payload.size());
+  cmdRing.commit();
+  // The mode is switched here, so the bytes following the handshake are already decoded as
+  // binary frames. The controller only sends the reply.
+  if (handshakeValid(payload)) {
+    binDecoder.reset();
+    binaryMode = true;
+    lastBinaryFrameTime = xTaskGetTickCount();
+  }
+  return true;
+}
+
+bool Controller::feedBinaryDecoder(uint8_t byte) {
+  binframe::Decoder::Status status = binDecoder.feed(byte);
+  if (status == binframe::Decoder::Status::ERROR) {
+    sendRxNak(binDecoder.seq(), binDecoder.error());
+    return false;
+  }
+  if (status != binframe::Decoder::Status::FRAME) {
+    return false;
+  }
+  lastBinaryFrameTime = xTaskGetTickCount();
+  UartCommand* entry = cmdRing.writeSlot();
+  if (entry == nullptr) {
+    cmdStats.queueDrops++;
+    sendRxNak(binDecoder.seq(), binframe::NakReason::BUSY);
+    return false;
+  }
+  entry->kind = UartCommand::Kind::BINARY;
+  entry->receivedUs = esp_timer_get_time();
+  entry->seq = binDecoder.seq();
+  entry->type = binDecoder.type();
+  entry->len = binDecoder.payloadLen();
+  std::memcpy(entry->data.data(), binDecoder.payload(), entry->len);
+  cmdRing.commit();
+  if (entry->type == binframe::FrameType::EXIT) {
+    binaryMode = false;
+  }
+  return true;
+}
+
+void Controller::sendRxNak(uint8_t seq, binframe::NakReason reason) {
+  // The RX task uses its own encoder, the controller might build a frame at the same time
+  rxEncoder.begin(binframe::FrameType::NAK, seq);
+  rxEncoder.appendByte(static_cast<uint8_t>(reason));
+  size_t frameLen = rxEncoder.finish();
+  int result = uart_write_bytes(UART_NUM, rxEncoder.data(), frameLen);
+  if (result < 0) {
+    ESP_LOGI(CTRL_TAG, "UART write failed with code: %d", result);
+  }
+}
+
+void Controller::handleBinaryFrame(const UartCommand& frame) {
+  uint8_t seq = frame.seq;
+  const uint8_t* payload = reinterpret_cast<const uint8_t*>(frame.data.data());
+  size_t payloadLen = frame.len;
+  if (frame.type == binframe::FrameType::EXIT) {
+    // The RX task already switched back to the ASCII mode
+    ESP_LOGI(CTRL_TAG, "Leaving binary mode");
+    binEncoder.begin(binframe::FrameType::RESPONSE, seq);
+    writeBinaryFrame();
+    return;
+  }
+  if (frame.type != binframe::FrameType::REQUEST) {
+    sendNak(seq, binframe::NakReason::INVALID_TYPE);
+    return;
+  }
+  // Check the record structure first, so a malformed batch is rejected as a whole
+  size_t offset = 0;
+  size_t numCmds = 0;
+  while (offset < payloadLen) {
+    offset += 1 + payload[offset];
+    numCmds++;
+  }
+  if (offset != payloadLen or numCmds == 0) {
+    sendNak(seq, binframe::NakReason::INVALID_BATCH);
+    return;
+  }
+  binEncoder.begin(binframe::FrameType::RESPONSE, seq);
+  offset = 0;
+  while (offset < payloadLen) {
+    std::string_view cmd(reinterpret_cast<const char*>(payload + offset + 1), payload[offset]);
+    offset += 1 + payload[offset];
+    dlog::log(dlog::Msg::BIN_CMD_RECEIVED, cmd.size() > 0 ? cmd[0] : ' ',
+              cmd.size() > 1 ? cmd[1] : ' ', cmd.size());
+    replyLen = 0;
+    replyToFrame = true;
+    esp_cpu_cycle_count_t startCycles = esp_cpu_get_cycle_count();
+    binframe::Result result = handleUartCommand(cmd);
+    countCommandCycles(esp_cpu_get_cycle_count() - startCycles);
+    replyToFrame = false;
+    if (not binEncoder.appendRecord(result, UART_REPLY_BUF.data() + 2, replyLen)) {
+      dlog::log(dlog::Msg::BIN_RESPONSE_FULL);
+    }
+  }
+  writeBinaryFrame();
+}
+
+void Controller::sendNak(uint8_t seq, binframe::NakReason reason) {
+  binEncoder.begin(binframe::FrameType::NAK, seq);
+  binEncoder.appendByte(static_cast<uint8_t>(reason));
+  writeBinaryFrame();
+}
+
+void Controller::writeBinaryFrame() { writeBinaryFrame(binEncoder.finish()); }
+
+void Controller::writeBinaryFrame(size_t frameLen) {
+  int result = uart_write_bytes(UART_NUM, binEncoder.data(), frameLen);
+  if (result < 0) {
+    dlog::log(dlog::Msg::UART_WRITE_FAILED, result);
+  }
+}
+
+void Controller::sendReply(size_t len) {
+  if (replyToFrame) {
+    // The reply is added to the response frame after the command was handled. Only the payload
+    // between the pattern and the terminator is used.
+    replyLen = len >= 3 ? len - 3 : 0;
+    return;
+  }
+  int result = uart_write_bytes(UART_NUM, UART_REPLY_BUF.data(), len);
+  if (result < 0) {
+    dlog::log(dlog::Msg::UART_WRITE_FAILED, result);
+  }
+}
+
+binframe::Result Controller::handleTelemetryCommand(std::string_view cmd) {
+  uint32_t periodMs = 0;
+  const char* end = cmd.data() + cmd.size();
+  std::from_chars_result parsed = std::from_chars(cmd.data() + 1, end, periodMs);
+  if (parsed.ec != std::errc() or parsed.ptr != end) {
+    ESP_LOGW(CTRL_TAG, "Invalid telemetry command detected");
+    return binframe::Result::INVALID_ARG;
+  }
+  if (periodMs > 0 and periodMs < telemetry::MIN_PERIOD_MS) {
+    periodMs = telemetry::MIN_PERIOD_MS;
+  }
+  if (periodMs > 0) {
+    ESP_LOGI(CTRL_TAG, "Telemetry subscribed with a period of %lu ms", periodMs);
+    // Send the first sample immediately
+    lastTelemetryTime = xTaskGetTickCount() - pdMS_TO_TICKS(periodMs);
+  } else {
+    ESP_LOGI(CTRL_TAG, "Telemetry unsubscribed, %lu samples were dropped", telemetryDropped);
+  }
+  telemetryPeriodMs = periodMs;
+  int strLen = snprintf(reinterpret_cast<char*>(UART_REPLY_BUF.data()), UART_REPLY_BUF.size(),
+                        "%c%c%c%lu\n", PATTERN_CHAR, PATTERN_CHAR,
+                        static_cast<char>(Cmds::TELEMETRY), telemetryPeriodMs);
+  sendReply(strLen);
+  return binframe::Result::OK;
+}
+
+bool Controller::handshakeValid(std::string_view cmd) {
+  return cmd.length() == 2 and cmd[0] == static_cast<char>(Cmds::PROTOCOL) and
+         cmd[1] - '0' == binframe::PROTOCOL_VERSION;
+}
+
+binframe::Result Controller::handleProtocolCommand(std::string_view cmd) {
+  if (replyToFrame) {
+    return binframe::Result::INVALID_STATE;
+  }
+  // The reply always contains the supported version, so the host can detect a mismatch
+  int strLen = snprintf(reinterpret_cast<char*>(UART_REPLY_BUF.data()), UART_REPLY_BUF.size(),
+                        "%c%c%c%u,%u\n", PATTERN_CHAR, PATTERN_CHAR,
+                        static_cast<char>(Cmds::PROTOCOL), binframe::PROTOCOL_VERSION,
+                        static_cast<unsigned>(binframe::MAX_PAYLOAD_SIZE));
+  sendReply(strLen);
+  if (not handshakeValid(cmd)) {
+    ESP_LOGW(CTRL_TAG, "Unsupported binary protocol version requested");
+    return binframe::Result::INVALID_ARG;
+  }
+  // The RX task already switched to the binary mode
+  ESP_LOGI(CTRL_TAG, "Switched to binary mode");
+  return binframe::Result::OK;
+}
+
+void Controller::countCommandCycles(uint32_t cycles) {
+  cmdStats.lastCycles = cycles;
+  if (cycles > cmdStats.maxCycles) {
+    cmdStats.maxCycles = cycles;
+  }
+  cmdStats.totalCycles += cycles;
+  cmdStats.commands++;
 }
 
 int Controller::getDayMinutesFromHourAndMinute(int hour, int minute) { return hour * 60 + minute; }
 
 void Controller::resetToInitState() {
   appState = AppStates::INIT;
-  appParams.openExecutedForTheDay = false;
-  appParams.closeExecutedForTheDay = false;
+  initAction = DoorAction::NONE;
+  pendingAction = DoorAction::NONE;
 }
 
 void Controller::openDoor() { driveDoorMotor(false); }
 void Controller::closeDoor() { driveDoorMotor(true); }
 
-void Controller::driveDoorMotor(bool dir1) {
+void Controller::driveDoorMotor(bool close) {
   // Cache the start time if we go from and idle motor to an active motor.
   // Required for stop condition detection and to limit the total time the motor may be active.
   if (motorState == MotorDriveState::IDLE) {
     motorStartTime = xTaskGetTickCount();
+    motorStartEpoch = wallclock::now();
+    closeFromOpen = close and doorFullyOpen and not forcedOp;
+    fullTravelOpen = not close and not forcedOp and traveltime::sampleOpen();
+    doorFullyOpen = false;
+  }
+  motortask::Command cmd = {};
+  cmd.cmd = close ? motortask::Cmd::CLOSE : motortask::Cmd::OPEN;
+  cmd.forced = forcedOp;
+  cmd.unlimited = appState == AppStates::MANUAL;
+  cmd.ms = pdTICKS_TO_MS(xTaskGetTickCount() - motorStartTime);
+  cmd.fullTravel = fullTravelOpen;
+  sendMotorCommand(cmd);
+}
+
+binframe::Result Controller::handleJogCommand(std::string_view cmd, bool protOn) {
+  // Protection, jog, direction and at least one digit
+  if (cmd.length() < 5) {
+    dlog::log(dlog::Msg::INVALID_MOTOR_CMD);
+    return binframe::Result::INVALID_ARG;
   }
-#if CONFIG_INVERT_MOTOR_DIRECTION
-  motor::driveDir(!dir1);
+  uint32_t durationMs = 0;
+  const char* end = cmd.data() + cmd.size();
+  std::from_chars_result parsed = std::from_chars(cmd.data() + 4, end, durationMs);
+  if (parsed.ec != std::errc() or parsed.ptr != end or durationMs == 0 or
+      durationMs > config::MAX_CLOSE_DURATION) {
+    dlog::log(dlog::Msg::INVALID_MOTOR_CMD);
+    return binframe::Result::INVALID_ARG;
+  }
+  char dirChar = cmd[3];
+  if (dirChar != CMD_MOTOR_CTRL_OPEN and dirChar != CMD_MOTOR_CTRL_CLOSE) {
+    dlog::log(dlog::Msg::INVALID_MOTOR_DIR, dirChar);
+    return binframe::Result::INVALID_ARG;
+  }
+  bool close = dirChar == CMD_MOTOR_CTRL_CLOSE;
+  if (protOn and not close and doorswitch::fullyOpen()) {
+    dlog::log(dlog::Msg::ALREADY_OPEN);
+    return binframe::Result::INVALID_STATE;
+  }
+  if (protOn and close and doorswitch::closed()) {
+    dlog::log(dlog::Msg::ALREADY_CLOSED);
+    return binframe::Result::INVALID_STATE;
+  }
+  dlog::log(dlog::Msg::MANUAL_JOG, dirChar, durationMs);
+  motorStartTime = xTaskGetTickCount();
+  motorStartEpoch = wallclock::now();
+  doorFullyOpen = false;
+  motortask::Command jog = {};
+  jog.cmd = motortask::Cmd::JOG;
+  jog.close = close;
+  jog.ms = durationMs;
+  sendMotorCommand(jog);
+  motorState = close ? MotorDriveState::CLOSING : MotorDriveState::OPENING;
+  return binframe::Result::OK;
+}
+
+binframe::Result Controller::handlePositionCommand(std::string_view cmd, bool protOn) {
+  uint32_t percent = 0;
+  const char* end = cmd.data() + cmd.size();
+  std::from_chars_result parsed = std::from_chars(cmd.data() + 3, end, percent);
+  if (not motortask::POSITION_CONTROL or cmd.length() < 4 or parsed.ec != std::errc() or
+      parsed.ptr != end or percent > 100) {
+    dlog::log(dlog::Msg::INVALID_MOTOR_CMD);
+    return binframe::Result::INVALID_ARG;
+  }
+  dlog::log(dlog::Msg::MANUAL_POSITION, percent);
+  moveDoor(percent, protOn);
+  return binframe::Result::OK;
+}
+
+binframe::Result Controller::handleVentilationCommand(bool protOn) {
+#ifdef CONFIG_MOTOR_BACKEND_STEPPER
+  dlog::log(dlog::Msg::MANUAL_POSITION, CONFIG_STEPPER_VENTILATION_GAP);
+  moveDoor(CONFIG_STEPPER_VENTILATION_GAP, protOn);
+  return binframe::Result::OK;
 #else
-  motor::driveDir(dir1);
+  dlog::log(dlog::Msg::INVALID_MOTOR_CMD);
+  return binframe::Result::INVALID_ARG;
 #endif
 }
+
+void Controller::moveDoor(uint8_t percent, bool protOn) {
+  motorStartTime = xTaskGetTickCount();
+  motorStartEpoch = wallclock::now();
+  doorFullyOpen = false;
+  motortask::Command move = {};
+  move.cmd = motortask::Cmd::MOVE;
+  move.forced = not protOn;
+  move.percent = percent;
+  sendMotorCommand(move);
+  // The motor task derives the direction from the door position
+  motorState = percent == 0 ? MotorDriveState::CLOSING : MotorDriveState::OPENING;
+}
+
+void Controller::sendMotorCommand(const motortask::Command& cmd) {
+  motorCompletion.reset();
+  motorOpId = motortask::send(cmd);
+  if (motorOpId == 0) {
+    // The operation is finished like a cancelled one, so the state machine does not wait for it
+    motorCompletion = motortask::Completion{0, motortask::Result::CANCELLED, cmd.ms};
+  }
+}
+
+void Controller::stopMotor() {
+  // An operation which already reported its completion does not need to be stopped
+  if (motorOpId != 0 and not motorCompletion) {
+    motortask::send(motortask::Command{motortask::Cmd::STOP, false, false, false, 0, 0, false});
+  }
+  motorOpId = 0;
+  motorCompletion.reset();
+}
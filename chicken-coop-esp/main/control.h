@@ -4,13 +4,21 @@
 #include <driver/uart.h>
 
 #include <array>
+#include <atomic>
 #include <ctime>
-#include <string>
+#include <optional>
+#include <string_view>
 
+#include "binary_frame.h"
+#include "command_parser.h"
 #include "conf.h"
+#include "day_plan.h"
 #include "i2cdev.h"
 #include "led.h"
-#include "motor.h"
+#include "motor_backend.h"
+#include "motor_task.h"
+#include "spsc_ring.h"
+#include "telemetry.h"
 
 void controlTask(void* args);
 
@@ -24,8 +32,13 @@ class Controller {
   void preTaskInit();
 
   static void taskEntryPoint(void* args);
+  static void uartRxTaskEntryPoint(void* args);
 
-  bool checkMotorOperationDone();
+  // Wakes up the controller task, for example if an external event needs to be handled.
+  void notify();
+
+  // Returns true once the motor task reported the end of the current operation
+  bool motorOperationDone();
 
   static int getDayMinutesFromHourAndMinute(int hour, int minute);
 
@@ -34,6 +47,16 @@ class Controller {
   static constexpr gpio_num_t I2C_SCL = static_cast<gpio_num_t>(CONFIG_I2C_SCL_PORT);
   static constexpr gpio_num_t DOOR_SWITCH_PORT =
       static_cast<gpio_num_t>(CONFIG_DOOR_SWITCH_STATE_PORT);
+  static constexpr gpio_num_t COM_UART_RX_PORT = static_cast<gpio_num_t>(CONFIG_COM_UART_RX);
+#ifdef CONFIG_LOW_POWER_MODE
+  static constexpr uint64_t RTC_ALARM_INT_MASK = 1ULL << CONFIG_RTC_INT_SQW_PORT;
+  static_assert(CONFIG_RTC_INT_SQW_PORT <= 5, "DS3231 INT pin must support deep sleep wakeups");
+#else
+  static constexpr uint64_t RTC_ALARM_INT_MASK = 0;
+#endif
+  // Only the GPIOs 0 to 5 can wake up the ESP32-C3 from deep sleep
+  static constexpr int MAX_DEEP_SLEEP_WAKEUP_GPIO = 5;
+  static constexpr uint32_t DEEP_SLEEP_TIMER_MARGIN_S = 60;
 
   static constexpr char CTRL_TAG[] = "ctrl";
   static constexpr char PATTERN_CHAR = 'C';
@@ -43,9 +66,24 @@ class Controller {
     MOTOR_CTRL = 'M',
     TIME = 'T',
     REQUEST = 'R',
+    SCHEDULE = 'S',
+    // Handshake for the binary framing, followed by the requested protocol version
+    PROTOCOL = 'B',
+    // Telemetry subscription, followed by the period in milliseconds. 0 unsubscribes.
+    TELEMETRY = 'L',
   };
 
-  enum class RequestCmds : char { TIME = 'T' };
+  enum class RequestCmds : char {
+    TIME = 'T',
+    WAKEUPS = 'W',
+    CLOCK = 'K',
+    SCHEDULE = 'S',
+    COMMANDS = 'P',
+    // Learned door travel time
+    TRAVEL = 'D',
+    // Limit switch debouncing statistics
+    SWITCH = 'L',
+  };
 
   static constexpr char CMD_MODE_MANUAL = 'M';
   static constexpr char CMD_MODE_NORMAL = 'N';
@@ -56,11 +94,30 @@ class Controller {
   static constexpr char CMD_MOTOR_CTRL_OPEN = 'O';
   static constexpr char CMD_MOTOR_CTRL_CLOSE = 'C';
   static constexpr char CMD_MOTOR_CTRL_STOP = 'S';
+  // Followed by the direction and the duration in ms, for example CCMPJO500\n
+  static constexpr char CMD_MOTOR_CTRL_JOG = 'J';
+  // Followed by the target in percent of the full travel, for example CCMPT50\n
+  static constexpr char CMD_MOTOR_CTRL_POSITION = 'T';
+  // Moves the stepper to the ventilation gap preset
+  static constexpr char CMD_MOTOR_CTRL_VENTILATION = 'V';
+
+  // Schedule upload. All numbers are lowercase hex, so the data never contains the pattern
+  // character. Begin: 8 digits length, 8 digits CRC32. Data: 8 digits offset, 2 digits per byte.
+  static constexpr char CMD_SCHEDULE_BEGIN = 'B';
+  static constexpr char CMD_SCHEDULE_DATA = 'D';
+  static constexpr char CMD_SCHEDULE_END = 'E';
 
   static constexpr uint32_t BLINK_PERIOD_NORMAL = 6000;
   static constexpr uint32_t BLINK_PERIOD_INIT = 3000;
   static constexpr uint32_t BLINK_PERIOD_MANUAL = 1000;
 
+  // Time after the door was closed before the switch is checked again.
+  static constexpr uint32_t RECHECK_DELAY_MS = 2000;
+  // Blocking periods longer than this are done without being subscribed to the task watchdog.
+  static constexpr uint32_t WDT_SAFE_WAIT_MS = CONFIG_ESP_TASK_WDT_TIMEOUT_S * 1000 / 2;
+  static constexpr uint32_t MS_PER_HOUR = 60 * 60 * 1000;
+  static constexpr uint32_t SECONDS_PER_DAY = 24 * 60 * 60;
+
   enum class DoorStates {
     UNKNOWN,
     DOOR_OPEN,
@@ -75,10 +132,13 @@ class Controller {
 
   Led& led;
 
-  struct AppParams {
-    bool openExecutedForTheDay = false;
-    bool closeExecutedForTheDay = false;
-  } appParams;
+  DayPlan plan{CONFIG_SCHEDULE_RULES, CONFIG_SCHEDULE_RULE_NUM};
+  // All schedule events up to this time were handled
+  time_t handledEpoch = 0;
+  // Door operation of the last due event which is not finished yet
+  DoorAction pendingAction = DoorAction::NONE;
+  // Door state which is established by the INIT mode
+  DoorAction initAction = DoorAction::NONE;
 
   enum class RecheckState {
     IDLE,
@@ -94,20 +154,121 @@ class Controller {
     uint32_t recheckCounter = 0;
   } recheckParams;
 
+  static constexpr uint32_t RETAINED_MAGIC = 0xC0DE5EEF;
+
+  // State which is retained in the RTC memory during deep sleep
+  struct RetainedState {
+    uint32_t magic = 0;
+    time_t handledEpoch = 0;
+    DoorAction pendingAction = DoorAction::NONE;
+    RecheckState recheckMode = RecheckState::ARMED;
+    int currentDay = -1;
+    int currentMonth = -1;
+    bool doorFullyOpen = false;
+  };
+  static RetainedState RETAINED;
+
+  static constexpr char SNAPSHOT_KEY[] = "ctrl-state";
+  static constexpr uint16_t SNAPSHOT_VERSION = 2;
+  static constexpr uint8_t SNAPSHOT_FLAG_FORCED_OP = 1 << 2;
+  static constexpr uint8_t SNAPSHOT_FLAG_DOOR_FULLY_OPEN = 1 << 3;
+
+  // Compact controller state which is persisted in the NVS on every state transition, so an
+  // interrupted day can be resumed after a reset.
+  struct Snapshot {
+    // Wall clock time when the motor was started
+    int64_t motorStartEpoch;
+    int64_t handledEpoch;
+    uint16_t year;
+    int8_t month;
+    int8_t day;
+    uint8_t appState;
+    uint8_t motorState;
+    uint8_t recheckMode;
+    uint8_t pendingAction;
+    uint8_t flags;
+
+    // Compares the fields, the padding bytes are indeterminate
+    bool operator==(const Snapshot& other) const = default;
+  };
+  // Last written snapshot. Used to only write to flash if something has changed.
+  Snapshot lastSnapshot = {};
+  uint32_t snapshotWrites = 0;
+
+  struct WakeupStats {
+    TickType_t hourStartTicks = 0;
+    uint32_t currentHour = 0;
+    uint32_t lastHour = 0;
+    uint32_t total = 0;
+  } wakeupStats;
+
   AppStates appState = AppStates::INIT;
   TaskHandle_t taskHandle = nullptr;
+  TaskHandle_t uartRxTaskHandle = nullptr;
   static constexpr uart_port_t UART_NUM = UART_NUM_1;
-  static constexpr uint8_t UART_PATTERN_NUM = 2;
-  static constexpr uint8_t UART_PATTERN_TIMEOUT = 5;
   static QueueHandle_t UART_QUEUE;
   static uart_config_t UART_CFG;
-  std::array<uint8_t, 524> UART_RECV_BUF = {};
+  // Chunk buffer for reading from the UART driver ring buffer
+  std::array<uint8_t, 128> UART_RECV_BUF = {};
   std::array<uint8_t, 256> UART_REPLY_BUF = {};
   static constexpr size_t UART_RING_BUF_SIZE = 524;
   static constexpr uint8_t UART_QUEUE_DEPTH = 20;
+  static constexpr size_t CMD_RING_SIZE = 8;
+
+  // Frame received by the UART RX task. ASCII frames contain the payload between the pattern and
+  // the terminator, binary frames the decoded frame payload.
+  struct UartCommand {
+    enum class Kind : uint8_t { ASCII, BINARY };
+    Kind kind;
+    uint8_t seq;
+    binframe::FrameType type;
+    uint16_t len;
+    int64_t receivedUs;
+    std::array<char, binframe::MAX_PAYLOAD_SIZE> data;
+  };
+
+  // The members below are owned by the UART RX task, which parses the received bytes and queues
+  // the frames for the controller task.
+  FrameParser parser;
+  binframe::Decoder binDecoder;
+  binframe::Encoder rxEncoder;
+  TickType_t lastBinaryFrameTime = 0;
+  // Binary framing which was negotiated with the PROTOCOL command. Written by the RX task.
+  std::atomic<bool> binaryMode = false;
+  SpscRing<UartCommand, CMD_RING_SIZE> cmdRing;
+
+  binframe::Encoder binEncoder;
+  // The current command is part of a binary frame, so its reply goes into the response frame
+  bool replyToFrame = false;
+  // Reply payload length of the current command in binary mode
+  size_t replyLen = 0;
+
+  // Telemetry subscription, the period is 0 if no host is subscribed
+  uint32_t telemetryPeriodMs = 0;
+  TickType_t lastTelemetryTime = 0;
+  telemetry::Sample lastTelemetry = {};
+  uint8_t telemetrySeq = 0;
+  uint32_t telemetryDropped = 0;
+
+  // CPU cycles spent in the command handling, including the reply
+  struct CommandStats {
+    uint32_t commands = 0;
+    uint32_t lastCycles = 0;
+    uint32_t maxCycles = 0;
+    uint64_t totalCycles = 0;
+    // Time from the frame reception until the controller handles it
+    uint32_t lastLatencyUs = 0;
+    uint32_t maxLatencyUs = 0;
+    // Frames dropped by the RX task because the command ring was full
+    uint32_t queueDrops = 0;
+  } cmdStats;
 
   TickType_t startTime = 0;
+  // Last wakeup or command reception. Used to keep the device awake for a while in low power
+  // mode.
+  TickType_t lastActivityTime = 0;
   TickType_t motorStartTime = 0;
+  time_t motorStartEpoch = 0;
   i2c_dev_t i2c = {};
   LedCfg motorOpCfg;
   LedCfg normalCfg;
@@ -120,23 +281,84 @@ class Controller {
 
   bool initPrintSwitch = true;
   bool forcedOp = false;
+  // The last opening ran for the full open duration
+  bool doorFullyOpen = false;
+  // The current close started from a fully opened door, so its duration is a travel time sample
+  bool closeFromOpen = false;
+  // The current open runs for the fixed open duration, so the next close can be measured
+  bool fullTravelOpen = false;
+  // Motor task operation of the current motor state
+  uint32_t motorOpId = 0;
+  // The motor task reported the end of the current operation
+  std::optional<motortask::Completion> motorCompletion;
 
   // Day from 0 to 30
   int currentDay = -1;
   // Month from 0 to 11
   int currentMonth = -1;
 
-  int currentOpenDayMinutes = 0;
-  int currentCloseDayMinutes = 0;
-
   void task();
+  // Waits for UART events, parses the received bytes and queues the frames for the controller
+  void uartRxTask();
+
+  // Returns the number of ticks until the next time based action of the state machine is due.
+  TickType_t nextWakeupTicks();
+  static void limitWait(TickType_t& waitTicks, TickType_t deadlineTicks);
+  static TickType_t remainingTicks(TickType_t startTicks, uint32_t durationMs);
+  void countWakeup();
+
+  uint32_t getDaySeconds() const;
+  // Returns true if a door operation is due but waits for a door switch change.
+  bool doorOperationPending() const;
+  bool deepSleepAllowed(TickType_t waitTicks);
+  // Programs the DS3231 alarm, stores the application state in the RTC memory and enters deep
+  // sleep.
+  [[noreturn]] void enterDeepSleep(TickType_t sleepTicks);
+  // Returns true if the application state was restored after waking up from deep sleep.
+  bool restoreAfterDeepSleep();
+
+  Snapshot buildSnapshot() const;
+  // Writes the snapshot to the NVS if it has changed since the last write.
+  void persistState();
+  // Returns true if a snapshot of the current day was found and restored.
+  bool restoreSnapshot();
+
+  telemetry::Sample buildTelemetry() const;
+  // Sends a telemetry sample if the state has changed or the period is over. Never blocks.
+  void publishTelemetry();
 
   bool validCmd(char rawCmd);
   void stateMachine();
   // Can be used if time is changed externally to re-trigger any door operations immediately
   void resetToInitState();
-  void handleUartReception();
-  void handleUartCommand(std::string cmd);
+  // RX task side
+  void receiveUartData();
+  // Returns true if the frame was queued
+  bool queueAsciiCommand(std::string_view payload);
+  bool feedBinaryDecoder(uint8_t byte);
+  void sendRxNak(uint8_t seq, binframe::NakReason reason);
+  static bool handshakeValid(std::string_view cmd);
+  // Handles all queued frames
+  void handleUartCommands();
+  // The command is the frame payload without the pattern and the terminator
+  binframe::Result handleUartCommand(std::string_view cmd);
+  binframe::Result handleScheduleCommand(std::string_view cmd);
+  binframe::Result handleProtocolCommand(std::string_view cmd);
+  binframe::Result handleTelemetryCommand(std::string_view cmd);
+  binframe::Result handleJogCommand(std::string_view cmd, bool protOn);
+  binframe::Result handlePositionCommand(std::string_view cmd, bool protOn);
+  binframe::Result handleVentilationCommand(bool protOn);
+  void moveDoor(uint8_t percent, bool protOn);
+  // Handles all commands of a REQUEST frame and sends one RESPONSE frame
+  void handleBinaryFrame(const UartCommand& frame);
+  void sendNak(uint8_t seq, binframe::NakReason reason);
+  void writeBinaryFrame();
+  // Writes a frame which was already finished
+  void writeBinaryFrame(size_t frameLen);
+  // Sends the reply frame in UART_REPLY_BUF. In binary mode, it is added to the response frame.
+  void sendReply(size_t len);
+  void countCommandCycles(uint32_t cycles);
+  void sendScheduleReply(char subCmd, esp_err_t result);
   // This is run after the controller has booted. It checks whether any operations are necessary.
   // Returns 0 if initialization is done, otherwise 1.
   int stateMachineInit();
@@ -144,7 +366,10 @@ class Controller {
   void stateMachineNormal();
 
   void updateCurrentDayAndMonth();
-  void updateCurrentOpenCloseTimes(bool printTimes);
+  // Evaluates the schedule rules for the current day. Only events after the handled time are
+  // kept.
+  void updateDayPlan(bool printEvents);
+  void printDayPlan();
   int initOpen();
   int initClose();
   void motorCtrlDone();
@@ -152,7 +377,11 @@ class Controller {
 
   void openDoor();
   void closeDoor();
-  void driveDoorMotor(bool dir1);
+  void driveDoorMotor(bool close);
+  void sendMotorCommand(const motortask::Command& cmd);
+  void stopMotor();
+  // Takes the completions of the motor task
+  void handleMotorEvents();
   void checkRecheckMechanism();
 
   /**
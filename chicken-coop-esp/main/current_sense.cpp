@@ -0,0 +1,243 @@
+#include "current_sense.h"
+
+#include <freertos/task.h>
+
+#ifdef CONFIG_MOTOR_CURRENT_SENSE
+
+#include <esp_adc/adc_cali.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include <esp_adc/adc_continuous.h>
+#include <esp_log.h>
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+
+#include "motor_backend.h"
+#include "sample_source.h"
+#include "stall_detector.h"
+
+static constexpr char CURRENT_TAG[] = "current";
+
+static constexpr adc_channel_t CHANNEL =
+    static_cast<adc_channel_t>(CONFIG_MOTOR_CURRENT_SENSE_CHANNEL);
+
+// ADC1 channel n is GPIO n, which must not be shared with another function
+static_assert(CONFIG_MOTOR_CURRENT_SENSE_CHANNEL != CONFIG_I2C_SDA_PORT and
+                  CONFIG_MOTOR_CURRENT_SENSE_CHANNEL != CONFIG_I2C_SCL_PORT and
+                  CONFIG_MOTOR_CURRENT_SENSE_CHANNEL != CONFIG_DOOR_SWITCH_STATE_PORT,
+              "Current sense channel shares a GPIO");
+#ifdef CONFIG_MOTOR_BACKEND_DC
+static_assert(CONFIG_MOTOR_CURRENT_SENSE_CHANNEL != CONFIG_MOTOR_PORT_0 and
+                  CONFIG_MOTOR_CURRENT_SENSE_CHANNEL != CONFIG_MOTOR_PORT_1,
+              "Current sense channel shares a GPIO with the motor");
+#endif
+#ifdef CONFIG_RTC_INT_SQW_PORT
+static_assert(CONFIG_MOTOR_CURRENT_SENSE_CHANNEL != CONFIG_RTC_INT_SQW_PORT,
+              "Current sense channel shares a GPIO with the DS3231 INT/SQW output");
+#endif
+#ifdef CONFIG_DOOR_TOP_LIMIT
+static_assert(CONFIG_MOTOR_CURRENT_SENSE_CHANNEL != CONFIG_DOOR_TOP_LIMIT_PORT,
+              "Current sense channel shares a GPIO with the top limit switch");
+#endif
+// Input range of about 0 to 750 mV
+static constexpr adc_atten_t ATTEN = ADC_ATTEN_DB_0;
+static constexpr uint32_t UNCALIBRATED_FULL_SCALE_MV = 750;
+static constexpr uint32_t MAX_RAW = (1 << SOC_ADC_DIGI_MAX_BITWIDTH) - 1;
+static constexpr size_t BLOCK_BYTES = currentsense::BLOCK_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES;
+static constexpr uint32_t READ_TIMEOUT_MS = 100;
+
+static constexpr uint16_t blocksFor(uint32_t ms) {
+  return (ms * 1000 + currentsense::BLOCK_PERIOD_US - 1) / currentsense::BLOCK_PERIOD_US;
+}
+
+/**
+ * Reads the shunt voltage with the ADC in continuous DMA mode.
+ */
+class AdcSampleSource : public SampleSource {
+ public:
+  esp_err_t init() {
+    adc_continuous_handle_cfg_t handleCfg = {};
+    handleCfg.max_store_buf_size = BLOCK_BYTES * 4;
+    handleCfg.conv_frame_size = BLOCK_BYTES;
+    esp_err_t result = adc_continuous_new_handle(&handleCfg, &handle);
+    if (result != ESP_OK) {
+      return result;
+    }
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = ATTEN;
+    pattern.channel = CHANNEL;
+    pattern.unit = ADC_UNIT_1;
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    adc_continuous_config_t digiCfg = {};
+    digiCfg.sample_freq_hz = currentsense::SAMPLE_RATE_HZ;
+    digiCfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digiCfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    digiCfg.pattern_num = 1;
+    digiCfg.adc_pattern = &pattern;
+    return adc_continuous_config(handle, &digiCfg);
+  }
+
+  bool start() override {
+    // The pool still holds the samples from the end of the last movement
+    ESP_ERROR_CHECK_WITHOUT_ABORT(adc_continuous_flush_pool(handle));
+    return adc_continuous_start(handle) == ESP_OK;
+  }
+
+  void stop() override { ESP_ERROR_CHECK_WITHOUT_ABORT(adc_continuous_stop(handle)); }
+
+  bool readBlock(uint16_t& blockMean, uint32_t timeoutMs) override {
+    uint32_t readLen = 0;
+    if (adc_continuous_read(handle, buf.data(), buf.size(), &readLen, timeoutMs) != ESP_OK) {
+      return false;
+    }
+    uint32_t sum = 0;
+    uint32_t count = 0;
+    for (size_t idx = 0; idx + SOC_ADC_DIGI_RESULT_BYTES <= readLen;
+         idx += SOC_ADC_DIGI_RESULT_BYTES) {
+      auto* result = reinterpret_cast<const adc_digi_output_data_t*>(&buf[idx]);
+      if (result->type2.unit == ADC_UNIT_1 and result->type2.channel == CHANNEL) {
+        sum += result->type2.data;
+        count++;
+      }
+    }
+    if (count == 0) {
+      return false;
+    }
+    blockMean = sum / count;
+    return true;
+  }
+
+ private:
+  adc_continuous_handle_t handle = nullptr;
+  std::array<uint8_t, BLOCK_BYTES> buf = {};
+};
+
+static AdcSampleSource ADC_SOURCE;
+static SampleSource& SOURCE = ADC_SOURCE;
+static adc_cali_handle_t CALI = nullptr;
+static StallDetector DETECTOR{{}};
+static TaskHandle_t CURRENT_TASK = nullptr;
+static TaskHandle_t EVENT_TASK = nullptr;
+static std::atomic<bool> STALLED = false;
+static currentsense::Stats STATS = {};
+
+static uint32_t rawToMa(uint32_t raw) {
+  int mv = 0;
+  if (CALI == nullptr or adc_cali_raw_to_voltage(CALI, raw, &mv) != ESP_OK) {
+    mv = raw * UNCALIBRATED_FULL_SCALE_MV / MAX_RAW;
+  }
+  return static_cast<uint32_t>(mv) * 1000 / CONFIG_MOTOR_SHUNT_RESISTANCE;
+}
+
+esp_err_t currentsense::init() {
+  adc_cali_curve_fitting_config_t caliCfg = {};
+  caliCfg.unit_id = ADC_UNIT_1;
+  caliCfg.chan = CHANNEL;
+  caliCfg.atten = ATTEN;
+  caliCfg.bitwidth = ADC_BITWIDTH_DEFAULT;
+  if (adc_cali_create_scheme_curve_fitting(&caliCfg, &CALI) != ESP_OK) {
+    ESP_LOGW(CURRENT_TAG, "ADC calibration not available, using the nominal range");
+    CALI = nullptr;
+  }
+  // The detector works on raw values, so the threshold is converted once
+  uint16_t thresholdRaw = MAX_RAW;
+  for (uint32_t raw = 0; raw <= MAX_RAW; raw++) {
+    if (rawToMa(raw) >= CONFIG_MOTOR_STALL_CURRENT) {
+      thresholdRaw = raw;
+      break;
+    }
+  }
+  StallConfig cfg = {};
+  cfg.thresholdRaw = thresholdRaw;
+  cfg.stallBlocks = blocksFor(CONFIG_MOTOR_STALL_TIME);
+  cfg.blankingBlocks = blocksFor(CONFIG_MOTOR_INRUSH_BLANKING);
+  cfg.filterShift = FILTER_SHIFT;
+  DETECTOR = StallDetector(cfg);
+  ESP_LOGI(CURRENT_TAG, "Stall threshold %d mA (raw %u), %u stall blocks, %u blanking blocks",
+           CONFIG_MOTOR_STALL_CURRENT, cfg.thresholdRaw, cfg.stallBlocks, cfg.blankingBlocks);
+  return ADC_SOURCE.init();
+}
+
+void currentsense::setEventTask(TaskHandle_t task) { EVENT_TASK = task; }
+
+void currentsense::motorStarted() {
+  if (CURRENT_TASK != nullptr) {
+    xTaskNotifyGive(CURRENT_TASK);
+  }
+}
+
+bool currentsense::takeStall() { return STALLED.exchange(false); }
+
+const currentsense::Stats& currentsense::stats() { return STATS; }
+
+static void handleStall(uint32_t motorStarts) {
+  // The motor task might have restarted the motor since the block was read. The motor task ends
+  // the movement with stop() once it takes the stall.
+  if (MotorBackend::startCount() != motorStarts) {
+    return;
+  }
+  MotorBackend::hardStop();
+  STATS.stalls++;
+  STATS.lastStallMs = DETECTOR.blockCount() * currentsense::BLOCK_PERIOD_US / 1000;
+  STATS.lastStallMa = rawToMa(DETECTOR.filteredValue());
+  STALLED = true;
+  if (EVENT_TASK != nullptr) {
+    xTaskNotifyGive(EVENT_TASK);
+  }
+}
+
+void currentsense::task(void* args) {
+  CURRENT_TASK = xTaskGetCurrentTaskHandle();
+  uint32_t motorStarts = 0;
+  bool sampling = false;
+  while (true) {
+    if (not sampling) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      if (not MotorBackend::active() or not SOURCE.start()) {
+        continue;
+      }
+      sampling = true;
+    }
+    // Direction changes restart the motor without stopping it
+    if (MotorBackend::startCount() != motorStarts) {
+      motorStarts = MotorBackend::startCount();
+      DETECTOR.reset();
+    }
+    uint16_t blockMean = 0;
+    // A block which overlaps a restart mixes both movements and is dropped
+    if (SOURCE.readBlock(blockMean, READ_TIMEOUT_MS) and
+        MotorBackend::startCount() == motorStarts) {
+#ifdef CONFIG_MOTOR_CURRENT_TRACE
+      printf("CT,%lu,%u\n", DETECTOR.blockCount() * BLOCK_PERIOD_US / 1000, blockMean);
+#endif
+      if (DETECTOR.feed(blockMean)) {
+        handleStall(motorStarts);
+      }
+    }
+    if (not MotorBackend::active()) {
+      SOURCE.stop();
+      sampling = false;
+      STATS.lastPeakMa = rawToMa(DETECTOR.peak());
+    }
+  }
+}
+
+#else
+
+esp_err_t currentsense::init() { return ESP_OK; }
+
+void currentsense::setEventTask(TaskHandle_t task) {}
+
+void currentsense::motorStarted() {}
+
+bool currentsense::takeStall() { return false; }
+
+const currentsense::Stats& currentsense::stats() {
+  static constexpr Stats STATS = {};
+  return STATS;
+}
+
+void currentsense::task(void* args) { vTaskDelete(nullptr); }
+
+#endif
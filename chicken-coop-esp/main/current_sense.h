@@ -0,0 +1,65 @@
+#ifndef MAIN_CURRENT_SENSE_H_
+#define MAIN_CURRENT_SENSE_H_
+
+#include <freertos/FreeRTOS.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+/**
+ * Motor current sensing with a shunt resistor. The ADC samples the shunt voltage in continuous
+ * DMA mode while the motor is active. The current task averages the samples of each DMA block
+ * and feeds them to the stall detector. On a stall, the task cuts the motor outputs itself, so
+ * the reaction does not depend on the controller loop, and notifies the event task afterwards.
+ * The motor task ends the movement when it takes the stall.
+ */
+namespace currentsense {
+
+#ifdef CONFIG_MOTOR_CURRENT_SENSE
+static constexpr bool ENABLED = true;
+#else
+static constexpr bool ENABLED = false;
+#endif
+
+static constexpr uint32_t SAMPLE_RATE_HZ = 16000;
+static constexpr size_t BLOCK_SAMPLES = 64;
+static constexpr uint32_t BLOCK_PERIOD_US = BLOCK_SAMPLES * 1000 * 1000 / SAMPLE_RATE_HZ;
+// The filter time constant is about 2^FILTER_SHIFT blocks
+static constexpr uint8_t FILTER_SHIFT = 2;
+
+struct Stats {
+  uint32_t stalls;
+  // Motor runtime until the last stall
+  uint32_t lastStallMs;
+  uint32_t lastStallMa;
+  // Highest filtered current of the last movement after the inrush blanking
+  uint32_t lastPeakMa;
+};
+
+esp_err_t init();
+
+/**
+ * Task which is notified with xTaskNotifyGive after a stall stopped the motor.
+ */
+void setEventTask(TaskHandle_t task);
+
+/**
+ * Wakes up the current task after the motor was started.
+ */
+void motorStarted();
+
+/**
+ * Returns true once after a stall cut the motor outputs. The caller has to stop the motor.
+ */
+bool takeStall();
+
+const Stats& stats();
+
+void task(void* args);
+
+}  // namespace currentsense
+
+#endif /* MAIN_CURRENT_SENSE_H_ */
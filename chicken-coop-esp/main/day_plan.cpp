@@ -0,0 +1,106 @@
+#include "day_plan.h"
+
+DayPlan::DayPlan(const ScheduleRule* rules, size_t numRules) : rules(rules), numRules(numRules) {
+  if (this->numRules > MAX_RULES) {
+    this->numRules = MAX_RULES;
+  }
+}
+
+void DayPlan::build(const OcTimes* table, time_t now, time_t after) {
+  numEvents = 0;
+  head = 0;
+  time_t today = now - now % SECONDS_PER_DAY;
+  for (int dayOffset = -1; dayOffset <= 1; dayOffset++) {
+    time_t dayStart = today + dayOffset * SECONDS_PER_DAY;
+    tm date = {};
+    gmtime_r(&dayStart, &date);
+    addDay(table[ocTableIndex(date.tm_mon, date.tm_mday - 1)], dayStart, after);
+  }
+}
+
+void DayPlan::addDay(const OcTimes& times, time_t dayStart, time_t after) {
+  // First open and close time of the day, used to check whether ventilation is required
+  int32_t openTime = NO_LIMIT;
+  int32_t closeTime = NO_LIMIT;
+  for (size_t idx = 0; idx < numRules; idx++) {
+    const ScheduleRule& rule = rules[idx];
+    if (rule.kind == RuleKind::VENTILATION) {
+      continue;
+    }
+    int32_t time = rule.seconds;
+    if (not rule.fixed) {
+      uint16_t tableMinutes = rule.kind == RuleKind::OPEN ? times.open : times.close;
+      time += tableMinutes * 60;
+    }
+    if (rule.earliest != NO_LIMIT and time < rule.earliest) {
+      time = rule.earliest;
+    }
+    if (rule.latest != NO_LIMIT and time > rule.latest) {
+      time = rule.latest;
+    }
+    if (rule.kind == RuleKind::OPEN) {
+      if (openTime == NO_LIMIT) {
+        openTime = time;
+      }
+      addEvent(dayStart + time, DoorAction::OPEN, after);
+    } else {
+      if (closeTime == NO_LIMIT) {
+        closeTime = time;
+      }
+      addEvent(dayStart + time, DoorAction::CLOSE, after);
+    }
+  }
+  for (size_t idx = 0; idx < numRules; idx++) {
+    const ScheduleRule& rule = rules[idx];
+    if (rule.kind != RuleKind::VENTILATION) {
+      continue;
+    }
+    int32_t end = rule.seconds + rule.duration;
+    // Only required if the door is closed during the whole cycle
+    bool doorOpen = openTime != NO_LIMIT and closeTime != NO_LIMIT and end > openTime and
+                    rule.seconds < closeTime;
+    if (not doorOpen) {
+      addEvent(dayStart + rule.seconds, DoorAction::OPEN, after);
+      addEvent(dayStart + end, DoorAction::CLOSE, after);
+    }
+  }
+}
+
+void DayPlan::addEvent(time_t epoch, DoorAction action, time_t after) {
+  if (epoch <= after or numEvents == events.size()) {
+    return;
+  }
+  // Insertion sort, events with the same time keep the order of the rules
+  size_t pos = numEvents;
+  while (pos > 0 and events[pos - 1].epoch > epoch) {
+    events[pos] = events[pos - 1];
+    pos--;
+  }
+  events[pos] = Event{epoch, action};
+  numEvents++;
+}
+
+DoorAction DayPlan::popDue(time_t now, time_t& eventEpoch) {
+  DoorAction action = DoorAction::NONE;
+  while (due(now)) {
+    action = events[head].action;
+    eventEpoch = events[head].epoch;
+    head++;
+  }
+  return action;
+}
+
+DoorAction DayPlan::actionAt(time_t time) const {
+  DoorAction action = DoorAction::CLOSE;
+  for (size_t idx = 0; idx < numEvents and events[idx].epoch <= time; idx++) {
+    action = events[idx].action;
+  }
+  return action;
+}
+
+time_t DayPlan::nextEpoch() const {
+  if (head == numEvents) {
+    return -1;
+  }
+  return events[head].epoch;
+}
@@ -0,0 +1,162 @@
+#ifndef MAIN_DAY_PLAN_H_
+#define MAIN_DAY_PLAN_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "oc_table.h"
+#include "sdkconfig.h"
+
+enum class DoorAction : uint8_t { NONE = 0, OPEN = 1, CLOSE = 2 };
+
+enum class RuleKind : uint8_t { OPEN, CLOSE, VENTILATION };
+
+// Unused earliest or latest limit
+static constexpr int32_t NO_LIMIT = -1;
+
+/**
+ * A rule yields a door event for each day. Times are in seconds relative to the start of the
+ * respective day and might lie before or after that day.
+ */
+struct ScheduleRule {
+  RuleKind kind;
+  // Fixed rules use the seconds as time of the day. Otherwise, the seconds are an offset to the
+  // open or close time of the open-close table.
+  int32_t seconds;
+  bool fixed;
+  // Limits of the resulting time of the day, NO_LIMIT if unused
+  int32_t earliest;
+  int32_t latest;
+  // Ventilation rules only. The door is opened at the given time and closed again after the
+  // duration, if it would be closed for the whole cycle otherwise.
+  int32_t duration;
+};
+
+/**
+ * Parses a time of the day in the format HH:MM or HH:MM:SS. Returns NO_LIMIT for an empty
+ * string and -2 for an invalid string.
+ */
+constexpr int32_t parseDayTime(const char* str) {
+  if (str[0] == '\0') {
+    return NO_LIMIT;
+  }
+  int32_t fields[3] = {};
+  size_t field = 0;
+  size_t digits = 0;
+  for (size_t idx = 0; str[idx] != '\0'; idx++) {
+    if (str[idx] == ':' and digits == 2 and field < 2) {
+      field++;
+      digits = 0;
+    } else if (str[idx] >= '0' and str[idx] <= '9' and digits < 2) {
+      fields[field] = fields[field] * 10 + (str[idx] - '0');
+      digits++;
+    } else {
+      return -2;
+    }
+  }
+  if (field == 0 or digits != 2 or fields[0] > 23 or fields[1] > 59 or fields[2] > 59) {
+    return -2;
+  }
+  return fields[0] * 3600 + fields[1] * 60 + fields[2];
+}
+
+/**
+ * Door events of a few days as a sorted array of absolute times. The rules are only evaluated
+ * when the plan is built, which is done once a day. Checking whether an event is due is a single
+ * comparison against the next event.
+ *
+ * The plan always contains the events of the day before and after the current day as well, so
+ * events which are shifted across midnight are handled.
+ */
+class DayPlan {
+ public:
+  static constexpr size_t MAX_RULES = 8;
+  static constexpr size_t DAYS = 3;
+  static constexpr size_t MAX_EVENTS = MAX_RULES * 2 * DAYS;
+  static constexpr int32_t SECONDS_PER_DAY = 24 * 60 * 60;
+
+  struct Event {
+    time_t epoch;
+    DoorAction action;
+  };
+
+  DayPlan(const ScheduleRule* rules, size_t numRules);
+
+  /**
+   * Evaluates the rules for the day of the given time and its neighbours. Only events after the
+   * given time are kept.
+   * @param table Open-close table used by the table based rules
+   */
+  void build(const OcTimes* table, time_t now, time_t after);
+
+  bool due(time_t now) const { return head < numEvents and events[head].epoch <= now; }
+
+  /**
+   * Consumes all due events. Returns the action of the last due event, which determines the
+   * door state, and its time.
+   */
+  DoorAction popDue(time_t now, time_t& eventEpoch);
+
+  /**
+   * Door state expected by the plan at the given time. The door is expected to be closed
+   * before the first event.
+   */
+  DoorAction actionAt(time_t time) const;
+
+  // Returns -1 if there is no pending event
+  time_t nextEpoch() const;
+
+  size_t pendingEvents() const { return numEvents - head; }
+  const Event& pendingEvent(size_t idx) const { return events[head + idx]; }
+
+ private:
+  const ScheduleRule* rules;
+  size_t numRules;
+  std::array<Event, MAX_EVENTS> events = {};
+  size_t numEvents = 0;
+  size_t head = 0;
+
+  void addDay(const OcTimes& times, time_t dayStart, time_t after);
+  void addEvent(time_t epoch, DoorAction action, time_t after);
+};
+
+/**
+ * Creates an open or close rule. The rule is table based if the fixed time is empty.
+ */
+constexpr ScheduleRule makeRule(RuleKind kind, const char* fixedTime, int32_t offset,
+                                const char* earliest, const char* latest) {
+  int32_t fixedSeconds = parseDayTime(fixedTime);
+  bool fixed = fixedSeconds != NO_LIMIT;
+  return ScheduleRule{kind, fixed ? fixedSeconds : offset, fixed, parseDayTime(earliest),
+                      parseDayTime(latest), 0};
+}
+
+constexpr bool ruleValid(const ScheduleRule& rule) {
+  return not(rule.fixed and rule.seconds < 0) and rule.earliest != -2 and rule.latest != -2;
+}
+
+// Rules from the project configuration
+inline constexpr ScheduleRule CONFIG_SCHEDULE_RULES[] = {
+    makeRule(RuleKind::OPEN, CONFIG_SCHEDULE_OPEN_FIXED, CONFIG_SCHEDULE_OPEN_OFFSET,
+             CONFIG_SCHEDULE_OPEN_EARLIEST, CONFIG_SCHEDULE_OPEN_LATEST),
+    makeRule(RuleKind::CLOSE, CONFIG_SCHEDULE_CLOSE_FIXED, CONFIG_SCHEDULE_CLOSE_OFFSET,
+             CONFIG_SCHEDULE_CLOSE_EARLIEST, CONFIG_SCHEDULE_CLOSE_LATEST),
+#ifdef CONFIG_SCHEDULE_VENTILATION
+    ScheduleRule{RuleKind::VENTILATION, parseDayTime(CONFIG_SCHEDULE_VENTILATION_START), true,
+                 NO_LIMIT, NO_LIMIT, CONFIG_SCHEDULE_VENTILATION_DURATION},
+#endif
+};
+
+static constexpr size_t CONFIG_SCHEDULE_RULE_NUM =
+    sizeof(CONFIG_SCHEDULE_RULES) / sizeof(ScheduleRule);
+static_assert(CONFIG_SCHEDULE_RULE_NUM <= DayPlan::MAX_RULES, "Too many schedule rules");
+static_assert(ruleValid(CONFIG_SCHEDULE_RULES[0]) and ruleValid(CONFIG_SCHEDULE_RULES[1]),
+              "Schedule times must have the format HH:MM or HH:MM:SS");
+#ifdef CONFIG_SCHEDULE_VENTILATION
+static_assert(ruleValid(CONFIG_SCHEDULE_RULES[2]),
+              "Ventilation start must have the format HH:MM or HH:MM:SS");
+#endif
+
+#endif /* MAIN_DAY_PLAN_H_ */
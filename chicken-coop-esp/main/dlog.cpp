@@ -0,0 +1,100 @@
+#include "dlog.h"
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdio>
+
+#include "binary_frame.h"
+#include "spsc_ring.h"
+
+static constexpr char DLOG_TAG[] = "dlog";
+
+static SpscRing<dlog::Record, CONFIG_DEFERRED_LOG_BUFFER> RING;
+// Only written by the producer
+static uint32_t DROPPED = 0;
+// Notified on every committed record, so the log task only runs if there is something to do
+static TaskHandle_t LOG_TASK = nullptr;
+
+dlog::Record* dlog::detail::acquire(Msg msg) {
+  Record* record = RING.writeSlot();
+  if (record == nullptr) {
+    DROPPED++;
+    return nullptr;
+  }
+  record->timestampMs = esp_log_timestamp();
+  record->msg = msg;
+  return record;
+}
+
+void dlog::detail::commit() {
+  RING.commit();
+  if (LOG_TASK != nullptr) {
+    xTaskNotifyGive(LOG_TASK);
+  }
+}
+
+#ifdef CONFIG_DEFERRED_LOG_HOST_DICTIONARY
+
+static binframe::Encoder ENCODER;
+static uint8_t FRAME_SEQ = 0;
+
+static void emit(const dlog::Record& record) {
+  // Only the used arguments are sent
+  size_t len = sizeof(record) - (dlog::MAX_ARGS - record.argc) * sizeof(uint32_t);
+  ENCODER.begin(binframe::FrameType::LOG, FRAME_SEQ++);
+  ENCODER.append(reinterpret_cast<const uint8_t*>(&record), len);
+  size_t frameLen = ENCODER.finish();
+  fwrite(ENCODER.data(), 1, frameLen, stdout);
+  fflush(stdout);
+}
+
+#else
+
+struct MessageInfo {
+  esp_log_level_t level;
+  const char* tag;
+  const char* fmt;
+};
+
+#define DLOG_INFO_ENTRY(id, level, tag, fmt) {ESP_LOG_##level, tag, fmt},
+static constexpr MessageInfo MESSAGES[] = {DLOG_MESSAGES(DLOG_INFO_ENTRY)};
+#undef DLOG_INFO_ENTRY
+
+static constexpr char LEVEL_CHARS[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+
+static void emit(const dlog::Record& record) {
+  const MessageInfo& info = MESSAGES[static_cast<size_t>(record.msg)];
+  if (esp_log_level_get(info.tag) < info.level) {
+    return;
+  }
+  char msg[160];
+  // Unused arguments are ignored by snprintf
+  snprintf(msg, sizeof(msg), info.fmt, record.args[0], record.args[1], record.args[2],
+           record.args[3]);
+  // Same layout as ESP_LOG, but with the time stamp of the log call
+  esp_log_write(info.level, info.tag, "%c (%lu) %s: %s\n", LEVEL_CHARS[info.level],
+                record.timestampMs, info.tag, msg);
+}
+
+#endif
+
+void dlog::task(void* args) {
+  LOG_TASK = xTaskGetCurrentTaskHandle();
+  uint32_t reportedDrops = 0;
+  // Records which were committed before the task started are handled right away
+  while (true) {
+    const Record* record = nullptr;
+    while ((record = RING.front()) != nullptr) {
+      emit(*record);
+      RING.pop();
+    }
+    uint32_t dropped = DROPPED;
+    if (dropped != reportedDrops) {
+      ESP_LOGW(DLOG_TAG, "%lu log records were dropped", dropped - reportedDrops);
+      reportedDrops = dropped;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
@@ -0,0 +1,65 @@
+#ifndef MAIN_DLOG_H_
+#define MAIN_DLOG_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "dlog_messages.h"
+#include "sdkconfig.h"
+
+/**
+ * Deferred logging. A log call only records the message ID, the timestamp and the raw arguments
+ * in a ring buffer, which takes a few hundred CPU cycles instead of formatting the message and
+ * writing it to the console synchronously. The log task formats the records later with low
+ * priority. With CONFIG_DEFERRED_LOG_HOST_DICTIONARY, the records are sent to the host as
+ * binary frames instead and the format strings are not part of the firmware.
+ *
+ * The ring buffer has a single producer, so log() must only be called from the controller task.
+ * Other tasks use ESP_LOG.
+ */
+namespace dlog {
+
+static constexpr size_t MAX_ARGS = 4;
+
+#define DLOG_ENUM_ENTRY(id, level, tag, fmt) id,
+enum class Msg : uint16_t { DLOG_MESSAGES(DLOG_ENUM_ENTRY) };
+#undef DLOG_ENUM_ENTRY
+
+struct Record {
+  uint32_t timestampMs;
+  Msg msg;
+  uint8_t argc;
+  uint8_t reserved;
+  uint32_t args[MAX_ARGS];
+};
+
+namespace detail {
+
+// Returns the next free record with the timestamp and message ID set or nullptr if the buffer is
+// full.
+Record* acquire(Msg msg);
+void commit();
+
+}  // namespace detail
+
+template <typename... Args>
+inline void log(Msg msg, Args... args) {
+  static_assert(sizeof...(Args) <= MAX_ARGS, "Too many deferred log arguments");
+  Record* record = detail::acquire(msg);
+  if (record == nullptr) {
+    return;
+  }
+  record->argc = sizeof...(Args);
+  size_t idx = 0;
+  ((record->args[idx++] = static_cast<uint32_t>(args)), ...);
+  detail::commit();
+}
+
+/**
+ * Formats or sends the buffered records. Runs with a low priority.
+ */
+void task(void* args);
+
+}  // namespace dlog
+
+#endif /* MAIN_DLOG_H_ */
@@ -0,0 +1,66 @@
+#ifndef MAIN_DLOG_MESSAGES_H_
+#define MAIN_DLOG_MESSAGES_H_
+
+/**
+ * Dictionary of the deferred log messages: ID, level, tag and format string. The arguments are
+ * recorded as 32-bit values, so only integer and character conversions are allowed and at most
+ * dlog::MAX_ARGS arguments. New messages must be appended at the end, the host dictionary uses
+ * the position as message ID. scripts/dlog-decode.py parses this list.
+ */
+#define DLOG_MESSAGES(X)                                                                       \
+  X(GOING_INIT, INFO, "ctrl", "Going into INIT mode")                                          \
+  X(GOING_NORMAL, INFO, "ctrl", "Going to NORMAL mode")                                        \
+  X(NEW_DAY, INFO, "ctrl", "New day has started. Evaluating the schedule rules")               \
+  X(OPENING_DUE, INFO, "ctrl", "Scheduled opening is due")                                     \
+  X(CLOSING_DUE, INFO, "ctrl", "Scheduled closing is due")                                     \
+  X(NORMAL_OPENING, INFO, "ctrl", "Opening door in IDLE mode")                                 \
+  X(NORMAL_OPEN_DONE, INFO, "ctrl", "Door opening operation in NORMAL mode done")              \
+  X(NORMAL_CLOSING, INFO, "ctrl", "Closing door in NORMAL mode")                               \
+  X(NORMAL_CLOSE_DONE, INFO, "ctrl", "Door closing operation in NORMAL mode done")             \
+  X(OPEN_SWITCH_MISMATCH, WARN, "ctrl",                                                        \
+    "Door should be opened but is closed according to switch")                                 \
+  X(CLOSE_SWITCH_MISMATCH, WARN, "ctrl",                                                       \
+    "Door should be closed but is open according to switch")                                   \
+  X(RECHECK_ARMED, INFO, "ctrl", "Door Recheck: Door closed, rechecking soon")                 \
+  X(RECHECK_RETRY, INFO, "ctrl", "Closing Recheck: Door not closed, re-trying")                \
+  X(RECHECK_OK, INFO, "ctrl", "Closing Recheck: Door is closed, OK")                           \
+  X(RECHECK_REARM, INFO, "ctrl", "Closing Recheck: Rearming")                                  \
+  X(INIT_OPENING, INFO, "ctrl", "Door needs to be opened in INIT mode. Opening door")          \
+  X(INIT_OPEN_DONE, INFO, "ctrl", "Door was opened in INIT mode")                              \
+  X(INIT_CLOSING, INFO, "ctrl", "Door needs to be closed in INIT mode. Closing door")          \
+  X(INIT_CLOSE_DONE, INFO, "ctrl", "Door was closed in INIT mode")                             \
+  X(PING, INFO, "ctrl", "Ping detected")                                                       \
+  X(CMD_RECEIVED, INFO, "ctrl", "Received command %c%c with %lu bytes")                        \
+  X(BIN_CMD_RECEIVED, INFO, "ctrl", "Received binary command %c%c with %lu bytes")             \
+  X(INVALID_CMD, WARN, "ctrl", "Invalid command byte %c detected")                             \
+  X(INVALID_MODE_CMD, WARN, "ctrl", "Invalid mode command detected")                           \
+  X(MANUAL_MODE, INFO, "ctrl", "Switching to manual mode")                                     \
+  X(MANUAL_MODE_BUSY, WARN, "ctrl",                                                            \
+    "Can not switch to manual mode while door operation is pending")                           \
+  X(NORMAL_MODE, INFO, "ctrl", "Switching to normal mode")                                     \
+  X(INVALID_MODE, WARN, "ctrl",                                                                \
+    "Invalid mode specifier %c detected, M (manual) and N (normal) allowed")                   \
+  X(INVALID_REQUEST_CMD, WARN, "ctrl", "Invalid print command detected")                       \
+  X(INVALID_REQUEST, WARN, "ctrl", "Invalid request %c detected")                              \
+  X(INVALID_MOTOR_CMD, WARN, "ctrl", "Invalid motor control command detected")                 \
+  X(MOTOR_NOT_MANUAL, WARN, "ctrl",                                                            \
+    "Received motor control command but not in manual mode. Activate manual mode first")       \
+  X(ALREADY_OPEN, WARN, "ctrl", "Door opening was requested but the door is already open")     \
+  X(ALREADY_CLOSED, WARN, "ctrl",                                                              \
+    "Door closing was requested but the door is already closed")                               \
+  X(MANUAL_OPEN, INFO, "ctrl", "Opening door in manual mode")                                  \
+  X(MANUAL_CLOSE, INFO, "ctrl", "Closing door in manual mode")                                 \
+  X(MANUAL_STOP, INFO, "ctrl", "Stopping motor in manual mode")                                \
+  X(INVALID_MOTOR_DIR, WARN, "ctrl", "Invalid motor direction %c detected")                    \
+  X(BIN_RESPONSE_FULL, WARN, "ctrl", "Binary response full, dropping result")                  \
+  X(UART_WRITE_FAILED, WARN, "ctrl", "UART write failed with code: %ld")                       \
+  X(TRAVEL_SAMPLE, INFO, "travel", "Door closed after %lu ms, travel time estimate %lu ms")    \
+  X(TRAVEL_TIMEOUT, WARN, "travel",                                                            \
+    "Door was not closed after %lu ms, travel time estimate extended to %lu ms")               \
+  X(MOTOR_STALL, WARN, "ctrl", "Motor was stopped because of a stall after %lu ms at %lu mA")  \
+  X(MANUAL_JOG, INFO, "ctrl", "Jogging door in direction %c for %lu ms in manual mode")        \
+  X(MANUAL_POSITION, INFO, "ctrl", "Moving door to %lu percent of the travel in manual mode")  \
+  X(INIT_DIRECTION_CHANGE, WARN, "ctrl",                                                       \
+    "Stopping resumed motor operation in the wrong direction")
+
+#endif /* MAIN_DLOG_MESSAGES_H_ */
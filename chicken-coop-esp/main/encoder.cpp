@@ -0,0 +1,221 @@
+#include "encoder.h"
+
+#ifdef CONFIG_MOTOR_ENCODER
+
+#include <driver/gpio.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+
+#include "encoder_tracker.h"
+#include "pulse_source.h"
+#include "storage.h"
+#include "switch.h"
+
+static constexpr char ENCODER_TAG[] = "encoder";
+
+static constexpr gpio_num_t PIN_A = static_cast<gpio_num_t>(CONFIG_MOTOR_ENCODER_A_PORT);
+static constexpr bool QUADRATURE = CONFIG_MOTOR_ENCODER_B_PORT >= 0;
+static constexpr gpio_num_t PIN_B =
+    static_cast<gpio_num_t>(QUADRATURE ? CONFIG_MOTOR_ENCODER_B_PORT : 0);
+
+// Count change for the previous and the current AB state. Invalid transitions, where both
+// inputs changed, are ignored.
+static constexpr std::array<int8_t, 16> QUADRATURE_STEPS = {0,  -1, 1, 0, 1, 0, 0,  -1,
+                                                            -1, 0,  0, 1, 0, 1, -1, 0};
+
+/**
+ * Counts the edges of the encoder inputs in GPIO interrupts. Only the ISR writes the count, so
+ * plain atomic loads and stores are enough. The ESP32-C3 has no atomic read-modify-write
+ * instructions, so fetch_add would not be lock-free.
+ */
+class GpioPulseSource : public PulseSource {
+ public:
+  bool start() override {
+    gpio_config_t cfg = {};
+    cfg.pin_bit_mask = 1ULL << PIN_A;
+    if (QUADRATURE) {
+      cfg.pin_bit_mask |= 1ULL << PIN_B;
+    }
+    cfg.mode = GPIO_MODE_INPUT;
+    cfg.pull_up_en = GPIO_PULLUP_ENABLE;
+    cfg.intr_type = GPIO_INTR_ANYEDGE;
+    if (gpio_config(&cfg) != ESP_OK) {
+      return false;
+    }
+    state = readState();
+    // The door switch already installed the ISR service
+    esp_err_t result = gpio_install_isr_service(0);
+    if (result != ESP_OK and result != ESP_ERR_INVALID_STATE) {
+      return false;
+    }
+    if (QUADRATURE) {
+      return gpio_isr_handler_add(PIN_A, quadratureIsr, this) == ESP_OK and
+             gpio_isr_handler_add(PIN_B, quadratureIsr, this) == ESP_OK;
+    }
+    return gpio_isr_handler_add(PIN_A, hallIsr, this) == ESP_OK;
+  }
+
+  void stop() override {
+    gpio_isr_handler_remove(PIN_A);
+    if (QUADRATURE) {
+      gpio_isr_handler_remove(PIN_B);
+    }
+  }
+
+  void setOpening(bool opening) override { hallStep.store(opening ? 1 : -1); }
+
+  bool read(int32_t& count, uint32_t& timeMs) override {
+    count = pulses.load(std::memory_order_relaxed);
+    timeMs = esp_timer_get_time() / 1000;
+    return true;
+  }
+
+ private:
+  std::atomic<int32_t> pulses = 0;
+  std::atomic<int8_t> hallStep = 1;
+  // Only used by the ISR after the start
+  uint8_t state = 0;
+
+  static uint8_t readState() {
+    uint8_t result = gpio_get_level(PIN_A) << 1;
+    if (QUADRATURE) {
+      result |= gpio_get_level(PIN_B);
+    }
+    return result;
+  }
+
+  static void IRAM_ATTR quadratureIsr(void* args) {
+    GpioPulseSource& source = *reinterpret_cast<GpioPulseSource*>(args);
+    uint8_t newState = readState();
+    int8_t step = QUADRATURE_STEPS[(source.state << 2) | newState];
+    source.state = newState;
+    source.pulses.store(source.pulses.load(std::memory_order_relaxed) + step,
+                        std::memory_order_relaxed);
+  }
+
+  // Rising edges only, so a pulse is counted once
+  static void IRAM_ATTR hallIsr(void* args) {
+    GpioPulseSource& source = *reinterpret_cast<GpioPulseSource*>(args);
+    if (gpio_get_level(PIN_A) == 0) {
+      return;
+    }
+    source.pulses.store(source.pulses.load(std::memory_order_relaxed) +
+                            source.hallStep.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+  }
+};
+
+static GpioPulseSource GPIO_SOURCE;
+static PulseSource& SOURCE = GPIO_SOURCE;
+static EncoderTracker TRACKER{{CONFIG_MOTOR_ENCODER_STALL_TIME, CONFIG_MOTOR_RAMP_UP_TIME,
+                               encoder::SPEED_FILTER_SHIFT}};
+static encoder::Calibration CALIBRATION = {};
+static int32_t COUNT = 0;
+static bool STALL_REPORTED = false;
+
+static int32_t readCount() {
+  uint32_t timeMs = 0;
+  SOURCE.read(COUNT, timeMs);
+  return COUNT;
+}
+
+esp_err_t encoder::init() {
+  esp_err_t result = storage::loadBlob(NVS_KEY, VERSION, &CALIBRATION, sizeof(CALIBRATION));
+  if (result != ESP_OK or CALIBRATION.travelPulses < 0) {
+    if (result != ESP_ERR_NVS_NOT_FOUND) {
+      ESP_LOGW(ENCODER_TAG, "Loading the encoder calibration failed with %s",
+               esp_err_to_name(result));
+    }
+    CALIBRATION = {};
+  }
+  if (not SOURCE.start()) {
+    ESP_LOGE(ENCODER_TAG, "Configuring the encoder inputs failed");
+    return ESP_FAIL;
+  }
+  if (doorswitch::closed()) {
+    TRACKER.home(readCount());
+  }
+  ESP_LOGI(ENCODER_TAG, "%s encoder at GPIO %d, travel length %ld pulses",
+           QUADRATURE ? "Quadrature" : "Hall", CONFIG_MOTOR_ENCODER_A_PORT,
+           CALIBRATION.travelPulses);
+  return ESP_OK;
+}
+
+void encoder::motorStarted(bool opening) {
+  SOURCE.setOpening(opening);
+  uint32_t timeMs = 0;
+  SOURCE.read(COUNT, timeMs);
+  TRACKER.start(COUNT, timeMs);
+  STALL_REPORTED = false;
+#ifdef CONFIG_MOTOR_ENCODER_TRACE
+  // The time stamp 0 marks the start of a movement
+  std::printf("EN,0,%ld\n", COUNT);
+#endif
+}
+
+bool encoder::update() {
+  uint32_t timeMs = 0;
+  SOURCE.read(COUNT, timeMs);
+  bool stalled = TRACKER.feed(COUNT, timeMs);
+#ifdef CONFIG_MOTOR_ENCODER_TRACE
+  std::printf("EN,%lu,%ld\n", TRACKER.movementMs(), COUNT);
+#endif
+  if (stalled and not STALL_REPORTED) {
+    STALL_REPORTED = true;
+    ESP_LOGW(ENCODER_TAG, "No encoder pulse for %d ms, motor stalled at position %ld",
+             CONFIG_MOTOR_ENCODER_STALL_TIME, TRACKER.position(COUNT));
+    return true;
+  }
+  return false;
+}
+
+void encoder::home() { TRACKER.home(readCount()); }
+
+bool encoder::homed() { return TRACKER.homed(); }
+
+int32_t encoder::position() { return TRACKER.position(readCount()); }
+
+int32_t encoder::speed() { return TRACKER.speed(); }
+
+int32_t encoder::travelPulses() { return CALIBRATION.travelPulses; }
+
+bool encoder::calibrateTravel() {
+  int32_t travel = position();
+  if (not homed() or travel < MIN_TRAVEL_PULSES) {
+    ESP_LOGW(ENCODER_TAG, "Ignoring implausible travel length of %ld pulses", travel);
+    return false;
+  }
+  CALIBRATION.travelPulses = travel;
+  ESP_LOGI(ENCODER_TAG, "Calibrated travel length of %ld pulses, peak speed %ld pulses/s",
+           travel, TRACKER.peak());
+  ESP_ERROR_CHECK_WITHOUT_ABORT(
+      storage::storeBlob(NVS_KEY, VERSION, &CALIBRATION, sizeof(CALIBRATION)));
+  return true;
+}
+
+#else
+
+esp_err_t encoder::init() { return ESP_OK; }
+
+void encoder::motorStarted(bool opening) {}
+
+bool encoder::update() { return false; }
+
+void encoder::home() {}
+
+bool encoder::homed() { return false; }
+
+int32_t encoder::position() { return 0; }
+
+int32_t encoder::speed() { return 0; }
+
+int32_t encoder::travelPulses() { return 0; }
+
+bool encoder::calibrateTravel() { return false; }
+
+#endif
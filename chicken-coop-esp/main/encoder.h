@@ -0,0 +1,72 @@
+#ifndef MAIN_ENCODER_H_
+#define MAIN_ENCODER_H_
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+/**
+ * Encoder or hall sensor at the DC motor. The ESP32-C3 has no pulse counter peripheral, so the
+ * edges are counted by GPIO interrupts. With two inputs, the quadrature signal gives the
+ * direction. A single hall input counts in the drive direction of the motor.
+ *
+ * The position is the pulse count from the closed door, which homes the position. The travel
+ * length is calibrated by an open from the closed door which stalls at the top end stop and is
+ * stored in the NVS. Afterwards, opens end at the calibrated position instead of running for
+ * the open duration, and the door can be moved to any position in between.
+ *
+ * All functions except init() are only called by the motor task.
+ */
+namespace encoder {
+
+#ifdef CONFIG_MOTOR_ENCODER
+static constexpr bool ENABLED = true;
+#else
+static constexpr bool ENABLED = false;
+#endif
+
+static constexpr char NVS_KEY[] = "encoder";
+static constexpr uint16_t VERSION = 1;
+static constexpr uint8_t SPEED_FILTER_SHIFT = 2;
+// Shorter travels are not accepted as calibration
+static constexpr int32_t MIN_TRAVEL_PULSES = 50;
+// Movements which start this close to the closed position start from the closed door
+static constexpr int32_t CLOSED_TOLERANCE_PULSES = 10;
+
+struct Calibration {
+  int32_t travelPulses;
+};
+
+esp_err_t init();
+
+void motorStarted(bool opening);
+/**
+ * Must be called regularly while the motor is active. Returns true once after the pulses
+ * stopped while the motor was driven.
+ */
+bool update();
+
+/**
+ * The door switch reports a closed door.
+ */
+void home();
+bool homed();
+int32_t position();
+// Pulses per second, positive while opening
+int32_t speed();
+
+/**
+ * Calibrated travel length in pulses, 0 if there is none yet.
+ */
+int32_t travelPulses();
+
+/**
+ * Uses the current position as the travel length after an open from the closed door stalled at
+ * the top end stop. Returns false if the position is not plausible.
+ */
+bool calibrateTravel();
+
+}  // namespace encoder
+
+#endif /* MAIN_ENCODER_H_ */
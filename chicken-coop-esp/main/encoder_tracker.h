@@ -0,0 +1,88 @@
+#ifndef MAIN_ENCODER_TRACKER_H_
+#define MAIN_ENCODER_TRACKER_H_
+
+#include <cstdint>
+
+/**
+ * Estimates the door position and the motor speed from the encoder pulse count and detects a
+ * stall once no pulse arrived for a while. The position is the pulse count relative to the
+ * closed door, so it is only valid after the door switch homed it. The speed is smoothed with a
+ * fixed-point exponential moving average.
+ *
+ * Takes the pulse count and the time in ms instead of reading the encoder, so
+ * host/encoder_replay.cpp can feed it with the samples of an EN trace.
+ */
+struct EncoderConfig {
+  // Time without a pulse until a stall is detected
+  uint32_t stallMs;
+  // Time after the motor start without stall detection
+  uint32_t blankingMs;
+  // Each speed sample moves the average by 2^-speedShift of its deviation
+  uint8_t speedShift;
+};
+
+class EncoderTracker {
+ public:
+  explicit EncoderTracker(const EncoderConfig& cfg) : cfg(cfg) {}
+
+  // The count at the motor start is the reference of the speed and of the stall time
+  void start(int32_t count, uint32_t timeMs) {
+    startMs = timeMs;
+    lastMs = timeMs;
+    lastPulseMs = timeMs;
+    lastCount = count;
+    speedQ8 = 0;
+    peakSpeed = 0;
+  }
+
+  /**
+   * Adds the current pulse count. Returns true if a stall was detected.
+   */
+  bool feed(int32_t count, uint32_t timeMs) {
+    uint32_t elapsedMs = timeMs - lastMs;
+    if (elapsedMs > 0) {
+      int32_t speed = (count - lastCount) * 1000 / static_cast<int32_t>(elapsedMs);
+      speedQ8 += ((speed << FRACTION_BITS) - speedQ8) >> cfg.speedShift;
+      int32_t absSpeed = speedQ8 < 0 ? -speedQ8 : speedQ8;
+      if ((absSpeed >> FRACTION_BITS) > peakSpeed) {
+        peakSpeed = absSpeed >> FRACTION_BITS;
+      }
+    }
+    if (count != lastCount) {
+      lastPulseMs = timeMs;
+    }
+    lastCount = count;
+    lastMs = timeMs;
+    return timeMs - startMs >= cfg.blankingMs and timeMs - lastPulseMs >= cfg.stallMs;
+  }
+
+  // The door is closed at the given pulse count
+  void home(int32_t count) {
+    zeroCount = count;
+    isHomed = true;
+  }
+  bool homed() const { return isHomed; }
+  int32_t position(int32_t count) const { return count - zeroCount; }
+  // Pulses per second, positive while opening
+  int32_t speed() const { return speedQ8 >> FRACTION_BITS; }
+  // Highest absolute speed since the motor start
+  int32_t peak() const { return peakSpeed; }
+  uint32_t movementMs() const { return lastMs - startMs; }
+  const EncoderConfig& config() const { return cfg; }
+
+ private:
+  static constexpr int FRACTION_BITS = 8;
+
+  EncoderConfig cfg;
+  int32_t zeroCount = 0;
+  bool isHomed = false;
+  uint32_t startMs = 0;
+  uint32_t lastMs = 0;
+  uint32_t lastPulseMs = 0;
+  int32_t lastCount = 0;
+  // Speed with FRACTION_BITS fractional bits
+  int32_t speedQ8 = 0;
+  int32_t peakSpeed = 0;
+};
+
+#endif /* MAIN_ENCODER_TRACKER_H_ */
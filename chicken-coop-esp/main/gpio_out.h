@@ -0,0 +1,68 @@
+#ifndef MAIN_GPIO_OUT_H_
+#define MAIN_GPIO_OUT_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "driver/gpio.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+
+namespace gpioout {
+
+/**
+ * Group of output pins which are written with the W1TC and W1TS registers of the GPIO
+ * peripheral, without the checks of gpio_set_level. A write of the group takes two ordered
+ * stores, so the outputs do not change at the same instant. The pins must be configured as plain
+ * GPIO outputs with gpio_config, a pin routed to another peripheral ignores the writes. This is
+ * why the DC motor does not use a group: the LEDC owns the H-bridge inputs.
+ *
+ * Patterns are written most significant bit first, so bit SIZE - 1 of a pattern is the first pin
+ * of the group. The pin masks of the patterns are computed at compile time.
+ */
+template <gpio_num_t... PINS>
+class PinGroup {
+ public:
+  static_assert(((PINS >= 0 and PINS < 32) and ...), "Pins must be in the first output register");
+
+  static constexpr size_t SIZE = sizeof...(PINS);
+  static constexpr uint32_t MASK = ((1UL << PINS) | ...);
+
+  static constexpr uint32_t maskFor(uint32_t pattern) {
+    constexpr gpio_num_t pins[] = {PINS...};
+    uint32_t mask = 0;
+    for (size_t idx = 0; idx < SIZE; idx++) {
+      if ((pattern >> (SIZE - 1 - idx)) & 0x01) {
+        mask |= 1UL << pins[idx];
+      }
+    }
+    return mask;
+  }
+
+  template <size_t N>
+  static constexpr std::array<uint32_t, N> masksFor(const std::array<uint8_t, N>& patterns) {
+    std::array<uint32_t, N> masks = {};
+    for (size_t idx = 0; idx < N; idx++) {
+      masks[idx] = maskFor(patterns[idx]);
+    }
+    return masks;
+  }
+
+  /**
+   * Sets the pins of the mask and clears all other pins of the group, with a W1TC store followed
+   * by a W1TS store. Between the stores, only the pins which are set in the old and in the new
+   * pattern are set, so a pin is never high unless one of the patterns sets it. If only one pin
+   * changes, only one of the stores changes an output.
+   */
+  static inline void write(uint32_t setMask) {
+    REG_WRITE(GPIO_OUT_W1TC_REG, MASK & ~setMask);
+    REG_WRITE(GPIO_OUT_W1TS_REG, setMask);
+  }
+
+  static inline void clear() { REG_WRITE(GPIO_OUT_W1TC_REG, MASK); }
+};
+
+}  // namespace gpioout
+
+#endif /* MAIN_GPIO_OUT_H_ */
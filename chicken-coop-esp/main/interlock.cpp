@@ -0,0 +1,118 @@
+#include "interlock.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "esp_log.h"
+#include "motor_backend.h"
+#include "switch.h"
+
+static constexpr char INTERLOCK_TAG[] = "interlock";
+
+// Protects the interlock state shared with the switch ISR and the deadline timer
+static portMUX_TYPE LOCK = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t DEADLINE_TIMER = nullptr;
+static bool ARMED = false;
+static bool FORCED = false;
+static bool CLOSE = false;
+// A timer callback of an earlier close which was already dispatched is ignored with this
+static int64_t DEADLINE_US = 0;
+static int64_t LAST_EDGE_US = 0;
+static interlock::Trip TRIP = interlock::Trip::NONE;
+static interlock::Stats STATS = {};
+
+// Must be called with the lock
+static void trip(interlock::Trip reason) {
+  MotorBackend::hardStop();
+  ARMED = false;
+  TRIP = reason;
+}
+
+// Called by the switch ISR. Acts on the first raw edge of the limit switch in the drive
+// direction, the debounced state would only follow after the debounce time.
+static void onSwitchEdge(const doorswitch::Edge& edge) {
+  portENTER_CRITICAL_ISR(&LOCK);
+  doorswitch::Input limit = CLOSE ? doorswitch::Input::BOTTOM : doorswitch::Input::TOP;
+  if (TRIP == interlock::Trip::SWITCH and edge.input == limit) {
+    LAST_EDGE_US = edge.timeUs;
+  } else if (ARMED and not FORCED and edge.input == limit and edge.active) {
+    trip(interlock::Trip::SWITCH);
+    LAST_EDGE_US = edge.timeUs;
+    uint32_t latencyUs = esp_timer_get_time() - edge.timeUs;
+    STATS.switchStops++;
+    STATS.lastLatencyUs = latencyUs;
+    if (latencyUs > STATS.maxLatencyUs) {
+      STATS.maxLatencyUs = latencyUs;
+    }
+  }
+  portEXIT_CRITICAL_ISR(&LOCK);
+}
+
+// Runs in the ISR if the ISR dispatch of the esp_timer is enabled, otherwise in the esp_timer
+// task, which has a higher priority than all application tasks.
+static void onDeadline(void* args) {
+  portENTER_CRITICAL_SAFE(&LOCK);
+  if (ARMED and esp_timer_get_time() >= DEADLINE_US) {
+    trip(interlock::Trip::DEADLINE);
+    STATS.deadlineStops++;
+  }
+  portEXIT_CRITICAL_SAFE(&LOCK);
+}
+
+esp_err_t interlock::init() {
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = onDeadline;
+  timerArgs.name = "interlock";
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD
+  timerArgs.dispatch_method = ESP_TIMER_ISR;
+#else
+  timerArgs.dispatch_method = ESP_TIMER_TASK;
+#endif
+  esp_err_t result = esp_timer_create(&timerArgs, &DEADLINE_TIMER);
+  if (result != ESP_OK) {
+    return result;
+  }
+  doorswitch::setEdgeCb(onSwitchEdge);
+  ESP_LOGI(INTERLOCK_TAG, "Motor interlock with a latency bound of %d us",
+           CONFIG_MOTOR_INTERLOCK_MAX_LATENCY);
+  return ESP_OK;
+}
+
+void interlock::arm(bool close, bool forced, uint32_t deadlineMs) {
+  // Not running if the last movement was stopped at the deadline
+  static_cast<void>(esp_timer_stop(DEADLINE_TIMER));
+  portENTER_CRITICAL(&LOCK);
+  ARMED = true;
+  FORCED = forced;
+  CLOSE = close;
+  DEADLINE_US = esp_timer_get_time() + static_cast<int64_t>(deadlineMs) * 1000;
+  TRIP = Trip::NONE;
+  portEXIT_CRITICAL(&LOCK);
+  ESP_ERROR_CHECK_WITHOUT_ABORT(
+      esp_timer_start_once(DEADLINE_TIMER, static_cast<uint64_t>(deadlineMs) * 1000));
+}
+
+interlock::Trip interlock::disarm() {
+  portENTER_CRITICAL(&LOCK);
+  ARMED = false;
+  Trip result = TRIP;
+  TRIP = Trip::NONE;
+  portEXIT_CRITICAL(&LOCK);
+  static_cast<void>(esp_timer_stop(DEADLINE_TIMER));
+  return result;
+}
+
+interlock::Trip interlock::tripped(int64_t& lastEdgeUs) {
+  portENTER_CRITICAL(&LOCK);
+  Trip result = TRIP;
+  lastEdgeUs = LAST_EDGE_US;
+  portEXIT_CRITICAL(&LOCK);
+  return result;
+}
+
+interlock::Stats interlock::stats() {
+  portENTER_CRITICAL(&LOCK);
+  Stats result = STATS;
+  portEXIT_CRITICAL(&LOCK);
+  return result;
+}
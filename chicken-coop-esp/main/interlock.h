@@ -0,0 +1,51 @@
+#ifndef MAIN_INTERLOCK_H_
+#define MAIN_INTERLOCK_H_
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+/**
+ * Hard-stop interlock of a door movement. While it is armed, the switch ISR cuts the motor
+ * outputs as soon as the limit switch in the drive direction triggers, and a one-shot esp_timer
+ * cuts them at the deadline. Neither depends on a task being scheduled. The motor task still
+ * ends the movement regularly afterwards. The raw edge might be a bounce or a glitch, so the
+ * motor task resumes a movement after a switch trip which the debounced state does not confirm.
+ * Opens are only armed with a top limit switch.
+ */
+namespace interlock {
+
+enum class Trip : uint8_t { NONE, SWITCH, DEADLINE };
+
+struct Stats {
+  uint32_t switchStops;
+  uint32_t deadlineStops;
+  // Time from the entry of the switch ISR until both motor outputs were cut
+  uint32_t lastLatencyUs;
+  uint32_t maxLatencyUs;
+};
+
+esp_err_t init();
+
+/**
+ * Arms the interlock for a movement which has to end after deadlineMs. A forced movement ignores
+ * the limit switch and is only stopped at the deadline.
+ */
+void arm(bool close, bool forced, uint32_t deadlineMs);
+
+/**
+ * Returns what stopped the motor since the interlock was armed.
+ */
+Trip disarm();
+
+/**
+ * Like disarm, but keeps the state. After a switch trip, lastEdgeUs is the time of the last
+ * edge of the limit switch, so bounces after the trip are included.
+ */
+Trip tripped(int64_t& lastEdgeUs);
+
+Stats stats();
+
+}  // namespace interlock
+
+#endif /* MAIN_INTERLOCK_H_ */
@@ -1,8 +1,55 @@
+#include "legacyMotor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "esp_cpu.h"
 #include "esp_log.h"
 #include "esp_task_wdt.h"
-#include "motor.h"
-#include "rom/ets_sys.h"
 #include "sdkconfig.h"
+#include "storage.h"
+#include "switch.h"
+
+StepRamp::StepRamp(uint32_t cruiseIntervalUs, uint32_t accelStepsPerS2) {
+  cruiseQ8 = cruiseIntervalUs << FRACTION_BITS;
+  // First interval of a start from standstill, with the correction factor of 0.676 for the
+  // error of the approximation in the first step
+  float firstUs = 0.676F * std::sqrt(2.0F / accelStepsPerS2) * 1000.0F * 1000.0F;
+  firstQ8 = static_cast<uint32_t>(firstUs) << FRACTION_BITS;
+  if (firstQ8 < cruiseQ8) {
+    firstQ8 = cruiseQ8;
+  }
+  // v^2 / 2a
+  float cruiseRate = 1000.0F * 1000.0F / cruiseIntervalUs;
+  maxRampSteps = static_cast<uint32_t>(cruiseRate * cruiseRate / (2.0F * accelStepsPerS2));
+}
+
+void StepRamp::start(uint32_t totalSteps) {
+  this->totalSteps = totalSteps;
+  currentRampSteps = maxRampSteps < totalSteps / 2 ? maxRampSteps : totalSteps / 2;
+  stepIdx = 0;
+  intervalQ8 = firstQ8;
+}
+
+uint32_t StepRamp::nextIntervalUs() {
+  uint32_t remaining = totalSteps > stepIdx ? totalSteps - stepIdx : 1;
+  if (stepIdx == 0) {
+    intervalQ8 = firstQ8;
+  } else if (remaining <= currentRampSteps) {
+    // Inverse of the acceleration step
+    intervalQ8 += 2 * intervalQ8 / (4 * remaining - 1);
+  } else if (intervalQ8 > cruiseQ8) {
+    intervalQ8 -= 2 * intervalQ8 / (4 * stepIdx + 1);
+    if (intervalQ8 < cruiseQ8) {
+      intervalQ8 = cruiseQ8;
+    }
+  } else {
+    intervalQ8 = cruiseQ8;
+  }
+  stepIdx++;
+  return intervalQ8 >> FRACTION_BITS;
+}
 
 LegacyMotor::LegacyMotor(uint32_t fullOpenCloseDuration, uint32_t revolutionsMax,
                          config::StopConditionCb stopCb, config::StopConditionArgs stopArgs,
@@ -28,52 +75,191 @@ void LegacyMotor::taskEntryPoint(void* args) {
 
 void LegacyMotor::taskOp() {
   configureDriverGpios();
+#ifdef CONFIG_STEPPER_GPIO_BENCHMARK
+  benchmarkCoilWrites();
+#endif
+  configureStepTimer();
   if (fullOpenCloseDuration > 1000) {
     ESP_LOGW(MOTOR_TAG, "Invalid open close duration of %d seconds", fullOpenCloseDuration);
     ESP_LOGW(MOTOR_TAG, "Maximum is 1000 seconds. Assuming 60 seconds");
     fullOpenCloseDuration = 60;
   }
-  unsigned stepDelayUs = fullOpenCloseDuration * 1000 * 1000 / 12 / 4096;
-  if (stepDelayUs <= 1000) {
-    ESP_LOGI(MOTOR_TAG,
-             "Calculated delay between steps is less than 1 millisecond with %d microseconds",
-             stepDelayUs);
-    ESP_LOGI(MOTOR_TAG, "Rounding to 1 millisecond delay between steps");
-    stepDelayMs = 1;
-  } else {
-    stepDelayMs = stepDelayUs / 1000;
+  if (revolutionsMax == 0) {
+    revolutionsMax = 1;
   }
-  ESP_LOGI(MOTOR_TAG, "Calculated delay between steps: %d milliseconds", stepDelayMs);
-  BaseType_t retval = 0;
+  uint32_t stepIntervalUs =
+      static_cast<uint64_t>(fullOpenCloseDuration) * 1000 * 1000 / (revolutionsMax * STEP_COUNT);
+  if (stepIntervalUs < 1000 * 1000 / MAX_STEP_RATE) {
+    ESP_LOGI(MOTOR_TAG, "Step interval of %lu us too short, limiting to %lu steps per second",
+             stepIntervalUs, MAX_STEP_RATE);
+    stepIntervalUs = 1000 * 1000 / MAX_STEP_RATE;
+  }
+  ramp = StepRamp(stepIntervalUs, ACCELERATION);
+  ESP_LOGI(MOTOR_TAG, "Step interval %lu us, first step %lu us, %lu steps to accelerate",
+           ramp.cruiseUs(), ramp.firstUs(), ramp.rampSteps());
+  loadPosition();
   while (true) {
-    // Wait for the control task to notify the motor task
-    retval = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-    if (retval == pdPASS) {
-      // Handle motor driver code
-      driveChickenCoop();
-      xSemaphoreTake(motorLock, portMAX_DELAY);
+    if (not startRequestedDrive()) {
+      // Wait for the control task to notify the motor task
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+    finishDrive(driveChickenCoop());
+  }
+}
+
+void LegacyMotor::loadPosition() {
+  StoredPosition stored = {};
+  esp_err_t result = storage::loadBlob(POSITION_KEY, POSITION_VERSION, &stored, sizeof(stored));
+  if (result == ESP_OK) {
+    settledPosition = stored.position;
+    isHomed = stored.homed;
+  } else if (result != ESP_ERR_NVS_NOT_FOUND) {
+    ESP_LOGW(MOTOR_TAG, "Loading the stepper position failed with %s", esp_err_to_name(result));
+  }
+  ESP_LOGI(MOTOR_TAG, "Stepper position %ld, %s", settledPosition,
+           isHomed ? "homed" : "not homed");
+}
+
+void LegacyMotor::storePosition(bool homed) {
+  StoredPosition stored = {};
+  stored.position = settledPosition;
+  stored.homed = homed;
+  ESP_ERROR_CHECK_WITHOUT_ABORT(
+      storage::storeBlob(POSITION_KEY, POSITION_VERSION, &stored, sizeof(stored)));
+}
+
+Direction LegacyMotor::dirTo(int32_t target) const {
+  if (target > settledPosition) {
+    return openDir();
+  }
+  return dirMapper(true);
+}
+
+bool LegacyMotor::startRequestedDrive() {
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  bool start = driveRequested;
+  if (start) {
+    driveRequested = false;
+    driverState = requestedState;
+    // The door switch homes the motor if the door was closed without it
+    bool switchClosed = doorswitch::closed();
+    if (switchClosed) {
+      settledPosition = 0;
+      isHomed = true;
+    }
+    uint32_t steps = 0;
+    homingMove = requestedTarget == presetPosition(Preset::CLOSED);
+    if (homingMove and switchClosed) {
+      steps = 0;
+    } else if (homingMove) {
+      direction = dirMapper(true);
+      uint32_t expectedSteps = isHomed ? std::max<int32_t>(settledPosition, 0) : openSteps();
+      steps = expectedSteps + HOMING_OVERRUN_STEPS;
+    } else if (isHomed) {
+      direction = dirTo(requestedTarget);
+      steps = std::abs(requestedTarget - settledPosition);
+    } else {
+      // Without a known position, only the full travel is possible
+      ESP_LOGW(MOTOR_TAG, "Stepper not homed, moving the full travel");
+      direction = openDir();
+      steps = openSteps();
+    }
+    if (steps == 0) {
+      start = false;
       driverState = DriverStates::IDLE;
-      ESP_LOGD(MOTOR_TAG, "Motor operation done");
-      xSemaphoreGive(motorLock);
+    } else {
+      // A reset during the movement leaves the position unknown
+      storePosition(false);
+      // Notifications of earlier requests must not end the new movement. A stop request after
+      // this point finds the motor stepping.
+      ulTaskNotifyTake(pdTRUE, 0);
+      startStepping(steps);
     }
   }
+  xSemaphoreGive(motorLock);
+  return start;
+}
+
+void LegacyMotor::finishDrive(bool stopConditionReached) {
+  portENTER_CRITICAL(&stepLock);
+  uint32_t moved = stepsDone;
+  bool allStepsDone = stepsDone >= totalSteps;
+  portEXIT_CRITICAL(&stepLock);
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  if (direction == openDir()) {
+    settledPosition += moved;
+  } else {
+    settledPosition -= moved;
+  }
+  if (homingMove and stopConditionReached) {
+    settledPosition = 0;
+    isHomed = true;
+  } else if (homingMove and allStepsDone) {
+    ESP_LOGW(MOTOR_TAG, "Door not closed after the homing overrun");
+    isHomed = false;
+  }
+  storePosition(isHomed);
+  // Otherwise the next movement starts right away
+  if (not driveRequested) {
+    driverState = DriverStates::IDLE;
+  }
+  ESP_LOGD(MOTOR_TAG, "Motor operation done at position %ld", settledPosition);
+  xSemaphoreGive(motorLock);
 }
 
 void LegacyMotor::configureDriverGpios() {
   // zero-initialize the config structure.
   gpio_config_t io_conf = {};
 
+  // The pins might still be held from a previous deep sleep
+  gpio_hold_dis(STEPPER_IN1);
+  gpio_hold_dis(STEPPER_IN2);
+  gpio_hold_dis(STEPPER_IN3);
+  gpio_hold_dis(STEPPER_IN4);
+
   io_conf.intr_type = GPIO_INTR_DISABLE;
   io_conf.mode = GPIO_MODE_OUTPUT;
-  io_conf.pin_bit_mask = GPIO_MASK;
+  io_conf.pin_bit_mask = CoilPins::MASK;
   io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
   io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
   gpio_config(&io_conf);
 
-  gpio_set_level(STEPPER_IN1, false);
-  gpio_set_level(STEPPER_IN2, false);
-  gpio_set_level(STEPPER_IN3, false);
-  gpio_set_level(STEPPER_IN4, false);
+  CoilPins::clear();
+}
+
+#ifdef CONFIG_STEPPER_GPIO_BENCHMARK
+void LegacyMotor::benchmarkCoilWrites() {
+  // The coils stay de-energized, the cost does not depend on the pattern
+  constexpr uint32_t ROUNDS = 1000;
+  const gpio_num_t pins[] = {STEPPER_IN1, STEPPER_IN3, STEPPER_IN2, STEPPER_IN4};
+  esp_cpu_cycle_count_t startCycles = esp_cpu_get_cycle_count();
+  for (uint32_t round = 0; round < ROUNDS; round++) {
+    for (uint8_t motorIdx = 0; motorIdx < 4; motorIdx++) {
+      gpio_set_level(pins[motorIdx], 0);
+    }
+  }
+  uint32_t levelCycles = esp_cpu_get_cycle_count() - startCycles;
+  startCycles = esp_cpu_get_cycle_count();
+  for (uint32_t round = 0; round < ROUNDS; round++) {
+    CoilPins::write(0);
+  }
+  uint32_t registerCycles = esp_cpu_get_cycle_count() - startCycles;
+  ESP_LOGI(MOTOR_TAG, "Coil write per step: %lu cycles with gpio_set_level, %lu with registers",
+           levelCycles / ROUNDS, registerCycles / ROUNDS);
+}
+#endif
+
+void LegacyMotor::configureStepTimer() {
+  gptimer_config_t timerCfg = {};
+  timerCfg.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+  timerCfg.direction = GPTIMER_COUNT_UP;
+  timerCfg.resolution_hz = STEP_TIMER_RESOLUTION_HZ;
+  ESP_ERROR_CHECK(gptimer_new_timer(&timerCfg, &stepTimer));
+  gptimer_event_callbacks_t callbacks = {};
+  callbacks.on_alarm = onStepTimer;
+  ESP_ERROR_CHECK(gptimer_register_event_callbacks(stepTimer, &callbacks, this));
+  ESP_ERROR_CHECK(gptimer_enable(stepTimer));
 }
 
 void LegacyMotor::printMotorDrive(Direction direction) {
@@ -86,62 +272,106 @@ void LegacyMotor::printMotorDrive(Direction direction) {
   ESP_LOGI(MOTOR_TAG, "Driving motor %s for one revolution(s)", dirString);
 }
 
-bool LegacyMotor::driveMotorOneRevolution(uint8_t revolutionIdx, bool print) {
-  if (print) {
-    printMotorDrive(direction);
-  }
-  bool stopCondReached = false;
-  for (uint32_t idx = 0; idx < STEP_COUNT; idx++) {
-    uint8_t currentSeq = STEP_SEQUENCE[MOTOR_STEP_COUNTER];
-    for (uint8_t motorIdx = 0; motorIdx < 4; motorIdx++) {
-      bool setHigh = (currentSeq >> (3 - motorIdx)) & 0x01;
-      gpio_set_level(MOTOR_PINS[motorIdx], setHigh);
-    }
-    if (direction == Direction::CLOCK_WISE) {
-      MOTOR_STEP_COUNTER = (MOTOR_STEP_COUNTER + (8 - 1)) % 8;
-    } else if (direction == Direction::COUNTER_CLOCK_WISE) {
-      MOTOR_STEP_COUNTER = (MOTOR_STEP_COUNTER + 1) % 8;
+bool LegacyMotor::onStepTimer(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event,
+                              void* args) {
+  LegacyMotor& motor = *reinterpret_cast<LegacyMotor*>(args);
+  BaseType_t higherPrioTaskWoken = pdFALSE;
+  portENTER_CRITICAL_ISR(&motor.stepLock);
+  if (motor.stepping) {
+    CoilPins::write(STEP_MASKS[motor.MOTOR_STEP_COUNTER]);
+    if (motor.direction == Direction::CLOCK_WISE) {
+      motor.MOTOR_STEP_COUNTER = (motor.MOTOR_STEP_COUNTER + (8 - 1)) % 8;
+    } else {
+      motor.MOTOR_STEP_COUNTER = (motor.MOTOR_STEP_COUNTER + 1) % 8;
     }
-    if (idx % 124 == 0) {
-      esp_task_wdt_reset();
-      if (stopCb(direction, revolutionIdx, stopArgs)) {
-        stopCondReached = true;
-        break;
-      }
+    motor.stepsDone++;
+    if (motor.stepsDone >= motor.totalSteps) {
+      motor.stepping = false;
+      gptimer_stop(timer);
+      vTaskNotifyGiveFromISR(motor.taskHandle, &higherPrioTaskWoken);
+    } else {
+      // The alarm is relative to the last alarm, so the ISR latency does not add up
+      gptimer_alarm_config_t alarmCfg = {};
+      alarmCfg.alarm_count = event->alarm_value + motor.ramp.nextIntervalUs();
+      gptimer_set_alarm_action(timer, &alarmCfg);
     }
-    vTaskDelay(stepDelayMs / portTICK_PERIOD_MS);
   }
-  return stopCondReached;
+  portEXIT_CRITICAL_ISR(&motor.stepLock);
+  return higherPrioTaskWoken == pdTRUE;
 }
 
-void LegacyMotor::driveChickenCoop() {
+void LegacyMotor::startStepping(uint32_t steps) {
+  ramp.start(steps);
+  gptimer_alarm_config_t alarmCfg = {};
+  alarmCfg.alarm_count = ramp.nextIntervalUs();
+  ESP_ERROR_CHECK_WITHOUT_ABORT(gptimer_set_raw_count(stepTimer, 0));
+  ESP_ERROR_CHECK_WITHOUT_ABORT(gptimer_set_alarm_action(stepTimer, &alarmCfg));
+  portENTER_CRITICAL(&stepLock);
+  stepsDone = 0;
+  totalSteps = steps;
+  stepping = true;
+  portEXIT_CRITICAL(&stepLock);
+  ESP_ERROR_CHECK_WITHOUT_ABORT(gptimer_start(stepTimer));
+}
+
+void LegacyMotor::stopStepping() {
+  portENTER_CRITICAL(&stepLock);
+  bool wasStepping = stepping;
+  stepping = false;
+  portEXIT_CRITICAL(&stepLock);
+  // Otherwise the ISR already stopped the timer
+  if (wasStepping) {
+    ESP_ERROR_CHECK_WITHOUT_ABORT(gptimer_stop(stepTimer));
+  }
+}
+
+bool LegacyMotor::driveChickenCoop() {
   const char* dirString = nullptr;
   if (direction == Direction::CLOCK_WISE) {
     dirString = "clockwise";
   } else if (direction == Direction::COUNTER_CLOCK_WISE) {
     dirString = "counter-clockwise";
   }
-  ESP_LOGI(MOTOR_TAG, "Driving motor %s for maximum of %d revolution(s)", dirString,
-           revolutionsMax);
-  for (uint8_t idx = 0; idx < revolutionsMax; idx++) {
-    bool stopCond = driveMotorOneRevolution(idx, false);
-    if (stopCond) {
-      ESP_LOGI(MOTOR_TAG, "Stop condition reached. Motor operation done");
+  ESP_LOGI(MOTOR_TAG, "Driving motor %s for %lu steps", dirString, totalSteps);
+  bool stopConditionReached = false;
+  while (true) {
+    // The ISR notifies the task after the last step, requests notify it to end the movement
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STOP_CHECK_PERIOD_MS)) > 0) {
+      break;
+    }
+    esp_task_wdt_reset();
+    if (stopCb != nullptr and stopCb(direction, stopArgs)) {
+      ESP_LOGI(MOTOR_TAG, "Stop condition reached after %lu steps. Motor operation done",
+               stepsDone);
+      stopConditionReached = true;
       break;
     }
   }
+  stopStepping();
+  // The coils do not need to hold the door
+  CoilPins::clear();
+  return stopConditionReached;
+}
+
+void LegacyMotor::queueDrive(int32_t target, DriverStates state) {
+  requestedTarget = target;
+  requestedDir = dirTo(target);
+  requestedState = state;
+  driveRequested = true;
+  // A running movement ends first, the motor task then starts the requested one
+  stopStepping();
+  if (taskHandle != nullptr) {
+    xTaskNotifyGive(taskHandle);
+  }
 }
 
 bool LegacyMotor::requestOpen() {
   bool result = false;
   xSemaphoreTake(motorLock, portMAX_DELAY);
-  if (driverState == DriverStates::IDLE) {
-    direction = dirMapper(false);
+  if (driverState == DriverStates::IDLE and not driveRequested) {
     opPending = true;
     result = true;
-    driverState = DriverStates::OPENING;
-    // Unblocks motor task
-    xTaskNotifyGive(taskHandle);
+    queueDrive(presetPosition(Preset::OPEN), DriverStates::OPENING);
   }
   xSemaphoreGive(motorLock);
   return result;
@@ -150,18 +380,118 @@ bool LegacyMotor::requestOpen() {
 bool LegacyMotor::requestClose() {
   bool result = false;
   xSemaphoreTake(motorLock, portMAX_DELAY);
-  if (driverState == DriverStates::IDLE) {
-    direction = dirMapper(true);
+  if (driverState == DriverStates::IDLE and not driveRequested) {
     opPending = true;
     result = true;
-    driverState = DriverStates::CLOSING;
-    // Unblocks motor task
+    queueDrive(presetPosition(Preset::CLOSED), DriverStates::CLOSING);
+  }
+  xSemaphoreGive(motorLock);
+  return result;
+}
+
+bool LegacyMotor::requestDrive(Direction dir) {
+  bool result = false;
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  if (not commanded or requestedDir != dir) {
+    commanded = true;
+    starts++;
+    result = true;
+    Preset preset = dir == openDir() ? Preset::OPEN : Preset::CLOSED;
+    queueDrive(presetPosition(preset), DriverStates::MOVING);
+    // The open position might already be reached
+    requestedDir = dir;
+  }
+  xSemaphoreGive(motorLock);
+  return result;
+}
+
+bool LegacyMotor::moveTo(int32_t target) {
+  bool result = false;
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  if (isHomed or target == presetPosition(Preset::CLOSED)) {
+    commanded = true;
+    starts++;
+    result = true;
+    queueDrive(target, DriverStates::MOVING);
+  }
+  xSemaphoreGive(motorLock);
+  return result;
+}
+
+int32_t LegacyMotor::presetPosition(Preset preset) const {
+  switch (preset) {
+    case (Preset::OPEN): {
+      return openSteps();
+    }
+    case (Preset::VENTILATION): {
+      return static_cast<uint64_t>(openSteps()) * CONFIG_STEPPER_VENTILATION_GAP / 100;
+    }
+    default: {
+      return 0;
+    }
+  }
+}
+
+void LegacyMotor::requestStop() {
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  commanded = false;
+  driveRequested = false;
+  stopStepping();
+  if (taskHandle != nullptr) {
     xTaskNotifyGive(taskHandle);
   }
   xSemaphoreGive(motorLock);
+}
+
+void LegacyMotor::hardStop() {
+  portENTER_CRITICAL_SAFE(&stepLock);
+  if (stepping) {
+    stepping = false;
+    gptimer_stop(stepTimer);
+  }
+  CoilPins::clear();
+  portEXIT_CRITICAL_SAFE(&stepLock);
+}
+
+int32_t LegacyMotor::position() {
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  int32_t result = settledPosition;
+  if (driverState != DriverStates::IDLE) {
+    portENTER_CRITICAL(&stepLock);
+    uint32_t moved = stepsDone;
+    portEXIT_CRITICAL(&stepLock);
+    result += direction == openDir() ? moved : -static_cast<int32_t>(moved);
+  }
+  xSemaphoreGive(motorLock);
   return result;
 }
 
+bool LegacyMotor::homed() {
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  bool result = isHomed;
+  xSemaphoreGive(motorLock);
+  return result;
+}
+
+bool LegacyMotor::active() {
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  bool result = commanded;
+  xSemaphoreGive(motorLock);
+  return result;
+}
+
+void LegacyMotor::holdStoppedInDeepSleep() {
+  requestStop();
+  xSemaphoreTake(motorLock, portMAX_DELAY);
+  CoilPins::clear();
+  gpio_hold_en(STEPPER_IN1);
+  gpio_hold_en(STEPPER_IN2);
+  gpio_hold_en(STEPPER_IN3);
+  gpio_hold_en(STEPPER_IN4);
+  gpio_deep_sleep_hold_en();
+  xSemaphoreGive(motorLock);
+}
+
 bool LegacyMotor::operationDone() {
   bool result = false;
   if (not opPending) {
@@ -183,3 +513,49 @@ void LegacyMotor::setStopConditionCb(config::StopConditionCb cb,
 }
 
 void LegacyMotor::setDirectionMapper(config::OpenCloseToDirCb mapper) { this->dirMapper = mapper; }
+
+// Same mapping as the drive direction of the DC motor, where true is clockwise
+static Direction stepperDir(bool close) {
+#if CONFIG_INVERT_MOTOR_DIRECTION
+  close = not close;
+#endif
+  return close ? Direction::CLOCK_WISE : Direction::COUNTER_CLOCK_WISE;
+}
+
+// The limit switch in the drive direction. Reaching the door switch also homes the position.
+static bool limitReached(Direction dir, config::StopConditionArgs args) {
+  return dir == stepperDir(true) ? doorswitch::closed() : doorswitch::topLimit();
+}
+
+static LegacyMotor STEPPER(CONFIG_DEFAULT_FULL_OPEN_CLOSE_DURATION, CONFIG_STEPPER_REVOLUTIONS,
+                           limitReached, nullptr, stepperDir);
+static MotorArgs STEPPER_ARGS = {.motor = STEPPER};
+
+// The motor task configures the driver before it handles the first request
+void StepperMotor::init() {}
+
+void StepperMotor::task(void* args) { LegacyMotor::taskEntryPoint(&STEPPER_ARGS); }
+
+void StepperMotor::driveDir(bool dir, uint32_t travelMs) {
+  STEPPER.requestDrive(dir ? Direction::CLOCK_WISE : Direction::COUNTER_CLOCK_WISE);
+}
+
+void StepperMotor::stop() { STEPPER.requestStop(); }
+
+void StepperMotor::hardStop() { STEPPER.hardStop(); }
+
+bool StepperMotor::active() { return STEPPER.active(); }
+
+uint32_t StepperMotor::startCount() { return STEPPER.startCount(); }
+
+void StepperMotor::holdStoppedInDeepSleep() { STEPPER.holdStoppedInDeepSleep(); }
+
+bool StepperMotor::moveTo(int32_t position) { return STEPPER.moveTo(position); }
+
+int32_t StepperMotor::openPosition() {
+  return STEPPER.presetPosition(LegacyMotor::Preset::OPEN);
+}
+
+int32_t StepperMotor::position() { return STEPPER.position(); }
+
+bool StepperMotor::homed() { return STEPPER.homed(); }
@@ -3,12 +3,47 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
+#include <array>
 #include <cstdint>
 
 #include "conf.h"
 #include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "gpio_out.h"
 #include "motorDefs.h"
 
+/**
+ * Trapezoidal step timing with the approximation used by AccelStepper (D. Austin, "Generate
+ * stepper-motor speed profiles in real time"). The motor accelerates to the cruise rate,
+ * cruises and decelerates before the last step. Short movements have a triangular profile.
+ * Only integer arithmetic, so it can be used in an ISR.
+ */
+class StepRamp {
+ public:
+  StepRamp() = default;
+  StepRamp(uint32_t cruiseIntervalUs, uint32_t accelStepsPerS2);
+
+  void start(uint32_t totalSteps);
+  // Interval before the next step. Must be called once before every step.
+  uint32_t nextIntervalUs();
+
+  uint32_t cruiseUs() const { return cruiseQ8 >> FRACTION_BITS; }
+  uint32_t firstUs() const { return firstQ8 >> FRACTION_BITS; }
+  uint32_t rampSteps() const { return maxRampSteps; }
+
+ private:
+  static constexpr int FRACTION_BITS = 8;
+
+  uint32_t firstQ8 = 0;
+  uint32_t cruiseQ8 = 0;
+  // Steps until the cruise rate is reached
+  uint32_t maxRampSteps = 0;
+  uint32_t totalSteps = 0;
+  uint32_t currentRampSteps = 0;
+  uint32_t stepIdx = 0;
+  uint32_t intervalQ8 = 0;
+};
+
 /// @brief Driver for the 28BYJ-48
 class LegacyMotor {
  public:
@@ -17,6 +52,18 @@ class LegacyMotor {
 
   static constexpr uint32_t BIT_MASK_ALL = BIT_MASK_OPEN | BIT_MASK_CLOSE;
 
+  // Highest half step rate the 28BYJ-48 follows reliably with load
+  static constexpr uint32_t MAX_STEP_RATE = 900;
+  static constexpr uint32_t ACCELERATION = 2000;
+  // Period of the stop condition check while the motor is stepping
+  static constexpr uint32_t STOP_CHECK_PERIOD_MS = 20;
+  // A close continues for this many steps after the expected closed position until the stop
+  // condition, usually the door switch, is reached
+  static constexpr uint32_t HOMING_OVERRUN_STEPS = 2048;
+
+  // Positions are half steps from the closed door, opening increases the position
+  enum class Preset : uint8_t { CLOSED, OPEN, VENTILATION };
+
   LegacyMotor(uint32_t fullOpenCloseDuration, uint32_t revolutionsOpenClose,
               config::StopConditionCb stopCb, config::StopConditionArgs stopArgs,
               config::OpenCloseToDirCb dirMapper);
@@ -30,42 +77,145 @@ class LegacyMotor {
   bool requestClose();
   bool operationDone();
 
+  /**
+   * Moves the motor in the given direction for the configured number of revolutions. A movement
+   * in the same direction is kept, also after the last step, until requestStop() is called.
+   * A movement in the other direction is stopped first. Returns false if nothing changed.
+   */
+  bool requestDrive(Direction dir);
+  /**
+   * Moves to the absolute position and stops there. Closing always continues until the stop
+   * condition and sets the position to zero there. Other positions require a homed motor.
+   */
+  bool moveTo(int32_t target);
+  int32_t presetPosition(Preset preset) const;
+  void requestStop();
+  /**
+   * Stops stepping and releases the coils right away. Can be called from an ISR. The motor task
+   * ends the movement at the next stop condition check or stop request.
+   */
+  void hardStop();
+  // Includes the steps of a running movement
+  int32_t position();
+  // The position was set by a close which reached the stop condition
+  bool homed();
+  // A movement was requested and not stopped yet
+  bool active();
+  // Incremented on every start and direction change
+  uint32_t startCount() const { return starts; }
+  void holdStoppedInDeepSleep();
+
  private:
   static constexpr gpio_num_t STEPPER_IN1 = static_cast<gpio_num_t>(CONFIG_STEPPER_IN1_PORT);
   static constexpr gpio_num_t STEPPER_IN2 = static_cast<gpio_num_t>(CONFIG_STEPPER_IN2_PORT);
   static constexpr gpio_num_t STEPPER_IN3 = static_cast<gpio_num_t>(CONFIG_STEPPER_IN3_PORT);
   static constexpr gpio_num_t STEPPER_IN4 = static_cast<gpio_num_t>(CONFIG_STEPPER_IN4_PORT);
 
-  static constexpr uint64_t GPIO_MASK =
-      (1ULL << STEPPER_IN1) | (1ULL << STEPPER_IN2) | (1ULL << STEPPER_IN3) | (1ULL << STEPPER_IN4);
+  using CoilPins = gpioout::PinGroup<STEPPER_IN1, STEPPER_IN3, STEPPER_IN2, STEPPER_IN4>;
+
   static constexpr char MOTOR_TAG[] = "motor";
+  static constexpr char POSITION_KEY[] = "stepper";
+  static constexpr uint16_t POSITION_VERSION = 1;
+  static constexpr uint32_t STEP_TIMER_RESOLUTION_HZ = 1000 * 1000;
 
-  const uint8_t STEP_SEQUENCE[8] = {0b1000, 0b1010, 0b0010, 0b0110, 0b0100, 0b0101, 0b0001, 0b1001};
+  static constexpr std::array<uint8_t, 8> STEP_SEQUENCE = {0b1000, 0b1010, 0b0010, 0b0110,
+                                                           0b0100, 0b0101, 0b0001, 0b1001};
+  // Pins set for each half step. Adjacent half steps differ in one coil.
+  static constexpr std::array<uint32_t, 8> STEP_MASKS = CoilPins::masksFor(STEP_SEQUENCE);
 
   const uint32_t STEP_COUNT = 4096;
 
-  const gpio_num_t MOTOR_PINS[4] = {STEPPER_IN1, STEPPER_IN3, STEPPER_IN2, STEPPER_IN4};
   uint8_t MOTOR_STEP_COUNTER = 0;
   SemaphoreHandle_t motorLock = nullptr;
   config::StopConditionCb stopCb = nullptr;
   config::StopConditionArgs stopArgs = nullptr;
   config::OpenCloseToDirCb dirMapper = nullptr;
 
+  DriverStates driverState = DriverStates::IDLE;
   Direction direction = Direction::CLOCK_WISE;
+  // Requests to the motor task, protected by the motor lock
+  bool driveRequested = false;
+  DriverStates requestedState = DriverStates::IDLE;
+  Direction requestedDir = Direction::CLOCK_WISE;
+  int32_t requestedTarget = 0;
+  bool commanded = false;
+  uint32_t starts = 0;
+  // Position at the end of the last movement, protected by the motor lock
+  int32_t settledPosition = 0;
+  bool isHomed = false;
+  // Only used by the motor task
+  bool homingMove = false;
+
+  struct StoredPosition {
+    int32_t position;
+    uint8_t homed;
+    uint8_t reserved[3];
+  };
   TaskHandle_t taskHandle = nullptr;
   unsigned fullOpenCloseDuration = 0;
   unsigned revolutionsMax = 0;
   unsigned defaultFullOpenCloseDuration = 0;
-  unsigned stepDelayMs = 0;
   bool opPending = false;
 
+  gptimer_handle_t stepTimer = nullptr;
+  StepRamp ramp;
+  // Shared with the step timer ISR
+  portMUX_TYPE stepLock = portMUX_INITIALIZER_UNLOCKED;
+  bool stepping = false;
+  uint32_t stepsDone = 0;
+  uint32_t totalSteps = 0;
+
   void taskOp();
-  bool driveMotorOneRevolution(uint8_t revolutionIdx, bool print);
-  void driveChickenCoop();
+  void configureStepTimer();
+  Direction openDir() const { return dirMapper(false); }
+  Direction dirTo(int32_t target) const;
+  uint32_t openSteps() const { return revolutionsMax * STEP_COUNT; }
+  void loadPosition();
+  void storePosition(bool homed);
+  // Must be called with the motor lock
+  void queueDrive(int32_t target, DriverStates state);
+  // Starts a requested movement. Returns false if there is none.
+  bool startRequestedDrive();
+  // Returns true if the stop condition ended the movement
+  bool driveChickenCoop();
+  void finishDrive(bool stopConditionReached);
+  // Starts the step timer. Returns immediately, the ISR notifies the task after the last step.
+  void startStepping(uint32_t steps);
+  void stopStepping();
   void configureDriverGpios();
+#ifdef CONFIG_STEPPER_GPIO_BENCHMARK
+  void benchmarkCoilWrites();
+#endif
   void printMotorDrive(Direction direction);
+
+  static bool onStepTimer(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event,
+                          void* args);
 };
 
 struct MotorArgs {
   LegacyMotor& motor;
-};
\ No newline at end of file
+};
+
+/**
+ * Door motor backend for the 28BYJ-48, see motor_backend.h. The direction true is clockwise.
+ * Opening moves to the open position and closing continues until the door switch closes, so
+ * the travel time is not used.
+ */
+struct StepperMotor {
+  static constexpr bool HAS_TASK = true;
+
+  static void init();
+  static void task(void* args);
+  static void driveDir(bool dir, uint32_t travelMs);
+  static void stop();
+  static void hardStop();
+  static bool active();
+  static uint32_t startCount();
+  static void holdStoppedInDeepSleep();
+
+  // Absolute positioning, see LegacyMotor
+  static bool moveTo(int32_t position);
+  static int32_t openPosition();
+  static int32_t position();
+  static bool homed();
+};
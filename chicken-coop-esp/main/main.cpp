@@ -1,13 +1,21 @@
 #include <cstdio>
 
 #include "control.h"
+#include "current_sense.h"
+#include "dlog.h"
+#include "encoder.h"
 #include "esp_log.h"
 #include "esp_task_wdt.h"
+#include "interlock.h"
 #include "led.h"
-#include "motor.h"
+#include "motor_backend.h"
+#include "motor_task.h"
 #include "open_close_times.h"
+#include "schedule.h"
 #include "sdkconfig.h"
+#include "storage.h"
 #include "switch.h"
+#include "travel_time.h"
 #include "usr_config.h"
 
 static const char APP_TAG[] = "chicken-coop";
@@ -16,7 +24,12 @@ static constexpr int TASK_MAX_PRIORITY = configMAX_PRIORITIES - 1;
 
 TaskHandle_t CONTROL_TASK_HANDLE = nullptr;
 TaskHandle_t MOTOR_TASK_HANDLE = nullptr;
+TaskHandle_t STEPPER_TASK_HANDLE = nullptr;
 TaskHandle_t LED_TASK_HANDLE = nullptr;
+TaskHandle_t UART_RX_TASK_HANDLE = nullptr;
+TaskHandle_t LOG_TASK_HANDLE = nullptr;
+TaskHandle_t CURRENT_TASK_HANDLE = nullptr;
+TaskHandle_t SWITCH_TASK_HANDLE = nullptr;
 
 // Motor MOTOR_OBJ = Motor(nullptr, nullptr);
 Led LED_OBJ = Led();
@@ -27,11 +40,30 @@ LedArgs LED_ARGS = {.led = LED_OBJ};
 extern "C" void app_main(void) {
   printf("-- Chicken Coop Door Application v%d.%d.%d --\n", APP_VERSION_MAJOR, APP_VERSION_MINOR,
          APP_VERSION_REVISION);
+#ifdef CONFIG_MOTOR_BACKEND_STEPPER
+  ESP_LOGI(APP_TAG, "Stepper GPIO port mapping: IN1 %d | IN2 %d | IN3 %d | IN4 %d",
+           CONFIG_STEPPER_IN1_PORT, CONFIG_STEPPER_IN2_PORT, CONFIG_STEPPER_IN3_PORT,
+           CONFIG_STEPPER_IN4_PORT);
+#else
   ESP_LOGI(APP_TAG, "Motor GPIO port mapping: Direction 0 %d | Direction 1 %d", CONFIG_MOTOR_PORT_0,
            CONFIG_MOTOR_PORT_1);
+#endif
   esp_log_level_set("*", DEFAULT_LOG_LEVEL);
-  motor::init();
+  ESP_ERROR_CHECK(storage::init());
+  // The compiled-in table is used if no schedule was uploaded
+  schedule::init();
+  traveltime::init();
+  MotorBackend::init();
+  motortask::init();
+  if (currentsense::ENABLED) {
+    ESP_ERROR_CHECK(currentsense::init());
+  }
   doorswitch::init();
+  if (encoder::ENABLED) {
+    // Uses the GPIO ISR service of the door switch
+    ESP_ERROR_CHECK(encoder::init());
+  }
+  ESP_ERROR_CHECK(interlock::init());
   CONTROLLER_OBJ.preTaskInit();
   Controller::AppStates initState = Controller::AppStates::START_DELAY;
   if (config::START_IN_MANUAL_MODE) {
@@ -41,8 +73,29 @@ extern "C" void app_main(void) {
   CONTROLLER_OBJ.setAppState(initState);
   xTaskCreate(&Controller::taskEntryPoint, "Control Task", 4096, &CTRL_ARGS, TASK_MAX_PRIORITY - 1,
               &CONTROL_TASK_HANDLE);
+  // Higher priority than the controller, so commands are received while the controller is busy
+  xTaskCreate(&Controller::uartRxTaskEntryPoint, "UART RX Task", 3072, &CTRL_ARGS,
+              TASK_MAX_PRIORITY, &UART_RX_TASK_HANDLE);
+  // Debounces the limit switches, which end the door operations
+  xTaskCreate(&doorswitch::task, "Switch Task", 2048, nullptr, TASK_MAX_PRIORITY,
+              &SWITCH_TASK_HANDLE);
+  // Owns the motor backend and supervises the end conditions of the door operations
+  xTaskCreate(&motortask::task, "Motor Task", 3072, nullptr, TASK_MAX_PRIORITY,
+              &MOTOR_TASK_HANDLE);
+  if (MotorBackend::HAS_TASK) {
+    // Supervises the movements of the motor backend
+    xTaskCreate(&MotorBackend::task, "Stepper Task", 3072, nullptr, TASK_MAX_PRIORITY - 1,
+                &STEPPER_TASK_HANDLE);
+  }
+  if (currentsense::ENABLED) {
+    // Stops a stalled motor independently of the controller
+    xTaskCreate(&currentsense::task, "Current Task", 3072, nullptr, TASK_MAX_PRIORITY,
+                &CURRENT_TASK_HANDLE);
+  }
   xTaskCreate(&Led::taskEntryPoint, "LED Task", 2048, &LED_ARGS, TASK_MAX_PRIORITY - 5,
               &LED_TASK_HANDLE);
+  // Formats the deferred log records when nothing else has to be done
+  xTaskCreate(&dlog::task, "Log Task", 3072, nullptr, tskIDLE_PRIORITY + 1, &LOG_TASK_HANDLE);
   // This is allowed, see:
   // https://docs.espressif.com/projects/esp-idf/en/latest/esp32/api-guides/startup.html#app-main-task
   return;
@@ -1,42 +1,175 @@
 #include "motor.h"
 
+#include "driver/gptimer.h"
+#include "driver/ledc.h"
 #include "esp_log.h"
-#include "motorDefs.h"
 
-void motor::init() {
-  // zero-initialize the config structure.
-  gpio_config_t io_conf = {};
-
-  io_conf.intr_type = GPIO_INTR_DISABLE;
-  io_conf.mode = GPIO_MODE_OUTPUT;
-  io_conf.pin_bit_mask = GPIO_MASK;
-  io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-  io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
-  gpio_config(&io_conf);
-
-  gpio_set_level(DIR_0_PIN, 0);
-  gpio_set_level(DIR_1_PIN, 0);
+static constexpr char MOTOR_TAG[] = "motor";
+
+static constexpr ledc_mode_t LEDC_MODE = LEDC_LOW_SPEED_MODE;
+static constexpr ledc_timer_t LEDC_TIMER = LEDC_TIMER_0;
+static constexpr ledc_timer_bit_t DUTY_RESOLUTION = LEDC_TIMER_10_BIT;
+// A duty value of 2^resolution keeps the output permanently high
+static constexpr uint32_t FULL_DUTY = 1 << DUTY_RESOLUTION;
+// Index is the direction
+static constexpr ledc_channel_t CHANNELS[] = {LEDC_CHANNEL_0, LEDC_CHANNEL_1};
+static constexpr gpio_num_t PINS[] = {motor::DIR_0_PIN, motor::DIR_1_PIN};
+static constexpr uint32_t PROFILE_TIMER_RESOLUTION_HZ = 1000 * 1000;
+
+static gptimer_handle_t PROFILE_TIMER = nullptr;
+// Protects the drive state shared with the profile timer ISR
+static portMUX_TYPE LOCK = portMUX_INITIALIZER_UNLOCKED;
+static bool DRIVING = false;
+static bool TIMER_RUNNING = false;
+static bool DIR = false;
+static uint8_t DUTY = 0;
+static uint32_t ELAPSED_MS = 0;
+static uint32_t TRAVEL_MS = 0;
+static uint32_t START_COUNT = 0;
+static motor::SpeedProfile PROFILE = motor::DEFAULT_PROFILE;
+
+static bool profileStep(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event,
+                        void* args);
+
+static void setDuty(bool dir, uint8_t dutyPercent) {
+  ledc_set_duty(LEDC_MODE, CHANNELS[dir], dutyPercent * FULL_DUTY / 100);
+  ledc_update_duty(LEDC_MODE, CHANNELS[dir]);
 }
 
-void motor::driveDir(bool dir) {
-  if (dir) {
-    driveDir1();
-  } else {
-    driveDir0();
+void motor::init() {
+  // The pins might still be held from a previous deep sleep
+  gpio_hold_dis(DIR_0_PIN);
+  gpio_hold_dis(DIR_1_PIN);
+
+  ledc_timer_config_t timerCfg = {};
+  timerCfg.speed_mode = LEDC_MODE;
+  timerCfg.duty_resolution = DUTY_RESOLUTION;
+  timerCfg.timer_num = LEDC_TIMER;
+  timerCfg.freq_hz = CONFIG_MOTOR_PWM_FREQUENCY;
+  timerCfg.clk_cfg = LEDC_AUTO_CLK;
+  ESP_ERROR_CHECK(ledc_timer_config(&timerCfg));
+
+  for (size_t dir = 0; dir < 2; dir++) {
+    ledc_channel_config_t channelCfg = {};
+    channelCfg.gpio_num = PINS[dir];
+    channelCfg.speed_mode = LEDC_MODE;
+    channelCfg.channel = CHANNELS[dir];
+    channelCfg.intr_type = LEDC_INTR_DISABLE;
+    channelCfg.timer_sel = LEDC_TIMER;
+    channelCfg.duty = 0;
+    channelCfg.hpoint = 0;
+    ESP_ERROR_CHECK(ledc_channel_config(&channelCfg));
   }
+
+  gptimer_config_t gptimerCfg = {};
+  gptimerCfg.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+  gptimerCfg.direction = GPTIMER_COUNT_UP;
+  gptimerCfg.resolution_hz = PROFILE_TIMER_RESOLUTION_HZ;
+  ESP_ERROR_CHECK(gptimer_new_timer(&gptimerCfg, &PROFILE_TIMER));
+  gptimer_event_callbacks_t callbacks = {};
+  callbacks.on_alarm = profileStep;
+  ESP_ERROR_CHECK(gptimer_register_event_callbacks(PROFILE_TIMER, &callbacks, nullptr));
+  gptimer_alarm_config_t alarmCfg = {};
+  alarmCfg.alarm_count = PROFILE_STEP_MS * PROFILE_TIMER_RESOLUTION_HZ / 1000;
+  alarmCfg.reload_count = 0;
+  alarmCfg.flags.auto_reload_on_alarm = true;
+  ESP_ERROR_CHECK(gptimer_set_alarm_action(PROFILE_TIMER, &alarmCfg));
+  ESP_ERROR_CHECK(gptimer_enable(PROFILE_TIMER));
+  ESP_LOGI(MOTOR_TAG, "PWM drive with %d Hz", CONFIG_MOTOR_PWM_FREQUENCY);
 }
 
-void motor::driveDir0() {
-  gpio_set_level(DIR_0_PIN, 1);
-  gpio_set_level(DIR_1_PIN, 0);
+// Runs in the ISR context. The callback is not IRAM safe, so it is deferred while the flash
+// cache is disabled, which only delays the next profile step.
+static bool profileStep(gptimer_handle_t timer, const gptimer_alarm_event_data_t* event,
+                        void* args) {
+  portENTER_CRITICAL_ISR(&LOCK);
+  if (DRIVING) {
+    ELAPSED_MS += motor::PROFILE_STEP_MS;
+    uint8_t duty = motor::profileDuty(PROFILE, ELAPSED_MS, TRAVEL_MS);
+    if (duty != DUTY) {
+      DUTY = duty;
+      setDuty(DIR, duty);
+    }
+    if (motor::profileDone(PROFILE, ELAPSED_MS, TRAVEL_MS)) {
+      gptimer_stop(timer);
+      TIMER_RUNNING = false;
+    }
+  }
+  portEXIT_CRITICAL_ISR(&LOCK);
+  return false;
 }
 
-void motor::driveDir1() {
-  gpio_set_level(DIR_0_PIN, 0);
-  gpio_set_level(DIR_1_PIN, 1);
+void motor::driveDir(bool dir, uint32_t travelMs, const SpeedProfile& profile) {
+  bool startTimer = false;
+  portENTER_CRITICAL(&LOCK);
+  if (DRIVING and DIR == dir) {
+    portEXIT_CRITICAL(&LOCK);
+    return;
+  }
+  if (DRIVING) {
+    // Reversing, the new direction starts with the soft start again
+    setDuty(DIR, 0);
+  }
+  DRIVING = true;
+  START_COUNT++;
+  DIR = dir;
+  PROFILE = profile;
+  ELAPSED_MS = 0;
+  TRAVEL_MS = travelMs;
+  DUTY = profileDuty(profile, 0, travelMs);
+  setDuty(dir, DUTY);
+  if (not TIMER_RUNNING and not profileDone(profile, 0, travelMs)) {
+    TIMER_RUNNING = true;
+    startTimer = true;
+  }
+  portEXIT_CRITICAL(&LOCK);
+  if (startTimer) {
+    ESP_ERROR_CHECK_WITHOUT_ABORT(gptimer_set_raw_count(PROFILE_TIMER, 0));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(gptimer_start(PROFILE_TIMER));
+  }
 }
 
 void motor::stop() {
-  gpio_set_level(DIR_0_PIN, 0);
-  gpio_set_level(DIR_1_PIN, 0);
-}
\ No newline at end of file
+  portENTER_CRITICAL(&LOCK);
+  bool stopTimer = TIMER_RUNNING;
+  DRIVING = false;
+  TIMER_RUNNING = false;
+  DUTY = 0;
+  setDuty(false, 0);
+  setDuty(true, 0);
+  portEXIT_CRITICAL(&LOCK);
+  if (stopTimer) {
+    ESP_ERROR_CHECK_WITHOUT_ABORT(gptimer_stop(PROFILE_TIMER));
+  }
+}
+
+void motor::hardStop() {
+  portENTER_CRITICAL_SAFE(&LOCK);
+  if (DRIVING) {
+    // The next duty update enables the outputs again
+    ledc_stop(LEDC_MODE, CHANNELS[0], 0);
+    ledc_stop(LEDC_MODE, CHANNELS[1], 0);
+    DRIVING = false;
+    DUTY = 0;
+    if (TIMER_RUNNING) {
+      gptimer_stop(PROFILE_TIMER);
+      TIMER_RUNNING = false;
+    }
+  }
+  portEXIT_CRITICAL_SAFE(&LOCK);
+}
+
+bool motor::active() { return DRIVING; }
+
+uint32_t motor::startCount() { return START_COUNT; }
+
+void motor::holdStoppedInDeepSleep() {
+  stop();
+  // The duty update of stop() only takes effect at the end of the PWM period. ledc_stop sets
+  // the idle level right away, which is then latched by the hold.
+  ledc_stop(LEDC_MODE, CHANNELS[0], 0);
+  ledc_stop(LEDC_MODE, CHANNELS[1], 0);
+  gpio_hold_en(DIR_0_PIN);
+  gpio_hold_en(DIR_1_PIN);
+  gpio_deep_sleep_hold_en();
+}
@@ -3,18 +3,111 @@
 #include "conf.h"
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 namespace motor {
 
 static constexpr gpio_num_t DIR_0_PIN = static_cast<gpio_num_t>(CONFIG_MOTOR_PORT_0);
 static constexpr gpio_num_t DIR_1_PIN = static_cast<gpio_num_t>(CONFIG_MOTOR_PORT_1);
-static constexpr uint64_t GPIO_MASK = (1ULL << DIR_0_PIN) | (1ULL << DIR_1_PIN);
+
+// The speed profile is stepped by a hardware timer with this period.
+static constexpr uint32_t PROFILE_STEP_MS = 10;
+
+/**
+ * PWM speed profile of a door movement. The duty cycle ramps up from the start duty to the
+ * cruise duty, stays there and ramps down to the approach duty shortly before the expected end
+ * of travel, so the door does not hit the end stop at full speed. Duty cycles are in percent.
+ */
+struct SpeedProfile {
+  uint8_t startDuty;
+  uint8_t cruiseDuty;
+  uint32_t rampUpMs;
+  uint8_t approachDuty;
+  // Time before the expected end of travel at which the ramp down starts
+  uint32_t approachMs;
+  uint32_t rampDownMs;
+};
+
+static constexpr SpeedProfile DEFAULT_PROFILE = {
+    CONFIG_MOTOR_START_DUTY,    CONFIG_MOTOR_CRUISE_DUTY,  CONFIG_MOTOR_RAMP_UP_TIME,
+    CONFIG_MOTOR_APPROACH_DUTY, CONFIG_MOTOR_APPROACH_TIME, CONFIG_MOTOR_RAMP_DOWN_TIME};
+// Behaves like the plain H-bridge drive without PWM
+static constexpr SpeedProfile FULL_SPEED_PROFILE = {100, 100, 0, 100, 0, 0};
+
+static constexpr int32_t rampDuty(int32_t from, int32_t to, uint32_t elapsedMs,
+                                  uint32_t durationMs) {
+  return from + (to - from) * static_cast<int32_t>(elapsedMs) / static_cast<int32_t>(durationMs);
+}
+
+static constexpr uint32_t approachStartMs(const SpeedProfile& profile, uint32_t travelMs) {
+  return travelMs > profile.approachMs ? travelMs - profile.approachMs : 0;
+}
+
+/**
+ * Duty cycle in percent after the given time. travelMs is the expected travel time of the door.
+ */
+static constexpr uint8_t profileDuty(const SpeedProfile& profile, uint32_t elapsedMs,
+                                     uint32_t travelMs) {
+  int32_t duty = profile.cruiseDuty;
+  uint32_t approachStart = approachStartMs(profile, travelMs);
+  if (elapsedMs >= approachStart) {
+    uint32_t approachElapsed = elapsedMs - approachStart;
+    duty = profile.approachDuty;
+    if (approachElapsed < profile.rampDownMs) {
+      duty = rampDuty(profile.cruiseDuty, profile.approachDuty, approachElapsed,
+                      profile.rampDownMs);
+    }
+  }
+  // The soft start also applies to short movements which start in the approach phase
+  if (elapsedMs < profile.rampUpMs) {
+    int32_t rampUpDuty =
+        rampDuty(profile.startDuty, profile.cruiseDuty, elapsedMs, profile.rampUpMs);
+    if (rampUpDuty < duty) {
+      duty = rampUpDuty;
+    }
+  }
+  return duty;
+}
+
+// The duty cycle does not change anymore after the ramp down.
+static constexpr bool profileDone(const SpeedProfile& profile, uint32_t elapsedMs,
+                                  uint32_t travelMs) {
+  return elapsedMs >= profile.rampUpMs and
+         elapsedMs >= approachStartMs(profile, travelMs) + profile.rampDownMs;
+}
+
+static_assert(profileDuty(FULL_SPEED_PROFILE, 0, 0) == 100 and
+              profileDone(FULL_SPEED_PROFILE, 0, 0));
 
 void init();
 
-void driveDir(bool dir);
-void driveDir0();
-void driveDir1();
+/**
+ * Drives the motor in the given direction with the speed profile. travelMs is the expected
+ * remaining travel time. Calling it again for the same direction keeps the running profile.
+ */
+void driveDir(bool dir, uint32_t travelMs, const SpeedProfile& profile = DEFAULT_PROFILE);
 void stop();
+// Cuts both outputs without waiting for the end of the PWM period. Can be called from an ISR.
+void hardStop();
+bool active();
+// Incremented on every start and direction change
+uint32_t startCount();
+// Keeps both motor outputs low while the chip is in deep sleep.
+void holdStoppedInDeepSleep();
+
+}  // namespace motor
+
+// Door motor backend for the DC motor, see motor_backend.h
+struct DcMotor {
+  static constexpr bool HAS_TASK = false;
 
-}  // namespace motor
\ No newline at end of file
+  static void init() { motor::init(); }
+  // The PWM and the speed profile run without a task
+  static void task(void* args) { vTaskDelete(nullptr); }
+  static void driveDir(bool dir, uint32_t travelMs) { motor::driveDir(dir, travelMs); }
+  static void stop() { motor::stop(); }
+  static void hardStop() { motor::hardStop(); }
+  static bool active() { return motor::active(); }
+  static uint32_t startCount() { return motor::startCount(); }
+  static void holdStoppedInDeepSleep() { motor::holdStoppedInDeepSleep(); }
+};
@@ -1,3 +1,3 @@
 #pragma once
 
-enum DriverStates { OPENING, CLOSING, IDLE } driverState = DriverStates::IDLE;
\ No newline at end of file
+enum DriverStates { OPENING, CLOSING, MOVING, IDLE };
@@ -0,0 +1,47 @@
+#ifndef MAIN_MOTOR_BACKEND_H_
+#define MAIN_MOTOR_BACKEND_H_
+
+#include <concepts>
+#include <cstdint>
+
+#include "sdkconfig.h"
+
+#ifdef CONFIG_MOTOR_BACKEND_STEPPER
+#include "legacyMotor.h"
+#else
+#include "motor.h"
+#endif
+
+/**
+ * Interface of a door motor backend. All functions are static, so the calls are resolved at
+ * compile time and only the selected backend is built into the image. The direction is the
+ * plain drive direction, the controller maps it to opening and closing. travelMs is the
+ * expected remaining travel time of the door.
+ */
+template <typename M>
+concept DoorMotor = requires(bool dir, uint32_t travelMs, void* args) {
+  { M::HAS_TASK } -> std::convertible_to<bool>;
+  { M::init() } -> std::same_as<void>;
+  // Only created as a task if HAS_TASK is set
+  { M::task(args) } -> std::same_as<void>;
+  // Keeps a movement in the same direction running
+  { M::driveDir(dir, travelMs) } -> std::same_as<void>;
+  { M::stop() } -> std::same_as<void>;
+  // Cuts the motor outputs right away. Can be called from an ISR, stop() ends the movement.
+  { M::hardStop() } -> std::same_as<void>;
+  // The motor was started and not stopped yet
+  { M::active() } -> std::same_as<bool>;
+  // Incremented on every start and direction change
+  { M::startCount() } -> std::same_as<uint32_t>;
+  { M::holdStoppedInDeepSleep() } -> std::same_as<void>;
+};
+
+#ifdef CONFIG_MOTOR_BACKEND_STEPPER
+using MotorBackend = StepperMotor;
+#else
+using MotorBackend = DcMotor;
+#endif
+
+static_assert(DoorMotor<MotorBackend>, "Motor backend does not implement the DoorMotor interface");
+
+#endif /* MAIN_MOTOR_BACKEND_H_ */
@@ -0,0 +1,341 @@
+#include "motor_task.h"
+
+#include <esp_timer.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <cstdlib>
+#include <optional>
+
+#include "conf.h"
+#include "current_sense.h"
+#include "encoder.h"
+#include "esp_log.h"
+#include "interlock.h"
+#include "motor_backend.h"
+#include "switch.h"
+#include "travel_time.h"
+
+static constexpr char MOTOR_TASK_TAG[] = "motor-task";
+static constexpr uint32_t SEND_TIMEOUT_MS = 100;
+// The switch task accepts a new state up to a tick after the debounce time and the supervision
+// might see it one tick later
+static constexpr int64_t SWITCH_CONFIRM_US =
+    (doorswitch::DEBOUNCE_MS + 2 * portTICK_PERIOD_MS) * 1000;
+
+struct QueuedCommand {
+  motortask::Command cmd;
+  uint32_t id;
+};
+
+struct Movement {
+  motortask::Command cmd;
+  uint32_t id;
+  TickType_t startTime;
+  bool close;
+  // Encoder positions
+  int32_t startPosition;
+  int32_t target;
+};
+
+static QueueHandle_t COMMAND_QUEUE = nullptr;
+static QueueHandle_t COMPLETION_QUEUE = nullptr;
+static TaskHandle_t EVENT_TASK = nullptr;
+// Only used by the sending task
+static uint32_t NEXT_ID = 1;
+// Only used by the motor task
+static std::optional<Movement> ACTIVE;
+
+void motortask::init() {
+  COMMAND_QUEUE = xQueueCreate(QUEUE_DEPTH, sizeof(QueuedCommand));
+  COMPLETION_QUEUE = xQueueCreate(QUEUE_DEPTH, sizeof(Completion));
+}
+
+void motortask::setEventTask(TaskHandle_t task) { EVENT_TASK = task; }
+
+uint32_t motortask::send(const Command& cmd) {
+  QueuedCommand queued = {cmd, NEXT_ID};
+  if (xQueueSend(COMMAND_QUEUE, &queued, pdMS_TO_TICKS(SEND_TIMEOUT_MS)) != pdPASS) {
+    ESP_LOGW(MOTOR_TASK_TAG, "Command queue full, dropping command %d",
+             static_cast<int>(cmd.cmd));
+    return 0;
+  }
+  NEXT_ID++;
+  // 0 is reserved for failed sends
+  if (NEXT_ID == 0) {
+    NEXT_ID = 1;
+  }
+  return queued.id;
+}
+
+bool motortask::takeCompletion(Completion& completion) {
+  return xQueueReceive(COMPLETION_QUEUE, &completion, 0) == pdPASS;
+}
+
+#ifdef CONFIG_MOTOR_BACKEND_STEPPER
+// The stepper counts its steps, so it moves to positions without an encoder
+static bool positionKnown() { return MotorBackend::homed(); }
+static int32_t doorPosition() { return MotorBackend::position(); }
+static int32_t travelLength() { return MotorBackend::openPosition(); }
+#else
+static bool positionKnown() { return encoder::homed() and encoder::travelPulses() > 0; }
+static int32_t doorPosition() { return encoder::position(); }
+static int32_t travelLength() { return encoder::travelPulses(); }
+#endif
+
+static uint32_t elapsedMs(const Movement& movement) {
+  uint32_t elapsed = pdTICKS_TO_MS(xTaskGetTickCount() - movement.startTime);
+  if (movement.cmd.cmd != motortask::Cmd::JOG) {
+    elapsed += movement.cmd.ms;
+  }
+  return elapsed;
+}
+
+// With a top limit switch, an open runs until the switch and the fixed open duration is only a
+// backstop. The learned open duration might end short of the top.
+static bool openToSwitch(const motortask::Command& cmd) {
+  return doorswitch::HAS_TOP_LIMIT and not cmd.forced;
+}
+
+static bool closing(const motortask::Command& cmd) {
+  return cmd.cmd == motortask::Cmd::CLOSE or (cmd.cmd == motortask::Cmd::JOG and cmd.close);
+}
+
+// The limit switches are checked before the stall, a stall at an end stop is not a jam
+static std::optional<motortask::Result> endCondition(const Movement& movement, bool stalled) {
+  using motortask::Result;
+  const motortask::Command& cmd = movement.cmd;
+  uint32_t elapsed = elapsedMs(movement);
+  if ((cmd.cmd == motortask::Cmd::CLOSE and not cmd.unlimited) or
+      (cmd.cmd == motortask::Cmd::MOVE and movement.close)) {
+    if (not cmd.forced and doorswitch::closed()) {
+      return Result::REACHED_SWITCH;
+    }
+  }
+  if ((cmd.cmd == motortask::Cmd::OPEN and not cmd.unlimited) or
+      (cmd.cmd == motortask::Cmd::MOVE and not movement.close)) {
+    if (not cmd.forced and doorswitch::topLimit()) {
+      return Result::REACHED_SWITCH;
+    }
+  }
+  if ((cmd.cmd == motortask::Cmd::CLOSE and not cmd.unlimited) or
+      cmd.cmd == motortask::Cmd::MOVE) {
+    if (elapsed >= traveltime::closeTimeoutMs()) {
+      return Result::TIMED_OUT;
+    }
+  }
+  if (stalled) {
+    return Result::STALLED;
+  }
+  if (cmd.cmd == motortask::Cmd::OPEN and not cmd.unlimited) {
+    bool fixedDuration = openToSwitch(cmd) or cmd.fullTravel;
+    uint32_t limitMs = fixedDuration ? config::OPEN_DURATION_MS : traveltime::openDurationMs();
+    if (elapsed >= limitMs) {
+      return Result::TRAVEL_DONE;
+    }
+    if (not fixedDuration and encoder::homed() and encoder::travelPulses() > 0 and
+        encoder::position() >= encoder::travelPulses()) {
+      return Result::TRAVEL_DONE;
+    }
+  }
+  // A move to the closed position ends at the door switch, which also homes the position
+  if (cmd.cmd == motortask::Cmd::MOVE and (movement.target > 0 or cmd.forced)) {
+    int32_t position = doorPosition();
+    if (movement.close ? position <= movement.target : position >= movement.target) {
+      return Result::TRAVEL_DONE;
+    }
+  }
+  if (cmd.cmd == motortask::Cmd::JOG and elapsed >= cmd.ms) {
+    return Result::TRAVEL_DONE;
+  }
+  return std::nullopt;
+}
+
+static void logTrip(interlock::Trip trip) {
+  if (trip == interlock::Trip::SWITCH) {
+    uint32_t latencyUs = interlock::stats().lastLatencyUs;
+    ESP_LOGI(MOTOR_TASK_TAG, "Interlock stopped the motor %lu us after the switch edge",
+             latencyUs);
+    if (latencyUs > CONFIG_MOTOR_INTERLOCK_MAX_LATENCY) {
+      ESP_LOGW(MOTOR_TASK_TAG, "Interlock latency exceeds the bound of %d us",
+               CONFIG_MOTOR_INTERLOCK_MAX_LATENCY);
+    }
+  } else if (trip == interlock::Trip::DEADLINE) {
+    ESP_LOGW(MOTOR_TASK_TAG, "Interlock stopped the motor at the deadline");
+  }
+}
+
+static void updateEncoder(motortask::Result result) {
+  const Movement& movement = *ACTIVE;
+  if (result == motortask::Result::REACHED_SWITCH and movement.close) {
+    encoder::home();
+  }
+  // The first open from the closed door or a manual open, which runs until the top end stop or
+  // the top limit switch, calibrates the travel length
+  bool atTop = result == motortask::Result::STALLED or
+               (result == motortask::Result::REACHED_SWITCH and not movement.close);
+  if (atTop and movement.cmd.cmd == motortask::Cmd::OPEN and
+      encoder::homed() and movement.startPosition <= encoder::CLOSED_TOLERANCE_PULSES and
+      (encoder::travelPulses() == 0 or movement.cmd.unlimited)) {
+    encoder::calibrateTravel();
+  }
+  ESP_LOGI(MOTOR_TASK_TAG, "Encoder position %ld of %ld pulses", encoder::position(),
+           encoder::travelPulses());
+}
+
+static void complete(motortask::Result result, bool stopMotor) {
+  logTrip(interlock::disarm());
+  if (stopMotor) {
+    MotorBackend::stop();
+  }
+  if (encoder::ENABLED) {
+    updateEncoder(result);
+  }
+  motortask::Completion completion = {ACTIVE->id, result, elapsedMs(*ACTIVE)};
+  ESP_LOGD(MOTOR_TASK_TAG, "Movement %lu done with result %d after %lu ms", completion.id,
+           static_cast<int>(result), completion.elapsedMs);
+  ACTIVE.reset();
+  if (xQueueSend(COMPLETION_QUEUE, &completion, 0) != pdPASS) {
+    ESP_LOGW(MOTOR_TASK_TAG, "Completion queue full, dropping completion %lu", completion.id);
+  }
+  if (EVENT_TASK != nullptr) {
+    xTaskNotifyGive(EVENT_TASK);
+  }
+}
+
+static void drive(const Movement& movement, uint32_t travelMs) {
+#ifdef CONFIG_MOTOR_BACKEND_STEPPER
+  if (movement.cmd.cmd == motortask::Cmd::MOVE) {
+    // Stops exactly at the target
+    MotorBackend::moveTo(movement.target);
+    return;
+  }
+#endif
+#if CONFIG_INVERT_MOTOR_DIRECTION
+  MotorBackend::driveDir(!movement.close, travelMs);
+#else
+  MotorBackend::driveDir(movement.close, travelMs);
+#endif
+}
+
+// The speed profile slows down the motor before the expected end of travel
+static uint32_t remainingTravelMs(const Movement& movement) {
+  const motortask::Command& cmd = movement.cmd;
+  if (cmd.cmd == motortask::Cmd::JOG) {
+    return cmd.ms;
+  }
+  if (cmd.cmd == motortask::Cmd::MOVE) {
+    int32_t distance = std::abs(movement.target - doorPosition());
+    return static_cast<int64_t>(traveltime::travelMs()) * distance / travelLength();
+  }
+  uint32_t elapsed = elapsedMs(movement);
+  if (elapsed < traveltime::travelMs()) {
+    return traveltime::travelMs() - elapsed;
+  }
+  return 0;
+}
+
+static void armInterlock(const Movement& movement) {
+  const motortask::Command& cmd = movement.cmd;
+  uint32_t elapsed = elapsedMs(movement);
+  if ((cmd.cmd == motortask::Cmd::CLOSE and not cmd.unlimited) or
+      (cmd.cmd == motortask::Cmd::MOVE and movement.close)) {
+    uint32_t deadlineMs = 0;
+    if (elapsed < traveltime::closeTimeoutMs()) {
+      deadlineMs = traveltime::closeTimeoutMs() - elapsed;
+    }
+    interlock::arm(true, cmd.forced, deadlineMs);
+  } else if (doorswitch::HAS_TOP_LIMIT and
+             ((cmd.cmd == motortask::Cmd::OPEN and not cmd.unlimited) or
+              (cmd.cmd == motortask::Cmd::MOVE and not movement.close))) {
+    // The regular end of an open comes first, the deadline is only a backstop
+    uint32_t deadlineMs = 0;
+    if (elapsed < config::MAX_CLOSE_DURATION) {
+      deadlineMs = config::MAX_CLOSE_DURATION - elapsed;
+    }
+    interlock::arm(false, cmd.forced, deadlineMs);
+  }
+}
+
+static void startMotor(const Movement& movement) {
+  drive(movement, remainingTravelMs(movement));
+  currentsense::motorStarted();
+  encoder::motorStarted(not movement.close);
+  armInterlock(movement);
+}
+
+// The interlock trips on the first raw edge of the limit switch. If the debounced state does
+// not follow once the switch was quiet, the edge was a bounce or a glitch, and the movement
+// continues with the remaining time. Otherwise it would wait with a cut motor until the timeout.
+static void resumeAfterSpuriousTrip() {
+  int64_t lastEdgeUs = 0;
+  if (interlock::tripped(lastEdgeUs) != interlock::Trip::SWITCH or
+      esp_timer_get_time() - lastEdgeUs < SWITCH_CONFIRM_US) {
+    return;
+  }
+  ESP_LOGW(MOTOR_TASK_TAG, "Limit switch did not confirm the interlock stop, resuming");
+  // The stepper only starts again after a stop
+  MotorBackend::stop();
+  startMotor(*ACTIVE);
+}
+
+static void start(const QueuedCommand& queued) {
+  Movement movement = {queued.cmd, queued.id, xTaskGetTickCount(), closing(queued.cmd),
+                       doorPosition(), 0};
+  bool moveAllowed = motortask::POSITION_CONTROL and positionKnown();
+  if (queued.cmd.cmd == motortask::Cmd::MOVE and moveAllowed) {
+    movement.target = static_cast<int64_t>(travelLength()) * queued.cmd.percent / 100;
+    movement.close = movement.target < movement.startPosition;
+  }
+  bool close = movement.close;
+  if (ACTIVE) {
+    // A movement in the same direction continues without a new start
+    bool reversing = ACTIVE->close != close;
+    complete(motortask::Result::CANCELLED, reversing);
+  }
+  ACTIVE = movement;
+  if (queued.cmd.cmd == motortask::Cmd::MOVE and not moveAllowed) {
+    ESP_LOGW(MOTOR_TASK_TAG, "Moving to a position requires a known door position");
+    complete(motortask::Result::CANCELLED, true);
+    return;
+  }
+  // A stall of an earlier movement
+  currentsense::takeStall();
+  // A resumed movement might already be over
+  std::optional<motortask::Result> result = endCondition(movement, false);
+  if (result) {
+    complete(*result, true);
+    return;
+  }
+  startMotor(movement);
+}
+
+void motortask::task(void* args) {
+  QueuedCommand queued = {};
+  while (true) {
+    TickType_t waitTicks = portMAX_DELAY;
+    if (ACTIVE) {
+      waitTicks = pdMS_TO_TICKS(SUPERVISION_PERIOD_MS);
+    }
+    if (xQueueReceive(COMMAND_QUEUE, &queued, waitTicks) == pdPASS) {
+      if (queued.cmd.cmd != Cmd::STOP) {
+        start(queued);
+      } else if (ACTIVE) {
+        complete(Result::CANCELLED, true);
+      } else {
+        MotorBackend::stop();
+      }
+    }
+    if (ACTIVE) {
+      // The current sensing already stopped the motor. The encoder is updated in every cycle.
+      bool encoderStall = encoder::update();
+      bool stalled = currentsense::takeStall() or encoderStall;
+      std::optional<Result> result = endCondition(*ACTIVE, stalled);
+      if (result) {
+        complete(*result, true);
+      } else {
+        resumeAfterSpuriousTrip();
+      }
+    }
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef MAIN_MOTOR_TASK_H_
+#define MAIN_MOTOR_TASK_H_
+
+#include <freertos/FreeRTOS.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sdkconfig.h"
+
+/**
+ * Motor actor task. It is the only user of the motor backend while the application runs. It
+ * takes commands through a queue, supervises the end conditions of a movement every
+ * SUPERVISION_PERIOD_MS and reports the end of a movement to the event task with a completion.
+ */
+namespace motortask {
+
+// Moves to a position need the stepper position or the DC motor encoder
+#if defined(CONFIG_MOTOR_BACKEND_STEPPER) || defined(CONFIG_MOTOR_ENCODER)
+static constexpr bool POSITION_CONTROL = true;
+#else
+static constexpr bool POSITION_CONTROL = false;
+#endif
+
+static constexpr uint32_t SUPERVISION_PERIOD_MS = 10;
+static constexpr size_t QUEUE_DEPTH = 4;
+
+enum class Cmd : uint8_t { OPEN, CLOSE, STOP, JOG, MOVE };
+
+enum class Result : uint8_t {
+  // Close: the door switch reports a closed door. Open: the top limit switch reports a fully
+  // opened door.
+  REACHED_SWITCH,
+  // Open: the open duration is over or the encoder reached the open position. With a top limit
+  // switch, only the fixed open duration ends an open. Jog: the jog duration is over. Move: the
+  // target position was reached.
+  TRAVEL_DONE,
+  // Close: the door was not closed within the close timeout
+  TIMED_OUT,
+  // The current sensing stopped the motor or the encoder pulses stopped
+  STALLED,
+  // Stopped by a STOP command or replaced by another command
+  CANCELLED,
+};
+
+struct Command {
+  Cmd cmd;
+  // Close: the door switch does not end the movement
+  bool forced;
+  // Open and close: only a stall or a STOP command end the movement
+  bool unlimited;
+  // Jog: direction
+  bool close;
+  // Open and close: time which already elapsed before a resumed movement. Jog: duration.
+  uint32_t ms;
+  // Move: target in percent of the full travel, from the stepper position or the calibrated
+  // encoder travel
+  uint8_t percent;
+  // Open: runs for the fixed open duration instead of the learned one, so the door is fully
+  // opened and the following close can be measured
+  bool fullTravel;
+};
+
+struct Completion {
+  uint32_t id;
+  Result result;
+  // Includes the elapsed time of a resumed movement
+  uint32_t elapsedMs;
+};
+
+void init();
+
+/**
+ * Task which is notified with xTaskNotifyGive for every completion.
+ */
+void setEventTask(TaskHandle_t task);
+
+/**
+ * Returns the ID of the movement, which is reported with its completion, or 0 if the queue is
+ * full. STOP does not have a completion of its own. Must only be called from one task.
+ */
+uint32_t send(const Command& cmd);
+bool takeCompletion(Completion& completion);
+
+void task(void* args);
+
+}  // namespace motortask
+
+#endif /* MAIN_MOTOR_TASK_H_ */
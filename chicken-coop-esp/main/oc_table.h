@@ -0,0 +1,32 @@
+#ifndef MAIN_OC_TABLE_H_
+#define MAIN_OC_TABLE_H_
+
+#include <cstdint>
+
+// Open and close time of a day in minutes of the day
+struct OcTimes {
+  uint16_t open;
+  uint16_t close;
+};
+
+// The open-close table always contains February 29, which is simply skipped in other years.
+static constexpr unsigned OC_TABLE_DAYS = 366;
+
+// Index of the first day of each month in the open-close table
+static constexpr uint16_t OC_MONTH_OFFSETS[12] = {0,   31,  60,  91,  121, 152,
+                                                  182, 213, 244, 274, 305, 335};
+
+/**
+ * Returns the open-close table index for a given date.
+ * @param month Month from 0 to 11
+ * @param day Day of the month from 0 to 30
+ */
+constexpr unsigned ocTableIndex(unsigned month, unsigned day) {
+  return OC_MONTH_OFFSETS[month] + day;
+}
+
+static_assert(ocTableIndex(1, 28) == 59, "February 29 must have its own entry");
+static_assert(ocTableIndex(2, 0) == 60, "March 1 must follow February 29");
+static_assert(ocTableIndex(11, 30) == OC_TABLE_DAYS - 1, "December 31 must be the last entry");
+
+#endif /* MAIN_OC_TABLE_H_ */
@@ -1,121 +0,0 @@
-/*
- * This file was auto-generated by the sun-times-to-code.py script.
- * Generated on the 2022-01-16 14:20:07.965138.
- */
-
-#include "open_close_times.h"
-
-const OcTableWrapper* OPEN_CLOSE_MONTHS[12] = {
-    &OC_TIMES_JANUARY,   &OC_TIMES_FEBRUARY, &OC_TIMES_MARCH,    &OC_TIMES_APRIL,
-    &OC_TIMES_MAY,       &OC_TIMES_JUNE,     &OC_TIMES_JULY,     &OC_TIMES_AUGUST,
-    &OC_TIMES_SEPTEMBER, &OC_TIMES_OCTOBER,  &OC_TIMES_NOVEMBER, &OC_TIMES_DECEMBER,
-};
-
-// Open-Close times specified as a 2D array for each month
-const OcTableWrapper OC_TIMES_JANUARY = {
-    .month = {{8, 19, 16, 45}, {8, 19, 16, 46}, {8, 19, 16, 47}, {8, 19, 16, 48}, {8, 18, 16, 49},
-              {8, 18, 16, 50}, {8, 18, 16, 51}, {8, 18, 16, 52}, {8, 17, 16, 54}, {8, 17, 16, 55},
-              {8, 16, 16, 56}, {8, 16, 16, 57}, {8, 15, 16, 59}, {8, 15, 17, 0},  {8, 14, 17, 2},
-              {8, 14, 17, 3},  {8, 13, 17, 4},  {8, 12, 17, 6},  {8, 11, 17, 7},  {8, 10, 17, 9},
-              {8, 9, 17, 10},  {8, 8, 17, 12},  {8, 7, 17, 13},  {8, 6, 17, 15},  {8, 5, 17, 16},
-              {8, 4, 17, 18},  {8, 3, 17, 20},  {8, 2, 17, 21},  {8, 1, 17, 23},  {7, 59, 17, 24},
-              {7, 58, 17, 26}}};
-
-const OcTableWrapper OC_TIMES_FEBRUARY = {
-    .month = {{7, 57, 17, 28}, {7, 55, 17, 29}, {7, 54, 17, 31}, {7, 53, 17, 32}, {7, 51, 17, 34},
-              {7, 50, 17, 36}, {7, 48, 17, 37}, {7, 46, 17, 39}, {7, 45, 17, 41}, {7, 43, 17, 42},
-              {7, 42, 17, 44}, {7, 40, 17, 46}, {7, 38, 17, 47}, {7, 37, 17, 49}, {7, 35, 17, 51},
-              {7, 33, 17, 53}, {7, 31, 17, 54}, {7, 29, 17, 56}, {7, 28, 17, 58}, {7, 26, 17, 59},
-              {7, 24, 18, 1},  {7, 22, 18, 3},  {7, 20, 18, 4},  {7, 18, 18, 6},  {7, 16, 18, 8},
-              {7, 14, 18, 9},  {7, 12, 18, 11}, {7, 10, 18, 13}, {7, 10, 18, 13}, {7, 10, 18, 13},
-              {7, 10, 18, 13}}};
-
-const OcTableWrapper OC_TIMES_MARCH = {
-    .month = {{7, 8, 18, 14},  {7, 6, 18, 16},  {7, 4, 18, 18},  {7, 2, 18, 19},  {7, 0, 18, 21},
-              {6, 57, 18, 23}, {6, 55, 18, 24}, {6, 53, 18, 26}, {6, 51, 18, 28}, {6, 49, 18, 29},
-              {6, 47, 18, 31}, {6, 45, 18, 33}, {6, 42, 18, 34}, {6, 40, 18, 36}, {6, 38, 18, 38},
-              {6, 36, 18, 39}, {6, 33, 18, 41}, {6, 31, 18, 43}, {6, 29, 18, 44}, {6, 27, 18, 46},
-              {6, 24, 18, 48}, {6, 22, 18, 49}, {6, 20, 18, 51}, {6, 18, 18, 53}, {6, 15, 18, 54},
-              {6, 13, 18, 56}, {6, 11, 18, 58}, {6, 9, 18, 59},  {6, 6, 19, 1},   {6, 4, 19, 3},
-              {6, 2, 19, 4}}};
-
-const OcTableWrapper OC_TIMES_APRIL = {
-    .month = {{5, 59, 19, 6},  {5, 57, 19, 8},  {5, 55, 19, 9},  {5, 52, 19, 11}, {5, 50, 19, 13},
-              {5, 48, 19, 15}, {5, 46, 19, 16}, {5, 43, 19, 18}, {5, 41, 19, 20}, {5, 39, 19, 21},
-              {5, 37, 19, 23}, {5, 34, 19, 25}, {5, 32, 19, 27}, {5, 30, 19, 28}, {5, 28, 19, 30},
-              {5, 25, 19, 32}, {5, 23, 19, 34}, {5, 21, 19, 35}, {5, 19, 19, 37}, {5, 16, 19, 39},
-              {5, 14, 19, 41}, {5, 12, 19, 42}, {5, 10, 19, 44}, {5, 8, 19, 46},  {5, 6, 19, 48},
-              {5, 4, 19, 50},  {5, 1, 19, 51},  {4, 59, 19, 53}, {4, 57, 19, 55}, {4, 55, 19, 57},
-              {4, 55, 19, 57}}};
-
-const OcTableWrapper OC_TIMES_MAY = {
-    .month = {{4, 53, 19, 58}, {4, 51, 20, 0},  {4, 49, 20, 2},  {4, 47, 20, 4},  {4, 45, 20, 6},
-              {4, 43, 20, 7},  {4, 41, 20, 9},  {4, 39, 20, 11}, {4, 38, 20, 13}, {4, 36, 20, 14},
-              {4, 34, 20, 16}, {4, 32, 20, 18}, {4, 30, 20, 20}, {4, 29, 20, 21}, {4, 27, 20, 23},
-              {4, 25, 20, 25}, {4, 24, 20, 26}, {4, 22, 20, 28}, {4, 21, 20, 29}, {4, 19, 20, 31},
-              {4, 18, 20, 33}, {4, 16, 20, 34}, {4, 15, 20, 36}, {4, 13, 20, 37}, {4, 12, 20, 39},
-              {4, 11, 20, 40}, {4, 9, 20, 42},  {4, 8, 20, 43},  {4, 7, 20, 44},  {4, 6, 20, 46},
-              {4, 5, 20, 47}}};
-
-const OcTableWrapper OC_TIMES_JUNE = {
-    .month = {{4, 4, 20, 48},  {4, 3, 20, 50},  {4, 2, 20, 51},  {4, 1, 20, 52},  {4, 1, 20, 53},
-              {4, 0, 20, 54},  {3, 59, 20, 55}, {3, 59, 20, 56}, {3, 58, 20, 57}, {3, 57, 20, 58},
-              {3, 57, 20, 59}, {3, 57, 20, 59}, {3, 56, 21, 0},  {3, 56, 21, 1},  {3, 56, 21, 1},
-              {3, 56, 21, 2},  {3, 56, 21, 2},  {3, 56, 21, 3},  {3, 56, 21, 3},  {3, 56, 21, 4},
-              {3, 56, 21, 4},  {3, 56, 21, 4},  {3, 56, 21, 4},  {3, 57, 21, 4},  {3, 57, 21, 4},
-              {3, 58, 21, 4},  {3, 58, 21, 4},  {3, 59, 21, 4},  {3, 59, 21, 4},  {4, 0, 21, 3},
-              {4, 0, 21, 3}}};
-
-const OcTableWrapper OC_TIMES_JULY = {
-    .month = {{4, 1, 21, 3},   {4, 1, 21, 2},   {4, 2, 21, 2},   {4, 3, 21, 1},   {4, 4, 21, 1},
-              {4, 5, 21, 0},   {4, 6, 20, 59},  {4, 7, 20, 59},  {4, 8, 20, 58},  {4, 9, 20, 57},
-              {4, 11, 20, 56}, {4, 12, 20, 55}, {4, 13, 20, 54}, {4, 14, 20, 53}, {4, 16, 20, 52},
-              {4, 17, 20, 51}, {4, 18, 20, 49}, {4, 20, 20, 48}, {4, 21, 20, 47}, {4, 23, 20, 45},
-              {4, 24, 20, 44}, {4, 26, 20, 43}, {4, 27, 20, 41}, {4, 29, 20, 40}, {4, 30, 20, 38},
-              {4, 32, 20, 36}, {4, 34, 20, 35}, {4, 35, 20, 33}, {4, 37, 20, 32}, {4, 38, 20, 30},
-              {4, 40, 20, 28}}};
-
-const OcTableWrapper OC_TIMES_AUGUST = {
-    .month = {{4, 42, 20, 26}, {4, 43, 20, 24}, {4, 45, 20, 23}, {4, 47, 20, 21}, {4, 49, 20, 19},
-              {4, 50, 20, 17}, {4, 52, 20, 15}, {4, 54, 20, 13}, {4, 55, 20, 11}, {4, 57, 20, 9},
-              {4, 59, 20, 7},  {5, 0, 20, 5},   {5, 2, 20, 3},   {5, 4, 20, 1},   {5, 6, 19, 59},
-              {5, 7, 19, 57},  {5, 9, 19, 54},  {5, 11, 19, 52}, {5, 12, 19, 50}, {5, 14, 19, 48},
-              {5, 16, 19, 46}, {5, 18, 19, 44}, {5, 19, 19, 41}, {5, 21, 19, 39}, {5, 23, 19, 37},
-              {5, 24, 19, 35}, {5, 26, 19, 32}, {5, 28, 19, 30}, {5, 29, 19, 28}, {5, 31, 19, 26},
-              {5, 33, 19, 23}}};
-
-const OcTableWrapper OC_TIMES_SEPTEMBER = {
-    .month = {{5, 34, 19, 21}, {5, 36, 19, 19}, {5, 38, 19, 17}, {5, 39, 19, 14}, {5, 41, 19, 12},
-              {5, 43, 19, 10}, {5, 44, 19, 7},  {5, 46, 19, 5},  {5, 47, 19, 3},  {5, 49, 19, 0},
-              {5, 51, 18, 58}, {5, 52, 18, 56}, {5, 54, 18, 53}, {5, 56, 18, 51}, {5, 57, 18, 49},
-              {5, 59, 18, 46}, {6, 0, 18, 44},  {6, 2, 18, 42},  {6, 4, 18, 40},  {6, 5, 18, 37},
-              {6, 7, 18, 35},  {6, 8, 18, 33},  {6, 10, 18, 30}, {6, 11, 18, 28}, {6, 13, 18, 26},
-              {6, 15, 18, 24}, {6, 16, 18, 21}, {6, 18, 18, 19}, {6, 19, 18, 17}, {6, 21, 18, 15},
-              {6, 21, 18, 15}}};
-
-const OcTableWrapper OC_TIMES_OCTOBER = {
-    .month = {{6, 23, 18, 12}, {6, 24, 18, 10}, {6, 26, 18, 8},  {6, 27, 18, 6},  {6, 29, 18, 4},
-              {6, 30, 18, 1},  {6, 32, 17, 59}, {6, 34, 17, 57}, {6, 35, 17, 55}, {6, 37, 17, 53},
-              {6, 38, 17, 51}, {6, 40, 17, 49}, {6, 42, 17, 47}, {6, 43, 17, 44}, {6, 45, 17, 42},
-              {6, 46, 17, 40}, {6, 48, 17, 38}, {6, 50, 17, 36}, {6, 51, 17, 34}, {6, 53, 17, 32},
-              {6, 54, 17, 31}, {6, 56, 17, 29}, {6, 58, 17, 27}, {6, 59, 17, 25}, {7, 1, 17, 23},
-              {7, 2, 17, 21},  {7, 4, 17, 19},  {7, 6, 17, 18},  {7, 7, 17, 16},  {7, 9, 17, 14},
-              {7, 10, 17, 12}}};
-
-const OcTableWrapper OC_TIMES_NOVEMBER = {
-    .month = {{7, 12, 17, 11}, {7, 14, 17, 9},  {7, 15, 17, 8},  {7, 17, 17, 6},  {7, 18, 17, 4},
-              {7, 20, 17, 3},  {7, 22, 17, 1},  {7, 23, 17, 0},  {7, 25, 16, 58}, {7, 26, 16, 57},
-              {7, 28, 16, 56}, {7, 30, 16, 54}, {7, 31, 16, 53}, {7, 33, 16, 52}, {7, 34, 16, 51},
-              {7, 36, 16, 49}, {7, 37, 16, 48}, {7, 39, 16, 47}, {7, 40, 16, 46}, {7, 42, 16, 45},
-              {7, 43, 16, 44}, {7, 45, 16, 43}, {7, 46, 16, 42}, {7, 48, 16, 42}, {7, 49, 16, 41},
-              {7, 50, 16, 40}, {7, 52, 16, 39}, {7, 53, 16, 39}, {7, 54, 16, 38}, {7, 56, 16, 37},
-              {7, 56, 16, 37}}};
-
-const OcTableWrapper OC_TIMES_DECEMBER = {
-    .month = {{7, 57, 16, 37}, {7, 58, 16, 36}, {7, 59, 16, 36}, {8, 1, 16, 36},  {8, 2, 16, 35},
-              {8, 3, 16, 35},  {8, 4, 16, 35},  {8, 5, 16, 35},  {8, 6, 16, 34},  {8, 7, 16, 34},
-              {8, 8, 16, 34},  {8, 9, 16, 34},  {8, 10, 16, 34}, {8, 11, 16, 34}, {8, 12, 16, 35},
-              {8, 12, 16, 35}, {8, 13, 16, 35}, {8, 14, 16, 35}, {8, 15, 16, 36}, {8, 15, 16, 36},
-              {8, 16, 16, 37}, {8, 16, 16, 37}, {8, 17, 16, 38}, {8, 17, 16, 38}, {8, 17, 16, 39},
-              {8, 18, 16, 40}, {8, 18, 16, 40}, {8, 18, 16, 41}, {8, 19, 16, 42}, {8, 19, 16, 43},
-              {8, 19, 16, 44}}};
@@ -1,25 +1,379 @@
 /*
  * This file was auto-generated by the sun-times-to-code.py script.
- * Generated on the 2022-01-16 14:20:07.966035.
+ * Generated on the 2026-10-17 02:25:31.882135.
  */
 
-// Wrapper to allow clean typedef
-typedef struct {
-  int month[31][4];
-} OcTableWrapper;
+#pragma once
 
-// Structure to access months via array index 0 to 11
-extern const OcTableWrapper* OPEN_CLOSE_MONTHS[12];
+#include "oc_table.h"
 
-extern const OcTableWrapper OC_TIMES_JANUARY;
-extern const OcTableWrapper OC_TIMES_FEBRUARY;
-extern const OcTableWrapper OC_TIMES_MARCH;
-extern const OcTableWrapper OC_TIMES_APRIL;
-extern const OcTableWrapper OC_TIMES_MAY;
-extern const OcTableWrapper OC_TIMES_JUNE;
-extern const OcTableWrapper OC_TIMES_JULY;
-extern const OcTableWrapper OC_TIMES_AUGUST;
-extern const OcTableWrapper OC_TIMES_SEPTEMBER;
-extern const OcTableWrapper OC_TIMES_OCTOBER;
-extern const OcTableWrapper OC_TIMES_NOVEMBER;
-extern const OcTableWrapper OC_TIMES_DECEMBER;
+// Open-Close times in minutes of the day for each day of a leap year. Use ocTableIndex
+// to get the index for a given date
+inline constexpr OcTimes OC_TIMES_DAY_OF_YEAR[OC_TABLE_DAYS] = {
+    {499, 1005},  // 01.01
+    {499, 1006},  // 02.01
+    {499, 1007},  // 03.01
+    {499, 1008},  // 04.01
+    {498, 1009},  // 05.01
+    {498, 1010},  // 06.01
+    {498, 1011},  // 07.01
+    {498, 1012},  // 08.01
+    {497, 1014},  // 09.01
+    {497, 1015},  // 10.01
+    {496, 1016},  // 11.01
+    {496, 1017},  // 12.01
+    {495, 1019},  // 13.01
+    {495, 1020},  // 14.01
+    {494, 1022},  // 15.01
+    {494, 1023},  // 16.01
+    {493, 1024},  // 17.01
+    {492, 1026},  // 18.01
+    {491, 1027},  // 19.01
+    {490, 1029},  // 20.01
+    {489, 1030},  // 21.01
+    {488, 1032},  // 22.01
+    {487, 1033},  // 23.01
+    {486, 1035},  // 24.01
+    {485, 1036},  // 25.01
+    {484, 1038},  // 26.01
+    {483, 1040},  // 27.01
+    {482, 1041},  // 28.01
+    {481, 1043},  // 29.01
+    {479, 1044},  // 30.01
+    {478, 1046},  // 31.01
+    {477, 1048},  // 01.02
+    {475, 1049},  // 02.02
+    {474, 1051},  // 03.02
+    {473, 1052},  // 04.02
+    {471, 1054},  // 05.02
+    {470, 1056},  // 06.02
+    {468, 1057},  // 07.02
+    {466, 1059},  // 08.02
+    {465, 1061},  // 09.02
+    {463, 1062},  // 10.02
+    {462, 1064},  // 11.02
+    {460, 1066},  // 12.02
+    {458, 1067},  // 13.02
+    {457, 1069},  // 14.02
+    {455, 1071},  // 15.02
+    {453, 1073},  // 16.02
+    {451, 1074},  // 17.02
+    {449, 1076},  // 18.02
+    {448, 1078},  // 19.02
+    {446, 1079},  // 20.02
+    {444, 1081},  // 21.02
+    {442, 1083},  // 22.02
+    {440, 1084},  // 23.02
+    {438, 1086},  // 24.02
+    {436, 1088},  // 25.02
+    {434, 1089},  // 26.02
+    {432, 1091},  // 27.02
+    {430, 1093},  // 28.02
+    {429, 1093},  // 29.02
+    {428, 1094},  // 01.03
+    {426, 1096},  // 02.03
+    {424, 1098},  // 03.03
+    {422, 1099},  // 04.03
+    {420, 1101},  // 05.03
+    {417, 1103},  // 06.03
+    {415, 1104},  // 07.03
+    {413, 1106},  // 08.03
+    {411, 1108},  // 09.03
+    {409, 1109},  // 10.03
+    {407, 1111},  // 11.03
+    {405, 1113},  // 12.03
+    {402, 1114},  // 13.03
+    {400, 1116},  // 14.03
+    {398, 1118},  // 15.03
+    {396, 1119},  // 16.03
+    {393, 1121},  // 17.03
+    {391, 1123},  // 18.03
+    {389, 1124},  // 19.03
+    {387, 1126},  // 20.03
+    {384, 1128},  // 21.03
+    {382, 1129},  // 22.03
+    {380, 1131},  // 23.03
+    {378, 1133},  // 24.03
+    {375, 1134},  // 25.03
+    {373, 1136},  // 26.03
+    {371, 1138},  // 27.03
+    {369, 1139},  // 28.03
+    {366, 1141},  // 29.03
+    {364, 1143},  // 30.03
+    {362, 1144},  // 31.03
+    {359, 1146},  // 01.04
+    {357, 1148},  // 02.04
+    {355, 1149},  // 03.04
+    {352, 1151},  // 04.04
+    {350, 1153},  // 05.04
+    {348, 1155},  // 06.04
+    {346, 1156},  // 07.04
+    {343, 1158},  // 08.04
+    {341, 1160},  // 09.04
+    {339, 1161},  // 10.04
+    {337, 1163},  // 11.04
+    {334, 1165},  // 12.04
+    {332, 1167},  // 13.04
+    {330, 1168},  // 14.04
+    {328, 1170},  // 15.04
+    {325, 1172},  // 16.04
+    {323, 1174},  // 17.04
+    {321, 1175},  // 18.04
+    {319, 1177},  // 19.04
+    {316, 1179},  // 20.04
+    {314, 1181},  // 21.04
+    {312, 1182},  // 22.04
+    {310, 1184},  // 23.04
+    {308, 1186},  // 24.04
+    {306, 1188},  // 25.04
+    {304, 1190},  // 26.04
+    {301, 1191},  // 27.04
+    {299, 1193},  // 28.04
+    {297, 1195},  // 29.04
+    {295, 1197},  // 30.04
+    {293, 1198},  // 01.05
+    {291, 1200},  // 02.05
+    {289, 1202},  // 03.05
+    {287, 1204},  // 04.05
+    {285, 1206},  // 05.05
+    {283, 1207},  // 06.05
+    {281, 1209},  // 07.05
+    {279, 1211},  // 08.05
+    {278, 1213},  // 09.05
+    {276, 1214},  // 10.05
+    {274, 1216},  // 11.05
+    {272, 1218},  // 12.05
+    {270, 1220},  // 13.05
+    {269, 1221},  // 14.05
+    {267, 1223},  // 15.05
+    {265, 1225},  // 16.05
+    {264, 1226},  // 17.05
+    {262, 1228},  // 18.05
+    {261, 1229},  // 19.05
+    {259, 1231},  // 20.05
+    {258, 1233},  // 21.05
+    {256, 1234},  // 22.05
+    {255, 1236},  // 23.05
+    {253, 1237},  // 24.05
+    {252, 1239},  // 25.05
+    {251, 1240},  // 26.05
+    {249, 1242},  // 27.05
+    {248, 1243},  // 28.05
+    {247, 1244},  // 29.05
+    {246, 1246},  // 30.05
+    {245, 1247},  // 31.05
+    {244, 1248},  // 01.06
+    {243, 1250},  // 02.06
+    {242, 1251},  // 03.06
+    {241, 1252},  // 04.06
+    {241, 1253},  // 05.06
+    {240, 1254},  // 06.06
+    {239, 1255},  // 07.06
+    {239, 1256},  // 08.06
+    {238, 1257},  // 09.06
+    {237, 1258},  // 10.06
+    {237, 1259},  // 11.06
+    {237, 1259},  // 12.06
+    {236, 1260},  // 13.06
+    {236, 1261},  // 14.06
+    {236, 1261},  // 15.06
+    {236, 1262},  // 16.06
+    {236, 1262},  // 17.06
+    {236, 1263},  // 18.06
+    {236, 1263},  // 19.06
+    {236, 1264},  // 20.06
+    {236, 1264},  // 21.06
+    {236, 1264},  // 22.06
+    {236, 1264},  // 23.06
+    {237, 1264},  // 24.06
+    {237, 1264},  // 25.06
+    {238, 1264},  // 26.06
+    {238, 1264},  // 27.06
+    {239, 1264},  // 28.06
+    {239, 1264},  // 29.06
+    {240, 1263},  // 30.06
+    {241, 1263},  // 01.07
+    {241, 1262},  // 02.07
+    {242, 1262},  // 03.07
+    {243, 1261},  // 04.07
+    {244, 1261},  // 05.07
+    {245, 1260},  // 06.07
+    {246, 1259},  // 07.07
+    {247, 1259},  // 08.07
+    {248, 1258},  // 09.07
+    {249, 1257},  // 10.07
+    {251, 1256},  // 11.07
+    {252, 1255},  // 12.07
+    {253, 1254},  // 13.07
+    {254, 1253},  // 14.07
+    {256, 1252},  // 15.07
+    {257, 1251},  // 16.07
+    {258, 1249},  // 17.07
+    {260, 1248},  // 18.07
+    {261, 1247},  // 19.07
+    {263, 1245},  // 20.07
+    {264, 1244},  // 21.07
+    {266, 1243},  // 22.07
+    {267, 1241},  // 23.07
+    {269, 1240},  // 24.07
+    {270, 1238},  // 25.07
+    {272, 1236},  // 26.07
+    {274, 1235},  // 27.07
+    {275, 1233},  // 28.07
+    {277, 1232},  // 29.07
+    {278, 1230},  // 30.07
+    {280, 1228},  // 31.07
+    {282, 1226},  // 01.08
+    {283, 1224},  // 02.08
+    {285, 1223},  // 03.08
+    {287, 1221},  // 04.08
+    {289, 1219},  // 05.08
+    {290, 1217},  // 06.08
+    {292, 1215},  // 07.08
+    {294, 1213},  // 08.08
+    {295, 1211},  // 09.08
+    {297, 1209},  // 10.08
+    {299, 1207},  // 11.08
+    {300, 1205},  // 12.08
+    {302, 1203},  // 13.08
+    {304, 1201},  // 14.08
+    {306, 1199},  // 15.08
+    {307, 1197},  // 16.08
+    {309, 1194},  // 17.08
+    {311, 1192},  // 18.08
+    {312, 1190},  // 19.08
+    {314, 1188},  // 20.08
+    {316, 1186},  // 21.08
+    {318, 1184},  // 22.08
+    {319, 1181},  // 23.08
+    {321, 1179},  // 24.08
+    {323, 1177},  // 25.08
+    {324, 1175},  // 26.08
+    {326, 1172},  // 27.08
+    {328, 1170},  // 28.08
+    {329, 1168},  // 29.08
+    {331, 1166},  // 30.08
+    {333, 1163},  // 31.08
+    {334, 1161},  // 01.09
+    {336, 1159},  // 02.09
+    {338, 1157},  // 03.09
+    {339, 1154},  // 04.09
+    {341, 1152},  // 05.09
+    {343, 1150},  // 06.09
+    {344, 1147},  // 07.09
+    {346, 1145},  // 08.09
+    {347, 1143},  // 09.09
+    {349, 1140},  // 10.09
+    {351, 1138},  // 11.09
+    {352, 1136},  // 12.09
+    {354, 1133},  // 13.09
+    {356, 1131},  // 14.09
+    {357, 1129},  // 15.09
+    {359, 1126},  // 16.09
+    {360, 1124},  // 17.09
+    {362, 1122},  // 18.09
+    {364, 1120},  // 19.09
+    {365, 1117},  // 20.09
+    {367, 1115},  // 21.09
+    {368, 1113},  // 22.09
+    {370, 1110},  // 23.09
+    {371, 1108},  // 24.09
+    {373, 1106},  // 25.09
+    {375, 1104},  // 26.09
+    {376, 1101},  // 27.09
+    {378, 1099},  // 28.09
+    {379, 1097},  // 29.09
+    {381, 1095},  // 30.09
+    {383, 1092},  // 01.10
+    {384, 1090},  // 02.10
+    {386, 1088},  // 03.10
+    {387, 1086},  // 04.10
+    {389, 1084},  // 05.10
+    {390, 1081},  // 06.10
+    {392, 1079},  // 07.10
+    {394, 1077},  // 08.10
+    {395, 1075},  // 09.10
+    {397, 1073},  // 10.10
+    {398, 1071},  // 11.10
+    {400, 1069},  // 12.10
+    {402, 1067},  // 13.10
+    {403, 1064},  // 14.10
+    {405, 1062},  // 15.10
+    {406, 1060},  // 16.10
+    {408, 1058},  // 17.10
+    {410, 1056},  // 18.10
+    {411, 1054},  // 19.10
+    {413, 1052},  // 20.10
+    {414, 1051},  // 21.10
+    {416, 1049},  // 22.10
+    {418, 1047},  // 23.10
+    {419, 1045},  // 24.10
+    {421, 1043},  // 25.10
+    {422, 1041},  // 26.10
+    {424, 1039},  // 27.10
+    {426, 1038},  // 28.10
+    {427, 1036},  // 29.10
+    {429, 1034},  // 30.10
+    {430, 1032},  // 31.10
+    {432, 1031},  // 01.11
+    {434, 1029},  // 02.11
+    {435, 1028},  // 03.11
+    {437, 1026},  // 04.11
+    {438, 1024},  // 05.11
+    {440, 1023},  // 06.11
+    {442, 1021},  // 07.11
+    {443, 1020},  // 08.11
+    {445, 1018},  // 09.11
+    {446, 1017},  // 10.11
+    {448, 1016},  // 11.11
+    {450, 1014},  // 12.11
+    {451, 1013},  // 13.11
+    {453, 1012},  // 14.11
+    {454, 1011},  // 15.11
+    {456, 1009},  // 16.11
+    {457, 1008},  // 17.11
+    {459, 1007},  // 18.11
+    {460, 1006},  // 19.11
+    {462, 1005},  // 20.11
+    {463, 1004},  // 21.11
+    {465, 1003},  // 22.11
+    {466, 1002},  // 23.11
+    {468, 1002},  // 24.11
+    {469, 1001},  // 25.11
+    {470, 1000},  // 26.11
+    {472, 999},  // 27.11
+    {473, 999},  // 28.11
+    {474, 998},  // 29.11
+    {476, 997},  // 30.11
+    {477, 997},  // 01.12
+    {478, 996},  // 02.12
+    {479, 996},  // 03.12
+    {481, 996},  // 04.12
+    {482, 995},  // 05.12
+    {483, 995},  // 06.12
+    {484, 995},  // 07.12
+    {485, 995},  // 08.12
+    {486, 994},  // 09.12
+    {487, 994},  // 10.12
+    {488, 994},  // 11.12
+    {489, 994},  // 12.12
+    {490, 994},  // 13.12
+    {491, 994},  // 14.12
+    {492, 995},  // 15.12
+    {492, 995},  // 16.12
+    {493, 995},  // 17.12
+    {494, 995},  // 18.12
+    {495, 996},  // 19.12
+    {495, 996},  // 20.12
+    {496, 997},  // 21.12
+    {496, 997},  // 22.12
+    {497, 998},  // 23.12
+    {497, 998},  // 24.12
+    {497, 999},  // 25.12
+    {498, 1000},  // 26.12
+    {498, 1000},  // 27.12
+    {498, 1001},  // 28.12
+    {499, 1002},  // 29.12
+    {499, 1003},  // 30.12
+    {499, 1004},  // 31.12
+};
@@ -0,0 +1,29 @@
+#ifndef MAIN_PULSE_SOURCE_H_
+#define MAIN_PULSE_SOURCE_H_
+
+#include <cstdint>
+
+/**
+ * Source of motor encoder pulses, implemented by the GPIO edge counter of the encoder inputs.
+ */
+class PulseSource {
+ public:
+  virtual ~PulseSource() = default;
+
+  virtual bool start() = 0;
+  virtual void stop() = 0;
+
+  /**
+   * Direction of the motor. Only used by sources with a single hall input, which can not detect
+   * the direction themselves.
+   */
+  virtual void setOpening(bool opening) = 0;
+
+  /**
+   * Reads the signed pulse count, which increases while the door opens, and the time in ms.
+   * Returns false at the end of the source.
+   */
+  virtual bool read(int32_t& count, uint32_t& timeMs) = 0;
+};
+
+#endif /* MAIN_PULSE_SOURCE_H_ */
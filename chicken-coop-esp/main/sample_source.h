@@ -0,0 +1,23 @@
+#ifndef MAIN_SAMPLE_SOURCE_H_
+#define MAIN_SAMPLE_SOURCE_H_
+
+#include <cstdint>
+
+/**
+ * Source of motor current sample blocks. Keeps the ADC driver out of the current task loop.
+ */
+class SampleSource {
+ public:
+  virtual ~SampleSource() = default;
+
+  virtual bool start() = 0;
+  virtual void stop() = 0;
+
+  /**
+   * Waits for the next sample block and returns the mean raw value. Returns false on a timeout
+   * or at the end of the source.
+   */
+  virtual bool readBlock(uint16_t& blockMean, uint32_t timeoutMs) = 0;
+};
+
+#endif /* MAIN_SAMPLE_SOURCE_H_ */
@@ -0,0 +1,178 @@
+#include "schedule.h"
+
+#include <esp_crc.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+
+static constexpr char SCHEDULE_TAG[] = "schedule";
+static constexpr uint16_t MINUTES_PER_DAY = 24 * 60;
+
+static const esp_partition_t* PARTITION = nullptr;
+static const uint8_t* MAPPED = nullptr;
+static esp_partition_mmap_handle_t MAP_HANDLE = 0;
+
+static int ACTIVE_SLOT = -1;
+static uint32_t ACTIVE_SEQUENCE = 0;
+
+static bool UPLOAD_ACTIVE = false;
+static uint32_t UPLOAD_CRC = 0;
+static uint32_t UPLOAD_OFFSET = 0;
+
+static const schedule::SlotHeader& slotHeader(int slot) {
+  return *reinterpret_cast<const schedule::SlotHeader*>(MAPPED + slot * schedule::SLOT_SIZE);
+}
+
+static const OcTimes* slotTable(int slot) {
+  return reinterpret_cast<const OcTimes*>(MAPPED + slot * schedule::SLOT_SIZE +
+                                         sizeof(schedule::SlotHeader));
+}
+
+// Uploads always go to the inactive slot
+static int uploadSlot() { return ACTIVE_SLOT == 0 ? 1 : 0; }
+
+static bool payloadValid(int slot, uint32_t crc32) {
+  const OcTimes* times = slotTable(slot);
+  const uint8_t* raw = reinterpret_cast<const uint8_t*>(times);
+  if (esp_crc32_le(0, raw, schedule::PAYLOAD_SIZE) != crc32) {
+    return false;
+  }
+  for (size_t idx = 0; idx < OC_TABLE_DAYS; idx++) {
+    if (times[idx].open >= MINUTES_PER_DAY or times[idx].close >= MINUTES_PER_DAY) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool slotValid(int slot) {
+  const schedule::SlotHeader& header = slotHeader(slot);
+  return header.magic == schedule::SLOT_MAGIC and header.length == schedule::PAYLOAD_SIZE and
+         payloadValid(slot, header.crc32);
+}
+
+static void selectActiveSlot() {
+  ACTIVE_SLOT = -1;
+  ACTIVE_SEQUENCE = 0;
+  for (int slot = 0; slot < static_cast<int>(schedule::SLOT_NUM); slot++) {
+    if (not slotValid(slot)) {
+      continue;
+    }
+    uint32_t sequence = slotHeader(slot).sequence;
+    // Sequence numbers are compared with wrap around
+    if (ACTIVE_SLOT == -1 or static_cast<int32_t>(sequence - ACTIVE_SEQUENCE) > 0) {
+      ACTIVE_SLOT = slot;
+      ACTIVE_SEQUENCE = sequence;
+    }
+  }
+}
+
+esp_err_t schedule::init() {
+  PARTITION =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL);
+  if (PARTITION == nullptr) {
+    ESP_LOGW(SCHEDULE_TAG, "No schedule partition found");
+    return ESP_ERR_NOT_FOUND;
+  }
+  if (PARTITION->size < SLOT_NUM * SLOT_SIZE) {
+    ESP_LOGE(SCHEDULE_TAG, "Schedule partition too small");
+    PARTITION = nullptr;
+    return ESP_ERR_INVALID_SIZE;
+  }
+  const void* mapped = nullptr;
+  esp_err_t result = esp_partition_mmap(PARTITION, 0, SLOT_NUM * SLOT_SIZE,
+                                        ESP_PARTITION_MMAP_DATA, &mapped, &MAP_HANDLE);
+  if (result != ESP_OK) {
+    PARTITION = nullptr;
+    return result;
+  }
+  MAPPED = reinterpret_cast<const uint8_t*>(mapped);
+  selectActiveSlot();
+  if (ACTIVE_SLOT == -1) {
+    ESP_LOGI(SCHEDULE_TAG, "No valid schedule in flash");
+    return ESP_ERR_NOT_FOUND;
+  }
+  ESP_LOGI(SCHEDULE_TAG, "Using schedule %lu from slot %d", ACTIVE_SEQUENCE, ACTIVE_SLOT);
+  return ESP_OK;
+}
+
+const OcTimes* schedule::table() {
+  if (ACTIVE_SLOT == -1) {
+    return nullptr;
+  }
+  return slotTable(ACTIVE_SLOT);
+}
+
+uint32_t schedule::sequence() { return ACTIVE_SEQUENCE; }
+
+uint32_t schedule::nextUploadOffset() { return UPLOAD_OFFSET; }
+
+esp_err_t schedule::beginUpload(uint32_t length, uint32_t crc32) {
+  if (MAPPED == nullptr) {
+    return ESP_ERR_NOT_FOUND;
+  }
+  if (length != PAYLOAD_SIZE) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  int slot = uploadSlot();
+  UPLOAD_ACTIVE = false;
+  esp_err_t result = esp_partition_erase_range(PARTITION, slot * SLOT_SIZE, SLOT_SIZE);
+  if (result != ESP_OK) {
+    return result;
+  }
+  UPLOAD_CRC = crc32;
+  UPLOAD_OFFSET = 0;
+  UPLOAD_ACTIVE = true;
+  ESP_LOGI(SCHEDULE_TAG, "Schedule upload to slot %d started", slot);
+  return ESP_OK;
+}
+
+esp_err_t schedule::writeChunk(uint32_t offset, const uint8_t* data, size_t length) {
+  if (not UPLOAD_ACTIVE) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (offset != UPLOAD_OFFSET or length > MAX_CHUNK_SIZE or offset + length > PAYLOAD_SIZE) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  size_t flashOffset = uploadSlot() * SLOT_SIZE + sizeof(SlotHeader) + offset;
+  esp_err_t result = esp_partition_write(PARTITION, flashOffset, data, length);
+  if (result != ESP_OK) {
+    // Erased flash can not be written twice, so the upload has to be restarted
+    UPLOAD_ACTIVE = false;
+    return result;
+  }
+  UPLOAD_OFFSET += length;
+  return ESP_OK;
+}
+
+esp_err_t schedule::finishUpload() {
+  if (not UPLOAD_ACTIVE) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  UPLOAD_ACTIVE = false;
+  if (UPLOAD_OFFSET != PAYLOAD_SIZE) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  int slot = uploadSlot();
+  // The flash cache is invalidated by the partition writes, so the new data can be verified
+  // through the mapping.
+  if (not payloadValid(slot, UPLOAD_CRC)) {
+    ESP_LOGW(SCHEDULE_TAG, "Uploaded schedule is invalid");
+    return ESP_ERR_INVALID_CRC;
+  }
+  SlotHeader header = {};
+  header.magic = SLOT_MAGIC;
+  header.sequence = ACTIVE_SEQUENCE + 1;
+  header.length = PAYLOAD_SIZE;
+  header.crc32 = UPLOAD_CRC;
+  // Writing the header is the commit point. A reset before this keeps the old table.
+  esp_err_t result = esp_partition_write(PARTITION, slot * SLOT_SIZE, &header, sizeof(header));
+  if (result != ESP_OK) {
+    return result;
+  }
+  selectActiveSlot();
+  if (ACTIVE_SLOT != slot) {
+    return ESP_FAIL;
+  }
+  ESP_LOGI(SCHEDULE_TAG, "Schedule %lu is active now", ACTIVE_SEQUENCE);
+  return ESP_OK;
+}
@@ -0,0 +1,78 @@
+#ifndef MAIN_SCHEDULE_H_
+#define MAIN_SCHEDULE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "oc_table.h"
+
+/**
+ * Open-close table stored in a dedicated data partition, so it can be replaced without
+ * reflashing the firmware. The partition contains two slots of one flash sector each. A slot
+ * consists of a header and the packed day-of-year table. The valid slot with the highest
+ * sequence number is active. An upload is written to the inactive slot and its header is written
+ * last, which swaps in the new table atomically. The partition is memory mapped, so the table is
+ * read directly from flash.
+ */
+namespace schedule {
+
+static constexpr char PARTITION_LABEL[] = "schedule";
+static constexpr uint32_t SLOT_MAGIC = 0x44484353;  // "SCHD"
+static constexpr size_t SLOT_SIZE = 0x1000;
+static constexpr size_t SLOT_NUM = 2;
+static constexpr size_t PAYLOAD_SIZE = sizeof(OcTimes) * OC_TABLE_DAYS;
+// Maximum payload bytes per upload chunk
+static constexpr size_t MAX_CHUNK_SIZE = 128;
+
+struct SlotHeader {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t length;
+  uint32_t crc32;
+};
+
+static_assert(sizeof(SlotHeader) + PAYLOAD_SIZE <= SLOT_SIZE, "Table does not fit into a slot");
+
+/**
+ * Maps the schedule partition and selects the active slot. Returns ESP_ERR_NOT_FOUND if the
+ * partition does not exist or does not contain a valid table.
+ */
+esp_err_t init();
+
+/**
+ * Returns the table stored in flash or nullptr if there is no valid table.
+ */
+const OcTimes* table();
+
+/**
+ * Sequence number of the active table. 0 if there is no valid table.
+ */
+uint32_t sequence();
+
+/**
+ * Starts an upload by erasing the inactive slot.
+ * @param length Payload length, must be PAYLOAD_SIZE
+ * @param crc32 CRC32 of the payload
+ */
+esp_err_t beginUpload(uint32_t length, uint32_t crc32);
+
+/**
+ * Writes the next chunk. Chunks must be written in order without gaps. Returns
+ * ESP_ERR_INVALID_ARG if the offset is not the next expected offset.
+ */
+esp_err_t writeChunk(uint32_t offset, const uint8_t* data, size_t length);
+
+/**
+ * Next payload offset which is expected by writeChunk.
+ */
+uint32_t nextUploadOffset();
+
+/**
+ * Verifies the uploaded payload and makes it the active table.
+ */
+esp_err_t finishUpload();
+
+}  // namespace schedule
+
+#endif /* MAIN_SCHEDULE_H_ */
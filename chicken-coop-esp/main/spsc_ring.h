@@ -0,0 +1,65 @@
+#ifndef MAIN_SPSC_RING_H_
+#define MAIN_SPSC_RING_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Lock-free ring buffer for exactly one producer task and one consumer task. The elements are
+ * written and read in place, so large elements are not copied. The indices run freely and are
+ * only reduced modulo the capacity on access.
+ */
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N > 0 and (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+ public:
+  /**
+   * Producer: Returns the slot for the next element or nullptr if the ring is full. The element
+   * is only visible to the consumer after commit().
+   */
+  T* writeSlot() {
+    uint32_t current = head.load(std::memory_order_relaxed);
+    if (current - tail.load(std::memory_order_acquire) == N) {
+      return nullptr;
+    }
+    return &slots[current % N];
+  }
+
+  void commit() {
+    uint32_t next = head.load(std::memory_order_relaxed) + 1;
+    head.store(next, std::memory_order_release);
+    uint32_t depth = next - tail.load(std::memory_order_relaxed);
+    if (depth > highWater.load(std::memory_order_relaxed)) {
+      highWater.store(depth, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Consumer: Returns the oldest element or nullptr if the ring is empty. The element stays
+   * valid until pop().
+   */
+  const T* front() const {
+    uint32_t current = tail.load(std::memory_order_relaxed);
+    if (current == head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &slots[current % N];
+  }
+
+  void pop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  static constexpr size_t capacity() { return N; }
+  // Maximum number of elements which were queued at the same time
+  uint32_t highWaterMark() const { return highWater.load(std::memory_order_relaxed); }
+
+ private:
+  std::array<T, N> slots = {};
+  std::atomic<uint32_t> head = 0;
+  std::atomic<uint32_t> tail = 0;
+  std::atomic<uint32_t> highWater = 0;
+};
+
+#endif /* MAIN_SPSC_RING_H_ */
@@ -0,0 +1,82 @@
+#ifndef MAIN_STALL_DETECTOR_H_
+#define MAIN_STALL_DETECTOR_H_
+
+#include <cstdint>
+
+/**
+ * Detects a stalled motor from the motor current. The input values are the mean raw ADC values
+ * of fixed sample blocks, which are smoothed with a fixed-point exponential moving average. A
+ * stall is detected once the filtered value stayed at or above the threshold for a number of
+ * blocks. The inrush current after the motor start is ignored.
+ *
+ * Only works on raw values and block counts, the conversion to mA and ms stays in the current
+ * task. host/current_replay.cpp feeds it with the block means of a CT trace.
+ */
+struct StallConfig {
+  uint16_t thresholdRaw;
+  // Consecutive blocks at or above the threshold until a stall is detected
+  uint16_t stallBlocks;
+  // Blocks after the motor start without stall detection
+  uint16_t blankingBlocks;
+  // Weight of a new block mean in the moving average is 2^-filterShift
+  uint8_t filterShift;
+};
+
+class StallDetector {
+ public:
+  explicit StallDetector(const StallConfig& cfg) : cfg(cfg) {}
+
+  // Starts the blanking again and drops the filter state of the last movement
+  void reset() {
+    filtered = 0;
+    blocks = 0;
+    blocksAbove = 0;
+    peakRaw = 0;
+  }
+
+  /**
+   * Adds the mean of the next sample block. Returns true if a stall was detected.
+   */
+  bool feed(uint16_t blockMean) {
+    int32_t value = static_cast<int32_t>(blockMean) << FRACTION_BITS;
+    if (blocks == 0) {
+      filtered = value;
+    } else {
+      filtered += (value - filtered) >> cfg.filterShift;
+    }
+    if (blocks < UINT32_MAX) {
+      blocks++;
+    }
+    if (blocks <= cfg.blankingBlocks) {
+      return false;
+    }
+    uint16_t filteredRaw = filteredValue();
+    if (filteredRaw > peakRaw) {
+      peakRaw = filteredRaw;
+    }
+    if (filteredRaw < cfg.thresholdRaw) {
+      blocksAbove = 0;
+      return false;
+    }
+    blocksAbove++;
+    return blocksAbove >= cfg.stallBlocks;
+  }
+
+  uint16_t filteredValue() const { return filtered >> FRACTION_BITS; }
+  // Highest filtered value after the blanking time
+  uint16_t peak() const { return peakRaw; }
+  uint32_t blockCount() const { return blocks; }
+  const StallConfig& config() const { return cfg; }
+
+ private:
+  static constexpr int FRACTION_BITS = 8;
+
+  StallConfig cfg;
+  // Filtered value with FRACTION_BITS fractional bits
+  int32_t filtered = 0;
+  uint32_t blocks = 0;
+  uint32_t blocksAbove = 0;
+  uint16_t peakRaw = 0;
+};
+
+#endif /* MAIN_STALL_DETECTOR_H_ */
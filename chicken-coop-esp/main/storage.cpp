@@ -0,0 +1,78 @@
+#include "storage.h"
+
+#include <esp_crc.h>
+#include <esp_log.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+
+#include <array>
+#include <cstring>
+
+static constexpr char STORAGE_TAG[] = "storage";
+
+esp_err_t storage::init() {
+  esp_err_t result = nvs_flash_init();
+  if (result == ESP_ERR_NVS_NO_FREE_PAGES or result == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    ESP_LOGW(STORAGE_TAG, "NVS partition needs to be erased");
+    result = nvs_flash_erase();
+    if (result != ESP_OK) {
+      return result;
+    }
+    result = nvs_flash_init();
+  }
+  return result;
+}
+
+esp_err_t storage::loadBlob(const char* key, uint16_t version, void* data, size_t length) {
+  if (length > MAX_BLOB_SIZE) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  nvs_handle_t handle;
+  esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  std::array<uint8_t, sizeof(BlobHeader) + MAX_BLOB_SIZE> buf;
+  size_t readLen = buf.size();
+  result = nvs_get_blob(handle, key, buf.data(), &readLen);
+  nvs_close(handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  BlobHeader header;
+  std::memcpy(&header, buf.data(), sizeof(header));
+  if (readLen != sizeof(header) + length or header.version != version or
+      header.length != length) {
+    return ESP_ERR_INVALID_VERSION;
+  }
+  if (esp_crc32_le(0, buf.data() + sizeof(header), length) != header.crc32) {
+    return ESP_ERR_INVALID_CRC;
+  }
+  std::memcpy(data, buf.data() + sizeof(header), length);
+  return ESP_OK;
+}
+
+esp_err_t storage::storeBlob(const char* key, uint16_t version, const void* data,
+                             size_t length) {
+  if (length > MAX_BLOB_SIZE) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  std::array<uint8_t, sizeof(BlobHeader) + MAX_BLOB_SIZE> buf;
+  BlobHeader header = {};
+  header.version = version;
+  header.length = length;
+  header.crc32 = esp_crc32_le(0, reinterpret_cast<const uint8_t*>(data), length);
+  std::memcpy(buf.data(), &header, sizeof(header));
+  std::memcpy(buf.data() + sizeof(header), data, length);
+  nvs_handle_t handle;
+  esp_err_t result = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+  if (result != ESP_OK) {
+    return result;
+  }
+  result = nvs_set_blob(handle, key, buf.data(), sizeof(header) + length);
+  if (result == ESP_OK) {
+    result = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  return result;
+}
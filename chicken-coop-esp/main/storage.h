@@ -0,0 +1,49 @@
+#ifndef MAIN_STORAGE_H_
+#define MAIN_STORAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+/**
+ * Small wrapper around the NVS to store versioned and CRC protected blobs.
+ */
+namespace storage {
+
+static constexpr char NVS_NAMESPACE[] = "chicken-coop";
+static constexpr size_t MAX_BLOB_SIZE = 128;
+// Size of a single NVS entry. Every blob requires an index entry and a data entry header.
+static constexpr size_t NVS_ENTRY_SIZE = 32;
+
+struct BlobHeader {
+  uint16_t version;
+  uint16_t length;
+  uint32_t crc32;
+};
+
+/**
+ * Flash space used by a single write of a blob with the given size.
+ */
+constexpr size_t blobFlashCost(size_t length) {
+  size_t dataEntries = (sizeof(BlobHeader) + length + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE;
+  return (2 + dataEntries) * NVS_ENTRY_SIZE;
+}
+
+/**
+ * Initializes the NVS flash. The NVS partition is erased if it is full or has an
+ * incompatible format.
+ */
+esp_err_t init();
+
+/**
+ * Loads a blob. Returns ESP_ERR_NVS_NOT_FOUND if the blob does not exist, ESP_ERR_INVALID_CRC
+ * if the checksum does not match and ESP_ERR_INVALID_VERSION if the version or length does
+ * not match.
+ */
+esp_err_t loadBlob(const char* key, uint16_t version, void* data, size_t length);
+esp_err_t storeBlob(const char* key, uint16_t version, const void* data, size_t length);
+
+}  // namespace storage
+
+#endif /* MAIN_STORAGE_H_ */
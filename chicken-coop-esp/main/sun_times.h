@@ -0,0 +1,269 @@
+#ifndef MAIN_SUN_TIMES_H_
+#define MAIN_SUN_TIMES_H_
+
+#include <cstdint>
+
+#include "oc_table.h"
+#include "sdkconfig.h"
+
+/**
+ * Compile-time implementation of the NOAA sunrise and sunset algorithm. It is used to generate
+ * the open-close table for the configured location, so no CSV file has to be prepared for a new
+ * location. The trigonometric functions are implemented here because the <cmath> functions
+ * can not be used in constant expressions.
+ */
+namespace suntimes {
+
+// Sun event the opening or closing time is based on
+enum class SunEvent : uint8_t { HORIZON = 0, CIVIL_TWILIGHT = 1, NAUTICAL_TWILIGHT = 2 };
+
+struct Site {
+  // Latitude in degrees, north is positive
+  double latitude;
+  // Longitude in degrees, east is positive
+  double longitude;
+  // Offset of the local time to UTC in minutes, no daylight saving time
+  int utcOffsetMin;
+  // Opening time is the offset added to the morning event
+  SunEvent openEvent;
+  int openOffsetMin;
+  // Closing time is the offset added to the evening event
+  SunEvent closeEvent;
+  int closeOffsetMin;
+};
+
+struct OcTable {
+  OcTimes days[OC_TABLE_DAYS];
+};
+
+namespace detail {
+
+static constexpr double PI = 3.14159265358979323846;
+
+constexpr double rad(double deg) { return deg * PI / 180.0; }
+
+constexpr double deg(double rad) { return rad * 180.0 / PI; }
+
+// Remainder of x / m in the range [0, m)
+constexpr double wrap(double x, double m) {
+  double r = x - static_cast<double>(static_cast<int64_t>(x / m)) * m;
+  if (r < 0) {
+    r += m;
+  }
+  return r;
+}
+
+constexpr double sin(double x) {
+  x = wrap(x + PI, 2 * PI) - PI;
+  double term = x;
+  double sum = x;
+  for (int n = 1; n < 12; n++) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double cos(double x) { return sin(x + PI / 2); }
+
+constexpr double tan(double x) { return sin(x) / cos(x); }
+
+constexpr double sqrt(double x) {
+  if (x <= 0) {
+    return 0;
+  }
+  double y = x < 1 ? 1 : x;
+  for (int i = 0; i < 40; i++) {
+    y = 0.5 * (y + x / y);
+  }
+  return y;
+}
+
+constexpr double atan(double x) {
+  if (x < 0) {
+    return -atan(-x);
+  }
+  if (x > 1) {
+    return PI / 2 - atan(1 / x);
+  }
+  // Halve the angle twice so the series converges quickly
+  x = x / (1 + sqrt(1 + x * x));
+  x = x / (1 + sqrt(1 + x * x));
+  double term = x;
+  double sum = x;
+  for (int n = 1; n < 16; n++) {
+    term *= -x * x;
+    sum += term / (2 * n + 1);
+  }
+  return 4 * sum;
+}
+
+constexpr double asin(double x) {
+  if (x >= 1) {
+    return PI / 2;
+  }
+  if (x <= -1) {
+    return -PI / 2;
+  }
+  return atan(x / sqrt(1 - x * x));
+}
+
+constexpr double acos(double x) { return PI / 2 - asin(x); }
+
+constexpr double julianDay(int year, int month, int day) {
+  if (month <= 2) {
+    year -= 1;
+    month += 12;
+  }
+  int a = year / 100;
+  int b = 2 - a + a / 4;
+  return static_cast<int64_t>(365.25 * (year + 4716)) +
+         static_cast<int64_t>(30.6001 * (month + 1)) + day + b - 1524.5;
+}
+
+constexpr double zenith(SunEvent event) {
+  switch (event) {
+    case (SunEvent::CIVIL_TWILIGHT): {
+      return 96.0;
+    }
+    case (SunEvent::NAUTICAL_TWILIGHT): {
+      return 102.0;
+    }
+    default: {
+      // Refraction and radius of the sun disk
+      return 90.833;
+    }
+  }
+}
+
+struct SolarDay {
+  // Solar noon in minutes of the local day
+  double noonMin;
+  double declination;
+};
+
+constexpr SolarDay solarDay(const Site& site, int year, int month, int day) {
+  // Evaluated at local noon, which is accurate to well below a minute
+  double jd = julianDay(year, month, day) + 0.5 - site.utcOffsetMin / 1440.0;
+  double t = (jd - 2451545.0) / 36525.0;
+  double meanLong = wrap(280.46646 + t * (36000.76983 + t * 0.0003032), 360);
+  double meanAnom = 357.52911 + t * (35999.05029 - 0.0001537 * t);
+  double ecc = 0.016708634 - t * (0.000042037 + 0.0000001267 * t);
+  double center = sin(rad(meanAnom)) * (1.914602 - t * (0.004817 + 0.000014 * t)) +
+                  sin(rad(2 * meanAnom)) * (0.019993 - 0.000101 * t) +
+                  sin(rad(3 * meanAnom)) * 0.000289;
+  double omega = 125.04 - 1934.136 * t;
+  double appLong = meanLong + center - 0.00569 - 0.00478 * sin(rad(omega));
+  double meanObliq =
+      23 + (26 + (21.448 - t * (46.815 + t * (0.00059 - t * 0.001813))) / 60) / 60;
+  double obliq = meanObliq + 0.00256 * cos(rad(omega));
+  double declination = deg(asin(sin(rad(obliq)) * sin(rad(appLong))));
+  double y = tan(rad(obliq / 2)) * tan(rad(obliq / 2));
+  double eqOfTime =
+      4 * deg(y * sin(2 * rad(meanLong)) - 2 * ecc * sin(rad(meanAnom)) +
+              4 * ecc * y * sin(rad(meanAnom)) * cos(2 * rad(meanLong)) -
+              0.5 * y * y * sin(4 * rad(meanLong)) - 1.25 * ecc * ecc * sin(2 * rad(meanAnom)));
+  return SolarDay{720 - 4 * site.longitude - eqOfTime + site.utcOffsetMin, declination};
+}
+
+// Half of the time the sun is above the given zenith angle, in minutes
+constexpr double halfDayMin(const Site& site, const SolarDay& solar, SunEvent event) {
+  double cosHa = cos(rad(zenith(event))) / (cos(rad(site.latitude)) * cos(rad(solar.declination))) -
+                 tan(rad(site.latitude)) * tan(rad(solar.declination));
+  // The sun might not reach the zenith angle at high latitudes. Use midnight or noon then.
+  if (cosHa > 1) {
+    cosHa = 1;
+  } else if (cosHa < -1) {
+    cosHa = -1;
+  }
+  return 4 * deg(acos(cosHa));
+}
+
+constexpr uint16_t toDayMinutes(double minutes) {
+  if (minutes < 0) {
+    return 0;
+  }
+  if (minutes > 24 * 60 - 1) {
+    return 24 * 60 - 1;
+  }
+  return static_cast<uint16_t>(minutes + 0.5);
+}
+
+}  // namespace detail
+
+constexpr bool isLeapYear(int year) {
+  return (year % 4 == 0 and year % 100 != 0) or year % 400 == 0;
+}
+
+/**
+ * Calculates the opening and closing time for a given date
+ * @param month Month from 1 to 12
+ * @param day Day of the month from 1 to 31
+ */
+constexpr OcTimes sunOcTimes(const Site& site, int year, int month, int day) {
+  detail::SolarDay solar = detail::solarDay(site, year, month, day);
+  double open = solar.noonMin - detail::halfDayMin(site, solar, site.openEvent);
+  double close = solar.noonMin + detail::halfDayMin(site, solar, site.closeEvent);
+  return OcTimes{detail::toDayMinutes(open + site.openOffsetMin),
+                 detail::toDayMinutes(close + site.closeOffsetMin)};
+}
+
+/**
+ * Generates a full open-close table for the given site. For non-leap years, the entry for
+ * February 29 is interpolated like the table generator script does it.
+ */
+constexpr OcTable makeOcTable(const Site& site, int year) {
+  OcTable table{};
+  for (unsigned month = 0; month < 12; month++) {
+    unsigned end = month == 11 ? OC_TABLE_DAYS : OC_MONTH_OFFSETS[month + 1];
+    for (unsigned day = 0; day < end - OC_MONTH_OFFSETS[month]; day++) {
+      if (month == 1 and day == 28 and not isLeapYear(year)) {
+        continue;
+      }
+      table.days[ocTableIndex(month, day)] = sunOcTimes(site, year, month + 1, day + 1);
+    }
+  }
+  if (not isLeapYear(year)) {
+    const OcTimes& before = table.days[ocTableIndex(1, 27)];
+    const OcTimes& after = table.days[ocTableIndex(2, 0)];
+    table.days[ocTableIndex(1, 28)] =
+        OcTimes{static_cast<uint16_t>((before.open + after.open) / 2),
+                static_cast<uint16_t>((before.close + after.close) / 2)};
+  }
+  return table;
+}
+
+// Leap year, so February 29 is calculated as well
+static constexpr int TABLE_YEAR = 2024;
+
+#ifdef CONFIG_SCHEDULE_SOURCE_SOLAR
+
+#if CONFIG_SOLAR_OPEN_EVENT_CIVIL_DAWN == 1
+static constexpr SunEvent CONFIG_OPEN_EVENT = SunEvent::CIVIL_TWILIGHT;
+#elif CONFIG_SOLAR_OPEN_EVENT_NAUTICAL_DAWN == 1
+static constexpr SunEvent CONFIG_OPEN_EVENT = SunEvent::NAUTICAL_TWILIGHT;
+#else
+static constexpr SunEvent CONFIG_OPEN_EVENT = SunEvent::HORIZON;
+#endif
+
+#if CONFIG_SOLAR_CLOSE_EVENT_CIVIL_DUSK == 1
+static constexpr SunEvent CONFIG_CLOSE_EVENT = SunEvent::CIVIL_TWILIGHT;
+#elif CONFIG_SOLAR_CLOSE_EVENT_NAUTICAL_DUSK == 1
+static constexpr SunEvent CONFIG_CLOSE_EVENT = SunEvent::NAUTICAL_TWILIGHT;
+#else
+static constexpr SunEvent CONFIG_CLOSE_EVENT = SunEvent::HORIZON;
+#endif
+
+static constexpr Site CONFIG_SITE{CONFIG_SOLAR_LATITUDE / 1e6,  CONFIG_SOLAR_LONGITUDE / 1e6,
+                                  CONFIG_SOLAR_UTC_OFFSET,      CONFIG_OPEN_EVENT,
+                                  CONFIG_SOLAR_OPEN_OFFSET,     CONFIG_CLOSE_EVENT,
+                                  CONFIG_SOLAR_CLOSE_OFFSET};
+
+// Generated by the compiler and placed in .rodata like the precomputed table
+inline constexpr OcTable OC_TIMES_SOLAR = makeOcTable(CONFIG_SITE, TABLE_YEAR);
+
+#endif
+
+}  // namespace suntimes
+
+#endif /* MAIN_SUN_TIMES_H_ */
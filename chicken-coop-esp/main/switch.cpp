@@ -1,34 +1,260 @@
 #include "switch.h"
 
 #include <driver/gpio.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <array>
+#include <atomic>
 
 #include "esp_log.h"
 #include "sdkconfig.h"
 
 gpio_config_t SWITCH_CFG = {};
 static constexpr gpio_num_t SWITCH_GPIO = static_cast<gpio_num_t>(CONFIG_DOOR_SWITCH_STATE_PORT);
+#ifdef CONFIG_DOOR_TOP_LIMIT
+static constexpr gpio_num_t TOP_LIMIT_GPIO = static_cast<gpio_num_t>(CONFIG_DOOR_TOP_LIMIT_PORT);
+
+static_assert(TOP_LIMIT_GPIO != SWITCH_GPIO and TOP_LIMIT_GPIO != CONFIG_I2C_SDA_PORT and
+                  TOP_LIMIT_GPIO != CONFIG_I2C_SCL_PORT,
+              "Top limit switch shares a GPIO");
+#ifdef CONFIG_MOTOR_BACKEND_STEPPER
+static_assert(TOP_LIMIT_GPIO != CONFIG_STEPPER_IN1_PORT and
+                  TOP_LIMIT_GPIO != CONFIG_STEPPER_IN2_PORT and
+                  TOP_LIMIT_GPIO != CONFIG_STEPPER_IN3_PORT and
+                  TOP_LIMIT_GPIO != CONFIG_STEPPER_IN4_PORT,
+              "Top limit switch shares a GPIO with the stepper");
+#else
+static_assert(TOP_LIMIT_GPIO != CONFIG_MOTOR_PORT_0 and TOP_LIMIT_GPIO != CONFIG_MOTOR_PORT_1,
+              "Top limit switch shares a GPIO with the motor");
+#endif
+#ifdef CONFIG_MOTOR_ENCODER
+static_assert(TOP_LIMIT_GPIO != CONFIG_MOTOR_ENCODER_A_PORT and
+                  TOP_LIMIT_GPIO != CONFIG_MOTOR_ENCODER_B_PORT,
+              "Top limit switch shares a GPIO with the encoder");
+#endif
+#ifdef CONFIG_RTC_INT_SQW_PORT
+static_assert(TOP_LIMIT_GPIO != CONFIG_RTC_INT_SQW_PORT,
+              "Top limit switch shares a GPIO with the DS3231 INT/SQW output");
+#endif
+#endif
 
 static constexpr char SWITCH_TAG[] = "switch";
 
-bool switchState();
+// State bits of the debounced state
+static constexpr uint8_t BOTTOM_ACTIVE = 1 << 0;
+static constexpr uint8_t TOP_ACTIVE = 1 << 1;
+
+// Shorter times than one tick would round to 0 and disable the debouncing
+static constexpr TickType_t DEBOUNCE_TICKS =
+    pdMS_TO_TICKS(doorswitch::DEBOUNCE_MS) > 0 ? pdMS_TO_TICKS(doorswitch::DEBOUNCE_MS) : 1;
+
+static TaskHandle_t EVENT_TASK = nullptr;
+static TaskHandle_t SWITCH_TASK = nullptr;
+static doorswitch::EdgeCb EDGE_CB = nullptr;
+// Only written by the switch task, so the state functions only load it
+static std::atomic<uint8_t> STATE = 0;
+
+// Protects the edge history, the burst edge counter and the statistics
+static portMUX_TYPE LOCK = portMUX_INITIALIZER_UNLOCKED;
+static std::array<doorswitch::Edge, doorswitch::HISTORY_SIZE> HISTORY = {};
+// Runs freely and is only reduced modulo the history size on access
+static uint32_t HISTORY_HEAD = 0;
+// Edges since the last accepted state
+static uint32_t BURST_EDGES = 0;
+static doorswitch::Stats STATS = {};
+
+static void switchIsr(void* args);
+
+static bool bottomActive() {
+#if CONFIG_INVERT_DOOR_STATE_SWITCH == 1
+  return not gpio_get_level(SWITCH_GPIO);
+#else
+  // Level will be 0 if the door is opened.
+  return gpio_get_level(SWITCH_GPIO);
+#endif
+}
+
+static bool topActive() {
+#if defined(CONFIG_DOOR_TOP_LIMIT) && defined(CONFIG_DOOR_TOP_LIMIT_ACTIVE_HIGH)
+  return gpio_get_level(TOP_LIMIT_GPIO);
+#elif defined(CONFIG_DOOR_TOP_LIMIT)
+  return not gpio_get_level(TOP_LIMIT_GPIO);
+#else
+  return false;
+#endif
+}
+
+static uint8_t readInputs() {
+  uint8_t state = 0;
+  if (bottomActive()) {
+    state |= BOTTOM_ACTIVE;
+  }
+  if (topActive()) {
+    state |= TOP_ACTIVE;
+  }
+  return state;
+}
 
 int doorswitch::init() {
-  static_cast<void>(SWITCH_TAG);
   SWITCH_CFG.pin_bit_mask = 1 << CONFIG_DOOR_SWITCH_STATE_PORT;
   SWITCH_CFG.mode = GPIO_MODE_INPUT;
+  SWITCH_CFG.intr_type = GPIO_INTR_ANYEDGE;
   ESP_ERROR_CHECK(gpio_config(&SWITCH_CFG));
+#ifdef CONFIG_DOOR_TOP_LIMIT
+  gpio_config_t topCfg = {};
+  topCfg.pin_bit_mask = 1ULL << CONFIG_DOOR_TOP_LIMIT_PORT;
+  topCfg.mode = GPIO_MODE_INPUT;
+#ifndef CONFIG_DOOR_TOP_LIMIT_ACTIVE_HIGH
+  // The switch pulls the input low when the door is fully open
+  topCfg.pull_up_en = GPIO_PULLUP_ENABLE;
+#endif
+  topCfg.intr_type = GPIO_INTR_ANYEDGE;
+  ESP_ERROR_CHECK(gpio_config(&topCfg));
+#endif
+  // The switches do not bounce while the door is at rest
+  STATE.store(readInputs());
+  ESP_ERROR_CHECK(gpio_install_isr_service(0));
+  ESP_ERROR_CHECK(gpio_isr_handler_add(SWITCH_GPIO, switchIsr,
+                                       reinterpret_cast<void*>(Input::BOTTOM)));
+#ifdef CONFIG_DOOR_TOP_LIMIT
+  ESP_ERROR_CHECK(
+      gpio_isr_handler_add(TOP_LIMIT_GPIO, switchIsr, reinterpret_cast<void*>(Input::TOP)));
+#endif
+  ESP_LOGI(SWITCH_TAG, "Limit switches debounced with %lu ms",
+           static_cast<uint32_t>(pdTICKS_TO_MS(DEBOUNCE_TICKS)));
   return 0;
 }
 
-bool switchState() {
-#if CONFIG_INVERT_DOOR_STATE_SWITCH == 1
-  return gpio_get_level(SWITCH_GPIO);
-#else
-  // Level will be 0 if the door is opened.
-  return not gpio_get_level(SWITCH_GPIO);
-#endif
+void doorswitch::setEventTask(TaskHandle_t task) { EVENT_TASK = task; }
+
+void doorswitch::setEdgeCb(EdgeCb cb) { EDGE_CB = cb; }
+
+static void IRAM_ATTR switchIsr(void* args) {
+  doorswitch::Edge edge = {};
+  edge.timeUs = esp_timer_get_time();
+  edge.input = static_cast<doorswitch::Input>(reinterpret_cast<uintptr_t>(args));
+  edge.active = edge.input == doorswitch::Input::BOTTOM ? bottomActive() : topActive();
+  if (EDGE_CB != nullptr) {
+    EDGE_CB(edge);
+  }
+  portENTER_CRITICAL_ISR(&LOCK);
+  HISTORY[HISTORY_HEAD % HISTORY.size()] = edge;
+  HISTORY_HEAD++;
+  BURST_EDGES++;
+  portEXIT_CRITICAL_ISR(&LOCK);
+  if (SWITCH_TASK == nullptr) {
+    return;
+  }
+  BaseType_t higherPrioTaskWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(SWITCH_TASK, &higherPrioTaskWoken);
+  portYIELD_FROM_ISR(higherPrioTaskWoken);
+}
+
+// Accepts the current inputs after the edges of a burst stopped
+static void settle() {
+  // Later edges belong to the next burst
+  portENTER_CRITICAL(&LOCK);
+  uint8_t state = readInputs();
+  uint8_t changed = state ^ STATE.load(std::memory_order_relaxed);
+  // Each changed input needs one edge, all other edges were bounces
+  uint32_t changedInputs = ((changed & BOTTOM_ACTIVE) != 0) + ((changed & TOP_ACTIVE) != 0);
+  uint32_t edges = BURST_EDGES;
+  BURST_EDGES = 0;
+  if (edges > STATS.maxBurstEdges) {
+    STATS.maxBurstEdges = edges;
+  }
+  if (changed != 0) {
+    STATS.changes++;
+  } else if (edges > 0) {
+    STATS.glitches++;
+  }
+  if (edges > changedInputs) {
+    STATS.bounces += edges - changedInputs;
+  }
+  portEXIT_CRITICAL(&LOCK);
+  if (changed == 0) {
+    return;
+  }
+  STATE.store(state, std::memory_order_relaxed);
+  ESP_LOGD(SWITCH_TAG, "Switch state 0x%02x accepted after %lu edges", state, edges);
+  if (EVENT_TASK != nullptr) {
+    xTaskNotifyGive(EVENT_TASK);
+  }
+}
+
+void doorswitch::task(void* args) {
+  SWITCH_TASK = xTaskGetCurrentTaskHandle();
+  // Edges before the task started
+  settle();
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // Every further edge restarts the debounce time
+    while (ulTaskNotifyTake(pdTRUE, DEBOUNCE_TICKS) > 0) {
+    }
+    settle();
+  }
 }
 
-bool doorswitch::opened() { return switchState(); }
+bool doorswitch::opened() { return not closed(); }
 
-bool doorswitch::closed() { return not switchState(); }
+bool doorswitch::closed() { return STATE.load(std::memory_order_relaxed) & BOTTOM_ACTIVE; }
+
+bool doorswitch::topLimit() { return STATE.load(std::memory_order_relaxed) & TOP_ACTIVE; }
+
+bool doorswitch::fullyOpen() {
+  if (HAS_TOP_LIMIT) {
+    return topLimit();
+  }
+  return opened();
+}
+
+doorswitch::Position doorswitch::position() {
+  if (closed()) {
+    return Position::CLOSED;
+  }
+  if (fullyOpen()) {
+    return Position::OPEN;
+  }
+  return Position::IN_TRANSIT;
+}
+
+const char* doorswitch::positionName(Position position) {
+  switch (position) {
+    case (Position::CLOSED): {
+      return "closed";
+    }
+    case (Position::OPEN): {
+      return "open";
+    }
+    default: {
+      return "in transit";
+    }
+  }
+}
+
+const char* doorswitch::inputName(Input input) {
+  return input == Input::BOTTOM ? "bottom" : "top";
+}
+
+doorswitch::Stats doorswitch::stats() {
+  portENTER_CRITICAL(&LOCK);
+  Stats result = STATS;
+  portEXIT_CRITICAL(&LOCK);
+  return result;
+}
+
+size_t doorswitch::history(Edge* edges, size_t maxEdges) {
+  portENTER_CRITICAL(&LOCK);
+  size_t count = HISTORY_HEAD < HISTORY.size() ? HISTORY_HEAD : HISTORY.size();
+  if (count > maxEdges) {
+    count = maxEdges;
+  }
+  for (size_t idx = 0; idx < count; idx++) {
+    edges[idx] = HISTORY[(HISTORY_HEAD - count + idx) % HISTORY.size()];
+  }
+  portEXIT_CRITICAL(&LOCK);
+  return count;
+}
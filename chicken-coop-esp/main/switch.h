@@ -1,12 +1,94 @@
 #ifndef MAIN_SWITCH_H_
 #define MAIN_SWITCH_H_
 
+#include <freertos/FreeRTOS.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sdkconfig.h"
+
+/**
+ * Door position from the limit switches. The bottom switch, the door switch, reports a closed
+ * door. The optional top switch reports a fully opened door. Without it, the door is assumed
+ * to be fully open when it is not closed.
+ *
+ * The inputs are only read in the GPIO interrupt and by the switch task. Every edge is stored
+ * with its time stamp, and the switch task accepts a new state once the inputs were quiet for
+ * CONFIG_DOOR_SWITCH_DEBOUNCE_TIME. The state functions return this debounced state, so they
+ * are cheap and a bouncing reed switch does not flip the door state.
+ */
 namespace doorswitch {
 
+#ifdef CONFIG_DOOR_TOP_LIMIT
+static constexpr bool HAS_TOP_LIMIT = true;
+#else
+static constexpr bool HAS_TOP_LIMIT = false;
+#endif
+
+static constexpr uint32_t DEBOUNCE_MS = CONFIG_DOOR_SWITCH_DEBOUNCE_TIME;
+// Number of edges kept for diagnostics
+static constexpr size_t HISTORY_SIZE = 16;
+
+enum class Position : uint8_t { CLOSED, OPEN, IN_TRANSIT };
+
+enum class Input : uint8_t { BOTTOM, TOP };
+
+struct Edge {
+  // Time of the ISR entry from esp_timer_get_time
+  int64_t timeUs;
+  Input input;
+  // The switch reports the end position of the input after the edge, not debounced
+  bool active;
+};
+
+struct Stats {
+  // Accepted changes of the debounced state
+  uint32_t changes;
+  // Edges which did not lead to an accepted change
+  uint32_t bounces;
+  // Edge bursts after which the state was the same as before
+  uint32_t glitches;
+  // Most edges of one burst until the inputs were quiet
+  uint32_t maxBurstEdges;
+};
+
+using EdgeCb = void (*)(const Edge& edge);
+
 int init();
 
+/**
+ * Debounces the inputs after the edges reported by the ISR. Runs with a high priority, because
+ * the motor task waits for the debounced end positions.
+ */
+void task(void* args);
+
+/**
+ * Task which is notified with xTaskNotifyGive on every debounced change of a limit switch. Can
+ * be used to wait for door state changes without polling the switches.
+ */
+void setEventTask(TaskHandle_t task);
+
+/**
+ * Called in the switch ISR on every raw edge, before debouncing. Must be ISR safe.
+ */
+void setEdgeCb(EdgeCb cb);
+
+// Not closed
 bool opened();
 bool closed();
+// The top limit switch reports an open door. Always false without a top limit switch.
+bool topLimit();
+bool fullyOpen();
+Position position();
+const char* positionName(Position position);
+const char* inputName(Input input);
+
+Stats stats();
+/**
+ * Copies the last edges, oldest first. Returns the number of copied edges.
+ */
+size_t history(Edge* edges, size_t maxEdges);
 
 }  // namespace doorswitch
 
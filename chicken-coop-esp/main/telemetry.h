@@ -0,0 +1,55 @@
+#ifndef MAIN_TELEMETRY_H_
+#define MAIN_TELEMETRY_H_
+
+#include <cstdint>
+
+/**
+ * Telemetry which is pushed to a subscribed host. Each sample is sent as the payload of a
+ * binary TELEMETRY frame, see binary_frame.h. The sequence number of the frame is incremented
+ * for every sample, so the host can detect dropped samples.
+ *
+ * A sample is sent when the state changes and periodically with the subscribed period. Samples
+ * are never sent more often than MIN_PERIOD_MS and are dropped instead of blocking the
+ * controller if the UART TX buffer is full.
+ */
+namespace telemetry {
+
+static constexpr uint32_t MIN_PERIOD_MS = 100;
+// Unused minute of the day
+static constexpr int16_t NO_MINUTE = -1;
+
+static constexpr uint8_t FLAG_FORCED_OP = 1 << 0;
+static constexpr uint8_t FLAG_BINARY_MODE = 1 << 1;
+
+// Little endian and packed, the layout must only be extended at the end
+struct __attribute__((packed)) Sample {
+  uint32_t uptimeMs;
+  uint8_t appState;
+  uint8_t motorState;
+  // 1 if the door switch reports an opened door
+  uint8_t doorSwitch;
+  uint8_t recheckMode;
+  // Time since the motor was started, 0 if the motor is idle
+  uint32_t motorRuntimeMs;
+  // Minute of the day of the next scheduled opening and closing
+  int16_t nextOpenMinute;
+  int16_t nextCloseMinute;
+  uint8_t flags;
+};
+
+static_assert(sizeof(Sample) == 17, "Telemetry layout changed");
+
+/**
+ * Returns true if the state fields differ. The time fields change continuously and are not
+ * compared.
+ */
+constexpr bool stateChanged(const Sample& a, const Sample& b) {
+  return a.appState != b.appState or a.motorState != b.motorState or
+         a.doorSwitch != b.doorSwitch or a.recheckMode != b.recheckMode or
+         a.nextOpenMinute != b.nextOpenMinute or a.nextCloseMinute != b.nextCloseMinute or
+         a.flags != b.flags;
+}
+
+}  // namespace telemetry
+
+#endif /* MAIN_TELEMETRY_H_ */
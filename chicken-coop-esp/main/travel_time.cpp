@@ -0,0 +1,110 @@
+#include "travel_time.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <array>
+
+#include "dlog.h"
+#include "storage.h"
+
+static constexpr char TRAVEL_TAG[] = "travel";
+
+static traveltime::Calibration CALIBRATION = {};
+static uint32_t TRAVEL_MS = traveltime::DEFAULT_TRAVEL_MS;
+
+static void updateEstimate() {
+  if (CALIBRATION.count == 0) {
+    TRAVEL_MS = traveltime::DEFAULT_TRAVEL_MS;
+    return;
+  }
+  std::array<uint32_t, traveltime::NUM_SAMPLES> sorted;
+  std::copy_n(CALIBRATION.samplesMs, CALIBRATION.count, sorted.begin());
+  std::sort(sorted.begin(), sorted.begin() + CALIBRATION.count);
+  // Lower median for an even count, so a single timeout sample is replaced by the first
+  // measurement
+  TRAVEL_MS = sorted[(CALIBRATION.count - 1) / 2];
+}
+
+static void store() {
+  esp_err_t result = storage::storeBlob(traveltime::NVS_KEY, traveltime::VERSION, &CALIBRATION,
+                                        sizeof(CALIBRATION));
+  if (result != ESP_OK) {
+    ESP_LOGW(TRAVEL_TAG, "Storing the travel time calibration failed with %s",
+             esp_err_to_name(result));
+  }
+}
+
+void traveltime::init() {
+  esp_err_t result = storage::loadBlob(NVS_KEY, VERSION, &CALIBRATION, sizeof(CALIBRATION));
+  if (result != ESP_OK or CALIBRATION.count > NUM_SAMPLES or CALIBRATION.next >= NUM_SAMPLES) {
+    if (result != ESP_ERR_NVS_NOT_FOUND) {
+      ESP_LOGW(TRAVEL_TAG, "Loading the travel time calibration failed with %s",
+               esp_err_to_name(result));
+    }
+    CALIBRATION = {};
+  }
+  updateEstimate();
+  ESP_LOGI(TRAVEL_TAG, "Travel time %lu ms from %u samples, open duration %lu ms", TRAVEL_MS,
+           CALIBRATION.count, openDurationMs());
+}
+
+uint32_t traveltime::travelMs() { return TRAVEL_MS; }
+
+bool traveltime::calibrated() { return CALIBRATION.count > 0; }
+
+uint32_t traveltime::openDurationMs() {
+  if (not calibrated()) {
+    return config::OPEN_DURATION_MS;
+  }
+  return openDurationFor(TRAVEL_MS);
+}
+
+uint32_t traveltime::closeTimeoutMs() {
+  if (not calibrated()) {
+    return config::MAX_CLOSE_DURATION;
+  }
+  return closeTimeoutFor(TRAVEL_MS);
+}
+
+const traveltime::Calibration& traveltime::calibration() { return CALIBRATION; }
+
+bool traveltime::sampleOpen() {
+  if (CALIBRATION.count < NUM_SAMPLES) {
+    return true;
+  }
+  CALIBRATION.opensSinceSample++;
+  bool due = CALIBRATION.opensSinceSample >= SAMPLE_INTERVAL;
+  if (due) {
+    CALIBRATION.opensSinceSample = 0;
+  }
+  store();
+  return due;
+}
+
+bool traveltime::addSample(uint32_t closeMs) {
+  if (closeMs < MIN_SAMPLE_MS or closeMs >= config::MAX_CLOSE_DURATION) {
+    return false;
+  }
+  CALIBRATION.samplesMs[CALIBRATION.next] = closeMs;
+  CALIBRATION.next = (CALIBRATION.next + 1) % NUM_SAMPLES;
+  if (CALIBRATION.count < NUM_SAMPLES) {
+    CALIBRATION.count++;
+  }
+  updateEstimate();
+  store();
+  dlog::log(dlog::Msg::TRAVEL_SAMPLE, closeMs, TRAVEL_MS);
+  return true;
+}
+
+void traveltime::closeTimedOut(uint32_t closeMs) {
+  uint16_t timeouts = CALIBRATION.timeouts;
+  CALIBRATION = {};
+  CALIBRATION.samplesMs[0] = std::min(closeMs, config::MAX_CLOSE_DURATION);
+  CALIBRATION.count = 1;
+  CALIBRATION.next = 1;
+  CALIBRATION.timeouts = timeouts + 1;
+  updateEstimate();
+  store();
+  dlog::log(dlog::Msg::TRAVEL_TIMEOUT, closeMs, TRAVEL_MS);
+}
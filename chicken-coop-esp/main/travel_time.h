@@ -0,0 +1,102 @@
+#ifndef MAIN_TRAVEL_TIME_H_
+#define MAIN_TRAVEL_TIME_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "conf.h"
+#include "esp_err.h"
+
+/**
+ * Learned door travel time. Only the closing can be measured: the time from the motor start
+ * until the door switch reports a closed door, for every close which started from a fully
+ * opened door. The door only counts as fully opened if the open ended at a physical end, so the
+ * measurement does not depend on the learned open duration itself. An open for the learned
+ * duration usually ends short of that, so some opens still run for the fixed open duration:
+ * every open until NUM_SAMPLES closes were measured and every SAMPLE_INTERVAL-th open after
+ * that. The median of the last measurements is stored in the NVS. The open duration and the
+ * close timeout are derived from it with a safety margin and are limited by the fixed durations
+ * in conf.h, which are used until the first measurement.
+ */
+namespace traveltime {
+
+static constexpr char NVS_KEY[] = "travel";
+static constexpr uint16_t VERSION = 2;
+static constexpr size_t NUM_SAMPLES = 7;
+// A calibrated door is measured again on every seventh open, about once a week
+static constexpr uint8_t SAMPLE_INTERVAL = 7;
+// Shorter closes can not have started from a fully opened door
+static constexpr uint32_t MIN_SAMPLE_MS = 2000;
+// Speed profile estimate until the first close was measured
+static constexpr uint32_t DEFAULT_TRAVEL_MS = CONFIG_DEFAULT_FULL_OPEN_CLOSE_DURATION * 1000;
+static constexpr uint32_t MARGIN_PERCENT = CONFIG_TRAVEL_TIME_MARGIN;
+static constexpr uint32_t MIN_MARGIN_MS = CONFIG_TRAVEL_TIME_MIN_MARGIN * 1000;
+// A close may take this much longer than an open before it is aborted
+static constexpr uint32_t CLOSE_TIMEOUT_EXTRA_MS =
+    config::MAX_CLOSE_DURATION - config::OPEN_DURATION_MS;
+
+struct Calibration {
+  // Ring buffer of the last measured close durations
+  uint32_t samplesMs[NUM_SAMPLES];
+  uint8_t count;
+  uint8_t next;
+  // Opens for the learned duration since the last open for the fixed duration
+  uint8_t opensSinceSample;
+  // Number of closes which were aborted by the close timeout
+  uint16_t timeouts;
+};
+
+constexpr uint32_t openDurationFor(uint32_t travelMs) {
+  uint32_t margin = travelMs * MARGIN_PERCENT / 100;
+  if (margin < MIN_MARGIN_MS) {
+    margin = MIN_MARGIN_MS;
+  }
+  uint32_t duration = travelMs + margin;
+  return duration < config::OPEN_DURATION_MS ? duration : config::OPEN_DURATION_MS;
+}
+
+constexpr uint32_t closeTimeoutFor(uint32_t travelMs) {
+  return openDurationFor(travelMs) + CLOSE_TIMEOUT_EXTRA_MS;
+}
+
+static_assert(closeTimeoutFor(config::MAX_CLOSE_DURATION) == config::MAX_CLOSE_DURATION);
+
+/**
+ * Loads the calibration from the NVS. Without one, the fixed open duration and close timeout are
+ * used.
+ */
+void init();
+
+/**
+ * Estimated travel time, the median of the measured close durations.
+ */
+uint32_t travelMs();
+bool calibrated();
+uint32_t openDurationMs();
+uint32_t closeTimeoutMs();
+const Calibration& calibration();
+
+/**
+ * Called once at the start of every scheduled open. Returns true if the open should run for the
+ * fixed open duration, so the following close can be measured.
+ */
+bool sampleOpen();
+
+/**
+ * Adds the measured duration of a close from a fully opened door. Returns false if the
+ * sample was rejected.
+ */
+bool addSample(uint32_t closeMs);
+
+/**
+ * The door was not closed before the close timeout. This is reported for every close which
+ * stops at the door switch, not only for the ones from a fully opened door, because a close from
+ * any position must end within the timeout. The calibration is restarted with the timeout as
+ * the only sample, so the limits grow until the door closes in time or the fixed limits are
+ * reached.
+ */
+void closeTimedOut(uint32_t closeMs);
+
+}  // namespace traveltime
+
+#endif /* MAIN_TRAVEL_TIME_H_ */
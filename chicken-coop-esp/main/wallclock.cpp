@@ -0,0 +1,155 @@
+#include "wallclock.h"
+
+#include <driver/gpio.h>
+#include <ds3231.h>
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <atomic>
+#include <cstdlib>
+
+#include "sdkconfig.h"
+
+static constexpr char CLOCK_TAG[] = "clock";
+
+static constexpr int64_t US_PER_SECOND = 1000 * 1000;
+static constexpr time_t RESYNC_INTERVAL_S = CONFIG_WALLCLOCK_RESYNC_INTERVAL;
+
+static i2c_dev_t* RTC = nullptr;
+static wallclock::Stats STATS = {};
+
+// Time of the last RTC read, in software clock time
+static time_t LAST_SYNC_EPOCH = 0;
+static time_t CACHED_EPOCH = -1;
+static tm CACHED_TIME = {};
+
+#if CONFIG_WALLCLOCK_SOURCE_SQW
+static constexpr gpio_num_t SQW_GPIO = static_cast<gpio_num_t>(CONFIG_RTC_INT_SQW_PORT);
+// Incremented on every falling edge of the 1 Hz SQW output, which coincides with the seconds
+// update of the DS3231.
+static std::atomic<uint32_t> SQW_EPOCH = 0;
+
+static void IRAM_ATTR sqwIsr(void* args) { SQW_EPOCH.fetch_add(1, std::memory_order_relaxed); }
+
+static void setSoftwareEpoch(time_t epoch) {
+  SQW_EPOCH.store(static_cast<uint32_t>(epoch), std::memory_order_relaxed);
+}
+
+static esp_err_t initTimebase() {
+  ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_set_squarewave_freq(RTC, DS3231_SQWAVE_1HZ));
+  ESP_ERROR_CHECK_WITHOUT_ABORT(ds3231_enable_squarewave(RTC));
+  gpio_config_t cfg = {};
+  cfg.pin_bit_mask = 1ULL << SQW_GPIO;
+  cfg.mode = GPIO_MODE_INPUT;
+  cfg.pull_up_en = GPIO_PULLUP_ENABLE;
+  cfg.intr_type = GPIO_INTR_NEGEDGE;
+  esp_err_t result = gpio_config(&cfg);
+  if (result != ESP_OK) {
+    return result;
+  }
+  // The ISR service might already be installed by another module
+  result = gpio_install_isr_service(0);
+  if (result != ESP_OK and result != ESP_ERR_INVALID_STATE) {
+    return result;
+  }
+  return gpio_isr_handler_add(SQW_GPIO, sqwIsr, nullptr);
+}
+#else
+static time_t BASE_EPOCH = 0;
+static int64_t BASE_TIME_US = 0;
+
+static void setSoftwareEpoch(time_t epoch) {
+  BASE_EPOCH = epoch;
+  BASE_TIME_US = esp_timer_get_time();
+}
+
+static esp_err_t initTimebase() { return ESP_OK; }
+#endif
+
+esp_err_t wallclock::init(i2c_dev_t* rtc) {
+  RTC = rtc;
+  esp_err_t result = initTimebase();
+  if (result != ESP_OK) {
+    ESP_LOGE(CLOCK_TAG, "Timebase initialization failed with %s", esp_err_to_name(result));
+  }
+  result = resync();
+  // The first read is not a drift measurement
+  STATS = {};
+  return result;
+}
+
+time_t wallclock::now() {
+#if CONFIG_WALLCLOCK_SOURCE_SQW
+  return SQW_EPOCH.load(std::memory_order_relaxed);
+#else
+  return BASE_EPOCH + (esp_timer_get_time() - BASE_TIME_US) / US_PER_SECOND;
+#endif
+}
+
+void wallclock::getTime(tm& time) {
+  time_t epoch = now();
+  if (epoch != CACHED_EPOCH) {
+    gmtime_r(&epoch, &CACHED_TIME);
+    CACHED_EPOCH = epoch;
+  }
+  time = CACHED_TIME;
+}
+
+esp_err_t wallclock::setTime(tm& time) {
+  esp_err_t result = ds3231_set_time(RTC, &time);
+  if (result != ESP_OK) {
+    return result;
+  }
+  LAST_SYNC_EPOCH = toEpoch(time);
+  setSoftwareEpoch(LAST_SYNC_EPOCH);
+  CACHED_EPOCH = -1;
+  return ESP_OK;
+}
+
+esp_err_t wallclock::resyncIfDue() {
+  if (now() - LAST_SYNC_EPOCH < RESYNC_INTERVAL_S) {
+    STATS.i2cReadsAvoided++;
+    return ESP_OK;
+  }
+  return resync();
+}
+
+esp_err_t wallclock::resync() {
+  tm rtcTime = {};
+  esp_err_t result = ds3231_get_time(RTC, &rtcTime);
+  if (result != ESP_OK) {
+    // Keep the software clock running and try again on the next interval
+    LAST_SYNC_EPOCH = now();
+    return result;
+  }
+  time_t rtcEpoch = toEpoch(rtcTime);
+  int32_t drift = static_cast<int32_t>(rtcEpoch - now());
+  STATS.resyncs++;
+  STATS.lastDriftSeconds = drift;
+  if (std::abs(drift) > STATS.maxAbsDriftSeconds) {
+    STATS.maxAbsDriftSeconds = std::abs(drift);
+  }
+  if (drift != 0) {
+    ESP_LOGI(CLOCK_TAG, "Resynchronized with RTC, drift %ld seconds", drift);
+  }
+  setSoftwareEpoch(rtcEpoch);
+  LAST_SYNC_EPOCH = rtcEpoch;
+  CACHED_EPOCH = -1;
+  return ESP_OK;
+}
+
+wallclock::Stats wallclock::getStats() { return STATS; }
+
+time_t wallclock::toEpoch(const tm& time) {
+  // Days from civil algorithm, see: https://howardhinnant.github.io/date_algorithms.html
+  int year = time.tm_year + 1900;
+  unsigned month = time.tm_mon + 1;
+  year -= month <= 2;
+  int era = (year >= 0 ? year : year - 399) / 400;
+  unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+  unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + time.tm_mday - 1;
+  unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  int64_t days = static_cast<int64_t>(era) * 146097 + static_cast<int64_t>(dayOfEra) - 719468;
+  return static_cast<time_t>(days * 86400 + time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec);
+}
@@ -0,0 +1,48 @@
+#ifndef MAIN_WALLCLOCK_H_
+#define MAIN_WALLCLOCK_H_
+
+#include <cstdint>
+#include <ctime>
+
+#include "esp_err.h"
+#include "i2cdev.h"
+
+/**
+ * Software wall clock which is disciplined by the DS3231 RTC. The RTC is only read once at
+ * startup and on every resync interval. In between, the time is kept by the 1 Hz SQW output
+ * of the DS3231 or by the esp_timer, depending on the configuration.
+ *
+ * All functions except the SQW interrupt handler must be called from the same task.
+ */
+namespace wallclock {
+
+struct Stats {
+  // Controller cycles which did not read the RTC. Every cycle used to read it over I2C.
+  uint32_t i2cReadsAvoided = 0;
+  uint32_t resyncs = 0;
+  // Difference between the RTC time and the software clock at the last resync, in seconds.
+  // A positive value means that the software clock was behind the RTC.
+  int32_t lastDriftSeconds = 0;
+  int32_t maxAbsDriftSeconds = 0;
+};
+
+esp_err_t init(i2c_dev_t* rtc);
+
+// Returns the current time as seconds since the epoch. The RTC time is interpreted as UTC.
+time_t now();
+void getTime(tm& time);
+
+// Sets the time in the RTC and the software clock.
+esp_err_t setTime(tm& time);
+
+// Re-reads the RTC if the resync interval has passed. Called once per controller cycle.
+esp_err_t resyncIfDue();
+esp_err_t resync();
+
+Stats getStats();
+
+time_t toEpoch(const tm& time);
+
+}  // namespace wallclock
+
+#endif /* MAIN_WALLCLOCK_H_ */
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""Measures the command throughput and latency of the ASCII and the binary protocol.
+
+The benchmark either talks to a real device or, with --loopback, to a device
+emulator on a pseudo terminal. The emulator answers pings like the firmware and
+delays the requests and replies by their transfer time at the configured baud
+rate, so the protocol overhead can be compared without hardware.
+"""
+import argparse
+import os
+import statistics
+import threading
+import time
+import tty
+from collections import deque
+
+import serial
+
+from mod import binproto
+
+PING_CMD = ""
+
+
+def emulate_device(fd: int, baud: int):
+    """Answers ASCII pings, the handshake and binary REQUEST frames"""
+    binary = False
+    ascii_buf = b""
+    decoder = binproto.Decoder()
+
+    def transfer_delay(data: bytes):
+        # 10 bits per byte with one start and one stop bit
+        if baud > 0:
+            time.sleep(len(data) * 10 / baud)
+
+    def write(data: bytes):
+        transfer_delay(data)
+        os.write(fd, data)
+
+    while True:
+        try:
+            data = os.read(fd, 1024)
+        except OSError:
+            return
+        transfer_delay(data)
+        if not binary:
+            ascii_buf += data
+            while b"\n" in ascii_buf:
+                line, ascii_buf = ascii_buf.split(b"\n", 1)
+                if line == b"CC":
+                    write(b"CC\n")
+                elif line == b"CCB1":
+                    write(b"CCB1,320\n")
+                    binary = True
+                    # Remaining bytes already belong to binary frames
+                    data = ascii_buf
+                    ascii_buf = b""
+                    break
+            if not binary:
+                continue
+        for frame in decoder.feed(data):
+            if frame.type == binproto.FrameType.EXIT:
+                write(binproto.encode_frame(binproto.FrameType.RESPONSE, frame.seq))
+                binary = False
+                continue
+            cmds = binproto.decode_commands(frame.payload)
+            if frame.type != binproto.FrameType.REQUEST or not cmds:
+                reason = bytes([binproto.NakReason.INVALID_BATCH])
+                write(binproto.encode_frame(binproto.FrameType.NAK, frame.seq, reason))
+                continue
+            payload = b""
+            for cmd in cmds:
+                result = binproto.Result.OK
+                if cmd != b"":
+                    result = binproto.Result.INVALID_CMD
+                payload += bytes([result, 0])
+            response = binproto.FrameType.RESPONSE
+            write(binproto.encode_frame(response, frame.seq, payload))
+
+
+def bench_ascii(ser: serial.Serial, count: int):
+    latencies = []
+    start = time.perf_counter()
+    for _ in range(count):
+        sent = time.perf_counter()
+        ser.write(b"CC\n")
+        reply = ser.readline()
+        if reply != b"CC\n":
+            raise RuntimeError(f"Unexpected ping reply {reply}")
+        latencies.append(time.perf_counter() - sent)
+    return count / (time.perf_counter() - start), latencies
+
+
+def bench_binary(ser: serial.Serial, frames: int, batch: int, window: int):
+    ser.write(binproto.handshake_cmd())
+    reply = ser.readline()
+    if not reply.startswith(b"CCB1"):
+        raise RuntimeError(f"Binary mode not supported, handshake reply {reply}")
+    decoder = binproto.Decoder()
+    pending = deque()
+    latencies = []
+    errors = 0
+    sent_frames = 0
+    start = time.perf_counter()
+    while len(latencies) + errors < frames:
+        # Keep up to window requests outstanding
+        while sent_frames < frames and len(pending) < window:
+            seq = sent_frames & 0xFF
+            ser.write(binproto.encode_request(seq, [PING_CMD] * batch))
+            pending.append((seq, time.perf_counter()))
+            sent_frames += 1
+        data = ser.read(max(1, ser.in_waiting))
+        if not data:
+            raise RuntimeError(f"Timeout with {len(pending)} outstanding frames")
+        for frame in decoder.feed(data):
+            seq, sent = pending.popleft()
+            if frame.seq != seq or frame.type != binproto.FrameType.RESPONSE:
+                errors += 1
+                continue
+            records = binproto.decode_records(frame.payload)
+            failed = any(r != binproto.Result.OK for r, _ in records)
+            if len(records) != batch or failed:
+                errors += 1
+                continue
+            latencies.append(time.perf_counter() - sent)
+    elapsed = time.perf_counter() - start
+    ser.write(binproto.encode_frame(binproto.FrameType.EXIT, 0))
+    decoder.feed(ser.read(binproto.HEADER_SIZE + binproto.CRC_SIZE))
+    return len(latencies) * batch / elapsed, latencies, errors
+
+
+def print_latencies(name: str, rate: float, latencies):
+    ms = sorted(lat * 1000 for lat in latencies)
+    print(
+        f"{name}: {rate:.1f} commands/s, latency mean {statistics.mean(ms):.2f} ms, "
+        f"p50 {ms[len(ms) // 2]:.2f} ms, p99 {ms[int(len(ms) * 0.99) - 1]:.2f} ms"
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("-p", "--port", help="Serial port of the device")
+    parser.add_argument(
+        "-l", "--loopback", action="store_true", help="Use the device emulator on a pty"
+    )
+    parser.add_argument("-b", "--baud", type=int, default=115200)
+    parser.add_argument("-n", "--frames", type=int, default=200)
+    parser.add_argument(
+        "--batch", type=int, default=8, help="Commands per binary frame"
+    )
+    parser.add_argument(
+        "--window", type=int, default=4, help="Outstanding binary frames"
+    )
+    args = parser.parse_args()
+    if args.loopback:
+        master, slave = os.openpty()
+        tty.setraw(master)
+        tty.setraw(slave)
+        threading.Thread(
+            target=emulate_device, args=(master, args.baud), daemon=True
+        ).start()
+        port = os.ttyname(slave)
+    elif args.port:
+        port = args.port
+    else:
+        parser.error("Either a port or the loopback mode is required")
+    ser = serial.Serial(port, baudrate=args.baud, timeout=2)
+    rate, latencies = bench_ascii(ser, args.frames)
+    print_latencies("ASCII", rate, latencies)
+    rate, latencies, errors = bench_binary(ser, args.frames, args.batch, args.window)
+    name = f"Binary (batch {args.batch}, window {args.window})"
+    print_latencies(name, rate, latencies)
+    if errors > 0:
+        print(f"{errors} binary frames failed")
+
+
+if __name__ == "__main__":
+    main()
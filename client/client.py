@@ -3,6 +3,7 @@ import os
 import pytz
 import threading
 import time
+import zlib
 from typing import List
 
 import serial
@@ -37,6 +38,10 @@ def main():
 def reply_handler(ser: serial.Serial):
     while True:
         reply = ser.readline()
+        if len(reply) > 4 and reply[:3] == (CMD_PATTERN + CommandChars.SCHEDULE).encode():
+            # Handled by the upload procedure
+            handle_schedule_reply(reply)
+            continue
         print()
         if reply[0] != ord("C") or reply[1] != ord("C"):
             print('Invalid reply format, must start with "CC"')
@@ -51,6 +56,53 @@ def reply_handler(ser: serial.Serial):
                 if reply[3] == ord(RequestChars.TIME):
                     time_str = reply[4:].rstrip("\n".encode()).decode()
                     print(f"Received current time on the ESP32: {time_str}")
+                elif reply[3] == ord(RequestChars.CLOCK):
+                    stats = reply[4:].rstrip("\n".encode()).decode().split(",")
+                    print(
+                        f"Clock: {stats[0]} I2C reads avoided, {stats[1]} resyncs, "
+                        f"last drift {stats[2]} s, max drift {stats[3]} s"
+                    )
+                elif reply[3] == ord(RequestChars.WAKEUPS):
+                    stats = reply[4:].rstrip("\n".encode()).decode().split(",")
+                    print(
+                        f"Controller wakeups: {stats[0]} last hour, "
+                        f"{stats[1]} current hour, {stats[2]} total"
+                    )
+                elif reply[3] == ord(RequestChars.COMMANDS):
+                    stats = reply[4:].rstrip("\n".encode()).decode().split(",")
+                    print(
+                        f"Command parser: {stats[0]} frames, {stats[1]} overflows, "
+                        f"{stats[2]} skipped bytes"
+                    )
+                    print(
+                        f"CPU cycles per command: {stats[3]} last, {stats[4]} average, "
+                        f"{stats[5]} max"
+                    )
+                    print(
+                        f"Command latency: {stats[6]} us last, {stats[7]} us max, "
+                        f"queue high water {stats[8]}, {stats[9]} dropped"
+                    )
+                elif reply[3] == ord(RequestChars.TRAVEL):
+                    info = reply[4:].rstrip("\n".encode()).decode().split(",")
+                    print(
+                        f"Door travel time: {info[0]} ms from {info[3]} samples, "
+                        f"{info[4]} timeouts"
+                    )
+                    print(f"Open duration {info[1]} ms, close timeout {info[2]} ms")
+                elif reply[3] == ord(RequestChars.SWITCH):
+                    stats = reply[4:].rstrip("\n".encode()).decode().split(",")
+                    positions = ["closed", "open", "in transit"]
+                    print(
+                        f"Limit switches: {stats[0]} changes, {stats[1]} bounces, "
+                        f"{stats[2]} glitches, max {stats[3]} edges per burst"
+                    )
+                    print(f"Door position: {positions[int(stats[4])]}")
+                elif reply[3] == ord(RequestChars.SCHEDULE):
+                    info = reply[4:].rstrip("\n".encode()).decode().split(",")
+                    if info[0] == "1":
+                        print(f"Using uploaded schedule with sequence number {info[1]}")
+                    else:
+                        print("Using compiled-in schedule")
             else:
                 print(f"Received {reply} with no implemented reply handling")
         print(PrintString.REQUEST_STR[0], end="")
@@ -74,10 +126,17 @@ class CommandChars:
     DATA = "D"
     TIME = "T"
     REQUEST = "R"
+    SCHEDULE = "S"
 
 
 class RequestChars:
     TIME = "T"
+    WAKEUPS = "W"
+    CLOCK = "K"
+    SCHEDULE = "S"
+    COMMANDS = "P"
+    TRAVEL = "D"
+    SWITCH = "L"
 
 
 CMD_MODE_MANUAL = "M"
@@ -90,6 +149,24 @@ CMD_MOTOR_CTRL_OPEN = "O"
 CMD_MOTOR_CTRL_CLOSE = "C"
 CMD_MOTOR_CTRL_STOP = "S"
 
+CMD_SCHEDULE_BEGIN = "B"
+CMD_SCHEDULE_DATA = "D"
+CMD_SCHEDULE_END = "E"
+SCHEDULE_CHUNK_SIZE = 128
+SCHEDULE_REPLY_TIMEOUT = 2.0
+SCHEDULE_RETRIES = 3
+# Generated with sun-times-to-code.py -t bin
+SCHEDULE_FILE = "../scripts/out/open_close_times.bin"
+
+
+class ScheduleReply:
+    received = threading.Event()
+    result = 0
+    next_offset = 0
+
+
+SCHEDULE_REPLY = ScheduleReply()
+
 
 class PrintString:
     START = ["Chicken Coop Door Client"]
@@ -153,6 +230,13 @@ class CmdIndex(enum.IntEnum):
     CLOSE_FORCE = 9
 
     REQUEST_TIME = 12
+    REQUEST_WAKEUPS = 13
+    REQUEST_CLOCK = 14
+    REQUEST_SCHEDULE = 15
+    UPLOAD_SCHEDULE = 16
+    REQUEST_COMMANDS = 17
+    REQUEST_TRAVEL = 18
+    REQUEST_SWITCH = 19
 
     SET_MANUAL_TIME = 31
     # Set a (wrong) time at which the door should be closed. Can be used for tests
@@ -184,6 +268,27 @@ class CmdString:
     REQUEST_TIME = [
         "Print current RTC time",
     ]
+    REQUEST_WAKEUPS = [
+        "Print controller wakeups per hour",
+    ]
+    REQUEST_CLOCK = [
+        "Print software clock statistics",
+    ]
+    REQUEST_SCHEDULE = [
+        "Print which open-close table is used",
+    ]
+    UPLOAD_SCHEDULE = [
+        "Upload a new open-close table",
+    ]
+    REQUEST_COMMANDS = [
+        "Print command parser statistics",
+    ]
+    REQUEST_TRAVEL = [
+        "Print the learned door travel time",
+    ]
+    REQUEST_SWITCH = [
+        "Print limit switch debouncing statistics",
+    ]
     UPDATE_TIME_MAN = [
         "Set time manually on the ESP32 controller",
     ]
@@ -211,6 +316,34 @@ CMD_INFO = {
     CmdIndex.NORM_CTRL: [CmdString.NORM_CTRL, PrintString.MOTOR_NORMAL_STR],
     CmdIndex.SET_TIME: [CmdString.SET_TIME, PrintString.SET_TIME],
     CmdIndex.REQUEST_TIME: [CmdString.REQUEST_TIME, "Requesting current time"],
+    CmdIndex.REQUEST_WAKEUPS: [
+        CmdString.REQUEST_WAKEUPS,
+        "Requesting wakeup statistics",
+    ],
+    CmdIndex.REQUEST_CLOCK: [
+        CmdString.REQUEST_CLOCK,
+        "Requesting clock statistics",
+    ],
+    CmdIndex.REQUEST_SCHEDULE: [
+        CmdString.REQUEST_SCHEDULE,
+        "Requesting schedule info",
+    ],
+    CmdIndex.UPLOAD_SCHEDULE: [
+        CmdString.UPLOAD_SCHEDULE,
+        "Uploading open-close table",
+    ],
+    CmdIndex.REQUEST_COMMANDS: [
+        CmdString.REQUEST_COMMANDS,
+        "Requesting command parser statistics",
+    ],
+    CmdIndex.REQUEST_TRAVEL: [
+        CmdString.REQUEST_TRAVEL,
+        "Requesting door travel time",
+    ],
+    CmdIndex.REQUEST_SWITCH: [
+        CmdString.REQUEST_SWITCH,
+        "Requesting limit switch statistics",
+    ],
     CmdIndex.OPEN_PROT: [
         build_motor_ctrl_cmd_strings(False, True),
         PrintString.DOOR_OPEN_STR_PROT,
@@ -259,6 +392,30 @@ def req_handle_cmd(ser: serial.Serial):
         cmd_str = (
             CMD_PATTERN + CommandChars.REQUEST + RequestChars.TIME + CMD_TERMINATION
         )
+    elif request_cmd_num in [CmdIndex.REQUEST_WAKEUPS]:
+        cmd_str = (
+            CMD_PATTERN + CommandChars.REQUEST + RequestChars.WAKEUPS + CMD_TERMINATION
+        )
+    elif request_cmd_num in [CmdIndex.REQUEST_CLOCK]:
+        cmd_str = CMD_PATTERN + CommandChars.REQUEST + RequestChars.CLOCK + CMD_TERMINATION
+    elif request_cmd_num in [CmdIndex.REQUEST_SCHEDULE]:
+        cmd_str = (
+            CMD_PATTERN + CommandChars.REQUEST + RequestChars.SCHEDULE + CMD_TERMINATION
+        )
+    elif request_cmd_num in [CmdIndex.REQUEST_COMMANDS]:
+        cmd_str = (
+            CMD_PATTERN + CommandChars.REQUEST + RequestChars.COMMANDS + CMD_TERMINATION
+        )
+    elif request_cmd_num in [CmdIndex.REQUEST_TRAVEL]:
+        cmd_str = (
+            CMD_PATTERN + CommandChars.REQUEST + RequestChars.TRAVEL + CMD_TERMINATION
+        )
+    elif request_cmd_num in [CmdIndex.REQUEST_SWITCH]:
+        cmd_str = (
+            CMD_PATTERN + CommandChars.REQUEST + RequestChars.SWITCH + CMD_TERMINATION
+        )
+    elif request_cmd_num in [CmdIndex.UPLOAD_SCHEDULE]:
+        upload_schedule(ser)
     elif request_cmd_num in [CmdIndex.NORM_CTRL]:
         cmd = CmdIndex(request_cmd_num)
         print(f"{CMD_INFO[cmd][1]}")
@@ -314,6 +471,57 @@ def req_handle_cmd(ser: serial.Serial):
         ser.write(cmd_str.encode("utf-8"))
 
 
+def handle_schedule_reply(reply: bytes):
+    fields = reply[4:].rstrip("\n".encode()).decode().split(",")
+    SCHEDULE_REPLY.result = int(fields[0])
+    SCHEDULE_REPLY.next_offset = int(fields[1])
+    SCHEDULE_REPLY.received.set()
+
+
+def send_schedule_cmd(ser: serial.Serial, payload: str) -> bool:
+    """Sends a schedule command and waits for the reply. All numbers are sent as lowercase hex,
+    so the payload never contains the command pattern."""
+    for _ in range(SCHEDULE_RETRIES):
+        SCHEDULE_REPLY.received.clear()
+        cmd_str = CMD_PATTERN + CommandChars.SCHEDULE + payload + CMD_TERMINATION
+        ser.write(cmd_str.encode("utf-8"))
+        if SCHEDULE_REPLY.received.wait(SCHEDULE_REPLY_TIMEOUT):
+            return SCHEDULE_REPLY.result == 0
+        print("No reply to schedule command, retrying")
+    return False
+
+
+def upload_schedule(ser: serial.Serial):
+    path = input(f"Schedule file [nothing for {SCHEDULE_FILE}]: ")
+    if path == "":
+        path = SCHEDULE_FILE
+    if not os.path.exists(path):
+        print(f"Schedule file {path} not found")
+        return
+    with open(path, "rb") as f:
+        data = f.read()
+    start = time.time()
+    begin = CMD_SCHEDULE_BEGIN + f"{len(data):08x}{zlib.crc32(data):08x}"
+    if not send_schedule_cmd(ser, begin):
+        print(f"Starting the upload failed with code {SCHEDULE_REPLY.result}")
+        return
+    offset = 0
+    while offset < len(data):
+        chunk = data[offset : offset + SCHEDULE_CHUNK_SIZE]
+        sent = send_schedule_cmd(ser, CMD_SCHEDULE_DATA + f"{offset:08x}" + chunk.hex())
+        if not sent and SCHEDULE_REPLY.next_offset == offset:
+            print(f"Upload failed at offset {offset} with code {SCHEDULE_REPLY.result}")
+            return
+        # A retried chunk might have been written already, so continue where the ESP32 is
+        offset = SCHEDULE_REPLY.next_offset
+        print(f"Uploaded {offset}/{len(data)} bytes", end="\r")
+    print()
+    if not send_schedule_cmd(ser, CMD_SCHEDULE_END):
+        print(f"Activating the schedule failed with code {SCHEDULE_REPLY.result}")
+        return
+    print(f"Uploaded and activated schedule in {time.time() - start:.1f} s")
+
+
 def time_stuttgart() -> datetime:
     stuttgart_tz = pytz.timezone("Europe/Berlin")
     now = datetime.now(stuttgart_tz)
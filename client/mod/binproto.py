@@ -0,0 +1,151 @@
+"""Binary framing of the UART protocol, see chicken-coop-esp/main/binary_frame.h"""
+import binascii
+import enum
+import struct
+from dataclasses import dataclass
+from typing import List, Optional, Tuple
+
+SYNC = b"\xa5\x5a"
+PROTOCOL_VERSION = 1
+HEADER_SIZE = 6
+CRC_SIZE = 2
+
+
+class FrameType(enum.IntEnum):
+    REQUEST = 0x01
+    RESPONSE = 0x02
+    NAK = 0x03
+    EXIT = 0x04
+    TELEMETRY = 0x05
+    LOG = 0x06
+
+
+class NakReason(enum.IntEnum):
+    CRC_ERROR = 0x01
+    LENGTH_ERROR = 0x02
+    INVALID_TYPE = 0x03
+    INVALID_BATCH = 0x04
+    BUSY = 0x05
+
+
+class Result(enum.IntEnum):
+    OK = 0x00
+    INVALID_CMD = 0x01
+    INVALID_ARG = 0x02
+    INVALID_STATE = 0x03
+    FAILED = 0x04
+    REPLY_OVERFLOW = 0x05
+
+
+# See chicken-coop-esp/main/telemetry.h
+TELEMETRY_FORMAT = "<IBBBBIhhB"
+TELEMETRY_FLAG_FORCED_OP = 1 << 0
+TELEMETRY_FLAG_BINARY_MODE = 1 << 1
+
+
+@dataclass
+class Telemetry:
+    uptime_ms: int
+    app_state: int
+    motor_state: int
+    door_switch: int
+    recheck_mode: int
+    motor_runtime_ms: int
+    next_open_minute: int
+    next_close_minute: int
+    flags: int
+
+
+@dataclass
+class Frame:
+    seq: int
+    type: FrameType
+    payload: bytes
+
+
+def crc16(data: bytes) -> int:
+    # CRC-16/CCITT-FALSE
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def decode_telemetry(payload: bytes) -> Telemetry:
+    # Newer firmware might append fields
+    size = struct.calcsize(TELEMETRY_FORMAT)
+    return Telemetry(*struct.unpack(TELEMETRY_FORMAT, payload[:size]))
+
+
+def handshake_cmd(version: int = PROTOCOL_VERSION) -> bytes:
+    return f"CCB{version}\n".encode()
+
+
+def encode_frame(frame_type: FrameType, seq: int, payload: bytes = b"") -> bytes:
+    header = struct.pack("<HBB", len(payload), seq & 0xFF, frame_type)
+    crc = crc16(header + payload)
+    return SYNC + header + payload + struct.pack("<H", crc)
+
+
+def encode_request(seq: int, cmds: List[str]) -> bytes:
+    """Batches ASCII commands, given without the "CC" pattern and the terminator"""
+    payload = b""
+    for cmd in cmds:
+        raw = cmd.encode()
+        payload += bytes([len(raw)]) + raw
+    return encode_frame(FrameType.REQUEST, seq, payload)
+
+
+def decode_records(payload: bytes) -> List[Tuple[Result, bytes]]:
+    records = []
+    offset = 0
+    while offset + 2 <= len(payload):
+        result = Result(payload[offset])
+        length = payload[offset + 1]
+        records.append((result, payload[offset + 2 : offset + 2 + length]))
+        offset += 2 + length
+    return records
+
+
+def decode_commands(payload: bytes) -> Optional[List[bytes]]:
+    cmds = []
+    offset = 0
+    while offset < len(payload):
+        length = payload[offset]
+        cmds.append(payload[offset + 1 : offset + 1 + length])
+        offset += 1 + length
+    if offset != len(payload):
+        return None
+    return cmds
+
+
+class Decoder:
+    """Incremental frame decoder. Bytes outside of frames are skipped."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data: bytes) -> List[Frame]:
+        self.buf += data
+        frames = []
+        while True:
+            start = self.buf.find(SYNC)
+            if start < 0:
+                # Keep a possible first sync byte
+                del self.buf[: max(0, len(self.buf) - 1)]
+                return frames
+            del self.buf[:start]
+            if len(self.buf) < HEADER_SIZE:
+                return frames
+            length, seq, frame_type = struct.unpack_from("<HBB", self.buf, 2)
+            end = HEADER_SIZE + length + CRC_SIZE
+            if len(self.buf) < end:
+                return frames
+            (crc,) = struct.unpack_from("<H", self.buf, end - CRC_SIZE)
+            if crc16(bytes(self.buf[2 : end - CRC_SIZE])) != crc:
+                self.crc_errors += 1
+                # Resynchronize after the sync marker
+                del self.buf[:2]
+                continue
+            frames.append(
+                Frame(seq, frame_type, bytes(self.buf[HEADER_SIZE : end - CRC_SIZE]))
+            )
+            del self.buf[:end]
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Subscribes to the telemetry of the device and prints every received sample."""
+import argparse
+import sys
+import time
+
+import serial
+
+from mod import binproto
+
+APP_STATES = ["START_DELAY", "INIT", "NORMAL", "MANUAL"]
+MOTOR_STATES = ["IDLE", "OPENING", "CLOSING"]
+RECHECK_STATES = ["IDLE", "ARMED", "RETRYING", "RECHECKING"]
+
+
+def minute_str(minute: int) -> str:
+    if minute < 0:
+        return "--:--"
+    return f"{minute // 60:02d}:{minute % 60:02d}"
+
+
+def state_str(names, idx: int) -> str:
+    return names[idx] if idx < len(names) else str(idx)
+
+
+def print_sample(sample: binproto.Telemetry):
+    flags = []
+    if sample.flags & binproto.TELEMETRY_FLAG_FORCED_OP:
+        flags.append("forced")
+    if sample.flags & binproto.TELEMETRY_FLAG_BINARY_MODE:
+        flags.append("binary")
+    print(
+        f"{sample.uptime_ms / 1000:10.1f} s | "
+        f"{state_str(APP_STATES, sample.app_state)} | "
+        f"motor {state_str(MOTOR_STATES, sample.motor_state)} "
+        f"{sample.motor_runtime_ms / 1000:.1f} s | "
+        f"door {'open' if sample.door_switch else 'closed'} | "
+        f"recheck {state_str(RECHECK_STATES, sample.recheck_mode)} | "
+        f"open {minute_str(sample.next_open_minute)} "
+        f"close {minute_str(sample.next_close_minute)} {' '.join(flags)}"
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("port", help="Serial port of the device")
+    parser.add_argument(
+        "-p", "--period", type=int, default=1000, help="Sample period in milliseconds"
+    )
+    args = parser.parse_args()
+    ser = serial.Serial(args.port, baudrate=115200, timeout=1)
+    ser.write(f"CCL{args.period}\n".encode())
+    decoder = binproto.Decoder()
+    last_seq = None
+    dropped = 0
+    try:
+        while True:
+            for frame in decoder.feed(ser.read(max(1, ser.in_waiting))):
+                if frame.type != binproto.FrameType.TELEMETRY:
+                    continue
+                if last_seq is not None:
+                    dropped += (frame.seq - last_seq - 1) & 0xFF
+                last_seq = frame.seq
+                print_sample(binproto.decode_telemetry(frame.payload))
+    except KeyboardInterrupt:
+        ser.write(b"CCL0\n")
+        time.sleep(0.1)
+        print(f"{dropped} samples were dropped", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Formats the deferred log records of the firmware on the host.
+
+Used with CONFIG_DEFERRED_LOG_HOST_DICTIONARY. The firmware writes the records as binary
+frames to the console. This script reads the console output from a serial port or a file,
+prints regular text output as it is and formats the records with the message dictionary
+parsed from chicken-coop-esp/main/dlog_messages.h.
+"""
+import argparse
+import binascii
+import json
+import os
+import re
+import struct
+import sys
+
+MESSAGES_FILE = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)),
+    "../chicken-coop-esp/main/dlog_messages.h",
+)
+SYNC = b"\xa5\x5a"
+FRAME_TYPE_LOG = 0x06
+HEADER_SIZE = 6
+CRC_SIZE = 2
+RECORD_HEADER = "<IHBB"
+LEVEL_CHARS = {"ERROR": "E", "WARN": "W", "INFO": "I", "DEBUG": "D", "VERBOSE": "V"}
+MESSAGE_PATTERN = re.compile(
+    r"X\(\s*(\w+),\s*(\w+),\s*\"([^\"]*)\",\s*((?:\"(?:[^\"\\]|\\.)*\"\s*)+)\)"
+)
+
+
+def load_dictionary(path: str):
+    with open(path) as file:
+        # Join the continuation lines of the macro
+        content = file.read().replace("\\\n", " ")
+    messages = []
+    for match in MESSAGE_PATTERN.finditer(content):
+        # Adjacent string literals are concatenated like in C
+        fmt = "".join(re.findall(r"\"((?:[^\"\\]|\\.)*)\"", match.group(4)))
+        messages.append(
+            {
+                "id": match.group(1),
+                "level": match.group(2),
+                "tag": match.group(3),
+                "fmt": fmt,
+            }
+        )
+    return messages
+
+
+def format_message(fmt: str, args):
+    # The arguments are raw 32-bit values. Signed conversions need the sign restored.
+    conversions = re.findall(r"%[-+ #0-9.]*l*([diucxXs%])", fmt)
+    values = []
+    for conv, arg in zip([c for c in conversions if c != "%"], args):
+        if conv in "di" and arg & 0x80000000:
+            arg -= 1 << 32
+        values.append(arg)
+    py_fmt = re.sub(r"(%[-+ #0-9.]*)l+", r"\1", fmt).replace("%u", "%d")
+    try:
+        return py_fmt % tuple(values)
+    except (TypeError, ValueError):
+        return f"{fmt} {args}"
+
+
+def decode_record(messages, payload: bytes) -> str:
+    timestamp, msg_id, argc, _ = struct.unpack_from(RECORD_HEADER, payload)
+    args = struct.unpack_from(f"<{argc}I", payload, struct.calcsize(RECORD_HEADER))
+    if msg_id >= len(messages):
+        return f"? ({timestamp}) dlog: Unknown message {msg_id} {args}"
+    msg = messages[msg_id]
+    level = LEVEL_CHARS.get(msg["level"], "?")
+    return f"{level} ({timestamp}) {msg['tag']}: {format_message(msg['fmt'], args)}"
+
+
+def process(messages, buf: bytearray, out):
+    """Prints all complete text and frames in the buffer and removes them"""
+    while True:
+        start = buf.find(SYNC)
+        if start < 0:
+            # Keep a possible first sync byte
+            keep = 1 if buf.endswith(SYNC[:1]) else 0
+            out.write(buf[: len(buf) - keep].decode(errors="replace"))
+            del buf[: len(buf) - keep]
+            return
+        out.write(buf[:start].decode(errors="replace"))
+        del buf[:start]
+        if len(buf) < HEADER_SIZE:
+            return
+        length, _, frame_type = struct.unpack_from("<HBB", buf, 2)
+        end = HEADER_SIZE + length + CRC_SIZE
+        if len(buf) < end:
+            return
+        (crc,) = struct.unpack_from("<H", buf, end - CRC_SIZE)
+        if binascii.crc_hqx(bytes(buf[2 : end - CRC_SIZE]), 0xFFFF) != crc:
+            # Not a frame, print the sync bytes as text
+            out.write(buf[:2].decode(errors="replace"))
+            del buf[:2]
+            continue
+        if frame_type == FRAME_TYPE_LOG:
+            out.write(decode_record(messages, bytes(buf[HEADER_SIZE : end - CRC_SIZE])))
+            out.write("\n")
+        del buf[:end]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("source", nargs="?", help="Serial port or file, stdin by default")
+    parser.add_argument("-b", "--baud", type=int, default=115200)
+    parser.add_argument(
+        "-d", "--dict", action="store_true", help="Print the dictionary as JSON"
+    )
+    args = parser.parse_args()
+    messages = load_dictionary(MESSAGES_FILE)
+    if args.dict:
+        print(json.dumps(messages, indent=2))
+        return
+    is_port = args.source is not None and not os.path.isfile(args.source)
+    if args.source is None:
+        source = sys.stdin.buffer
+    elif is_port:
+        import serial
+
+        source = serial.Serial(args.source, baudrate=args.baud, timeout=0.1)
+    else:
+        source = open(args.source, "rb")
+    buf = bytearray()
+    while True:
+        data = source.read(256)
+        if not data:
+            # A serial port read times out, a file or pipe is at its end
+            if is_port:
+                continue
+            break
+        buf += data
+        process(messages, buf, sys.stdout)
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -7,6 +7,7 @@ import copy
 import dataclasses
 import pprint
 import shutil
+import struct
 from datetime import datetime
 from io import FileIO
 
@@ -20,11 +21,17 @@ CSV_FILE_NAME = "open_close_times.csv"
 C_SOURCE_OUTPUT = "open_close_times.cpp"
 C_HEADER_OUTPUT = "open_close_times.h"
 PYTHON_OUTPUT = "open_close_times.py"
+BIN_OUTPUT = "open_close_times.bin"
 C_DEST_ESP = "../chicken-coop-esp/main"
 C_DEST_ARDUINO = "../chicken-coop-arduino/src"
 PY_DEST_RPI = "../chicken-coop-pi"
 MONTH_COMMENT = "Open-Close times specified as a 2D array for each month"
 MONTH_PREFIX = "OC_TIMES_"
+DOY_COMMENT = (
+    "Open-Close times in minutes of the day for each day of a leap year. Use ocTableIndex\n"
+    "// to get the index for a given date"
+)
+DOY_TABLE_NAME = "OC_TIMES_DAY_OF_YEAR"
 
 # Constants
 MONTHS = [
@@ -41,9 +48,12 @@ MONTHS = [
     "NOVEMBER",
     "DECEMBER",
 ]
+# Days per month of a leap year. February 29 is always part of the day-of-year table.
+LEAP_YEAR_MONTH_DAYS = [31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31]
 C_SOURCE_FULL_PATH = os.path.join(OUTPUT, C_SOURCE_OUTPUT)
 C_HEADER_FULL_PATH = os.path.join(OUTPUT, C_HEADER_OUTPUT)
 PYTHON_FULL_OUTPUT = os.path.join(OUTPUT, PYTHON_OUTPUT)
+BIN_FULL_OUTPUT = os.path.join(OUTPUT, BIN_OUTPUT)
 
 
 @dataclasses.dataclass
@@ -66,7 +76,20 @@ def main():
         "Converter script to generate look-up table code for sun times"
     )
     parser.add_argument(
-        "-t", "--type", help="Output code language", choices=["c", "py"], default="c"
+        "-t",
+        "--type",
+        help="Output code language. bin is the packed day-of-year table which can be uploaded "
+        "to the ESP32 with the client",
+        choices=["c", "py", "bin"],
+        default="c",
+    )
+    parser.add_argument(
+        "-f",
+        "--format",
+        help="C table format. doy is a packed day-of-year table of minutes of the day, "
+        "month is the legacy table with hours and minutes for 31 days of each month",
+        choices=["doy", "month"],
+        default="doy",
     )
     parser.add_argument(
         "-c",
@@ -79,18 +102,23 @@ def main():
     print("-- Sun times to code generator --")
     ocm = gen_open_close_map()
     if args.type == "c":
-        gen_c_file(ocm)
+        if args.format == "doy":
+            gen_c_doy_file(ocm)
+        else:
+            gen_c_file(ocm)
     elif args.type == "py":
         gen_py_file(ocm)
+    elif args.type == "bin":
+        gen_bin_file(ocm)
     else:
         print("No supported output code type detected")
         sys.exit(0)
     if args.copy:
-        if args.type == "c":
+        if args.type == "c" and args.format == "doy":
+            cp_file_to_dest(C_HEADER_FULL_PATH, C_DEST_ESP)
+        elif args.type == "c":
             cp_file_to_dest(C_SOURCE_FULL_PATH, C_DEST_ARDUINO)
             cp_file_to_dest(C_HEADER_FULL_PATH, C_DEST_ARDUINO)
-            cp_file_to_dest(C_SOURCE_FULL_PATH, C_DEST_ESP)
-            cp_file_to_dest(C_HEADER_FULL_PATH, C_DEST_ESP)
         elif args.type == "py":
             cp_file_to_dest(PYTHON_FULL_OUTPUT, PY_DEST_RPI)
     print("Done")
@@ -152,6 +180,81 @@ def gen_c_file(ocm):
                 f.write("\n")
 
 
+def gen_c_doy_file(ocm):
+    print(f"Generating {OUTPUT}/{C_HEADER_OUTPUT}")
+    with open(f"{os.path.join(OUTPUT, C_HEADER_OUTPUT)}", "w") as f:
+        print_header_c(f)
+        f.write("\n")
+        f.write("#pragma once\n")
+        f.write("\n")
+        f.write('#include "oc_table.h"\n')
+        f.write("\n")
+        f.write(f"// {DOY_COMMENT}\n")
+        f.write(f"inline constexpr OcTimes {DOY_TABLE_NAME}[OC_TABLE_DAYS] = {{\n")
+        for month_idx, day_info, day_num in gen_day_of_year_list(ocm):
+            open_minutes = day_info.open_hour * 60 + day_info.open_minute
+            close_minutes = day_info.close_hour * 60 + day_info.close_minute
+            f.write(
+                f"    {{{open_minutes}, {close_minutes}}},"
+                f"  // {day_num:02}.{month_idx + 1:02}\n"
+            )
+        f.write("};\n")
+
+
+def gen_bin_file(ocm):
+    """The binary table consists of little endian uint16 open and close minutes for each day
+    of a leap year, which is the layout of the OcTimes table of the ESP32 firmware."""
+    print(f"Generating {BIN_FULL_OUTPUT}")
+    with open(BIN_FULL_OUTPUT, "wb") as f:
+        for _, day_info, _ in gen_day_of_year_list(ocm):
+            open_minutes = day_info.open_hour * 60 + day_info.open_minute
+            close_minutes = day_info.close_hour * 60 + day_info.close_minute
+            f.write(struct.pack("<HH", open_minutes, close_minutes))
+
+
+def gen_day_of_year_list(ocm: dict) -> list:
+    """Returns a list of (month index, day info, day) tuples for each day of a leap year.
+    A missing February 29 is interpolated from February 28 and March 1."""
+    day_list = []
+    last_day_info = None
+    for month_idx in range(0, 12):
+        month_dict = ocm[MONTHS[month_idx]]
+        for day_num in range(1, LEAP_YEAR_MONTH_DAYS[month_idx] + 1):
+            day_info = month_dict.get(str(day_num))
+            if day_info is None and month_idx == 1 and day_num == 29:
+                day_info = interpolate_day_info(
+                    month_dict.get("28"), ocm[MONTHS[2]].get("1")
+                )
+            if day_info is None:
+                day_info = last_day_info
+            day_list.append((month_idx, day_info, day_num))
+            last_day_info = day_info
+    return day_list
+
+
+def interpolate_day_info(before: DayInfo, after: DayInfo) -> DayInfo:
+    if before is None or after is None:
+        return before if after is None else after
+    open_minutes = (
+        before.open_hour * 60
+        + before.open_minute
+        + after.open_hour * 60
+        + after.open_minute
+    ) // 2
+    close_minutes = (
+        before.close_hour * 60
+        + before.close_minute
+        + after.close_hour * 60
+        + after.close_minute
+    ) // 2
+    day_info = DayInfo()
+    day_info.open_hour = open_minutes // 60
+    day_info.open_minute = open_minutes % 60
+    day_info.close_hour = close_minutes // 60
+    day_info.close_minute = close_minutes % 60
+    return day_info
+
+
 def print_open_close_months_definition(f: FileIO):
     f.write("const OcTableWrapper* OPEN_CLOSE_MONTHS[12] = {\n")
     for month_idx in range(0, 12):